@@ -233,6 +233,7 @@ REGISTER_CLASS_NAME(Vector3D,"flash.geom")
 REGISTER_CLASS_NAME(Matrix3D,"flash.geom")
 REGISTER_CLASS_NAME(Orientation3D,"flash.geom")
 REGISTER_CLASS_NAME(PerspectiveProjection,"flash.geom")
+REGISTER_CLASS_NAME(Utils3D,"flash.geom")
 
 //Globalization
 REGISTER_CLASS_NAME(Collator,"flash.globalization")
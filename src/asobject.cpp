@@ -2362,8 +2362,17 @@ void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& string
 
 ASObject *ASObject::describeType(ASWorker* wrk) const
 {
-	pugi::xml_document p;
-	pugi::xml_node root = p.append_child("type");
+	Class_base* prot=getClass();
+	// the description only depends on the class, unless the class definition differs
+	bool cacheable = prot && prot==classdef && getObjectType()!=T_NULL && getObjectType()!=T_UNDEFINED;
+	if (cacheable)
+	{
+		ASObject* res = prot->getCachedDescription(wrk,true);
+		if (res)
+			return res;
+	}
+	pugi::xml_document* p = new pugi::xml_document();
+	pugi::xml_node root = p->append_child("type");
 
 	switch (getObjectType())
 	{
@@ -2378,7 +2387,6 @@ ASObject *ASObject::describeType(ASWorker* wrk) const
 	}
 
 	// type attributes
-	Class_base* prot=getClass();
 	if(prot)
 	{
 		root.append_attribute("name").set_value(prot->getQualifiedClassName(true).raw_buf());
@@ -2396,7 +2404,12 @@ ASObject *ASObject::describeType(ASWorker* wrk) const
 
 	//LOG(LOG_INFO,"describeType:"<< Class<XML>::getInstanceS(getInstanceWorker(),root)->toXMLString_internal());
 
-	return XML::createFromNode(wrk,root);
+	ASObject* res = XML::createFromNode(wrk,root);
+	if (cacheable)
+		prot->setCachedDescription(p,true);
+	else
+		delete p;
+	return res;
 }
 
 tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
@@ -3238,6 +3251,14 @@ bool asAtomHandler::add(asAtom& a, asAtom &v2, ASWorker* wrk, bool forceint)
 	}
 	else if(isString(a) || isString(v2))
 	{
+		if (!forceint && isObject(a) && getObjectNoCheck(a)->is<ASString>() && getObjectNoCheck(a)->isLastRef())
+		{
+			// nothing else references the left operand, so it is appended to in place
+			LOG_CALL("add inplace " << toString(a,wrk) << '+' << toString(v2,wrk));
+			tiny_string sb = toString(v2,wrk);
+			as<ASString>(a)->append(sb);
+			return false;
+		}
 		tiny_string sa = toString(a,wrk);
 		sa += toString(v2,wrk);
 		LOG_CALL("add " << toString(a,wrk) << '+' << toString(v2,wrk));
@@ -3351,6 +3372,14 @@ void asAtomHandler::addreplace(asAtom& ret, ASWorker* wrk, asAtom& v1, asAtom &v
 	}
 	else if(isString(v1) || isString(v2))
 	{
+		if (!forceint && ret.uintval == v1.uintval && isObject(v1) && getObjectNoCheck(v1)->is<ASString>() && getObjectNoCheck(v1)->isLastRef())
+		{
+			// ret = ret + v2 and nothing else references ret, so it is appended to in place
+			LOG_CALL("add replace inplace " << toString(v1,wrk) << '+' << toString(v2,wrk));
+			tiny_string sb = toString(v2,wrk);
+			as<ASString>(v1)->append(sb);
+			return;
+		}
 		tiny_string sa = toString(v1,wrk);
 		sa += toString(v2,wrk);
 		LOG_CALL("add replace " << toString(v1,wrk) << '+' << toString(v2,wrk));
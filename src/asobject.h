@@ -930,8 +930,10 @@ protected:
 		{
 			if (!getCached())
 			{
-				assert(getWorker() == this->getInstanceWorker());
-				dodestruct = !objfreelist->pushObjectToFreeList(this);
+				// objects created for the worker by other threads (e.g. events from the input thread) may also be released there,
+				// the freelist must only be accessed from the worker's thread
+				if (getWorker() == this->getInstanceWorker())
+					dodestruct = !objfreelist->pushObjectToFreeList(this);
 			}
 			else
 				dodestruct = false;
@@ -0,0 +1,191 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/benchmark.h"
+#include "backends/tracing.h"
+#include "swf.h"
+#include "backends/input.h"
+#include "scripting/flash/display/CachedSurfaceManager.h"
+#include "logger.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#ifndef _WIN32
+#	include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+#	include <malloc.h>
+#endif
+
+using namespace lightspark;
+using namespace std;
+
+BenchmarkRunner::BenchmarkRunner(SystemState* s, uint32_t frames, const tiny_string& inputScript):
+	m_sys(s),frameCount(frames),virtualTime(0),frameInterval(0),started(false)
+{
+	frameTimes.reserve(frameCount);
+	if (!inputScript.empty())
+		loadInputScript(inputScript);
+}
+
+void BenchmarkRunner::loadInputScript(const tiny_string& filename)
+{
+	ifstream f(filename.raw_buf());
+	if (!f)
+	{
+		LOG(LOG_ERROR,"Benchmark: unable to open input script "<<filename);
+		return;
+	}
+	bool buttonDown=false;
+	string line;
+	uint32_t lineNumber=0;
+	while (getline(f,line))
+	{
+		lineNumber++;
+		if (line.empty() || line[0]=='#')
+			continue;
+		istringstream s(line);
+		uint32_t frame;
+		string type;
+		if (!(s >> frame >> type))
+		{
+			LOG(LOG_ERROR,"Benchmark: invalid input script line "<<lineNumber);
+			continue;
+		}
+		SDL_Event ev;
+		SDL_zero(ev);
+		int32_t x=0, y=0;
+		if (type=="mousemove" && (s >> x >> y))
+		{
+			ev.type=SDL_MOUSEMOTION;
+			ev.motion.x=x;
+			ev.motion.y=y;
+			ev.motion.state=buttonDown ? SDL_PRESSED : SDL_RELEASED;
+		}
+		else if ((type=="mousedown" || type=="mouseup") && (s >> x >> y))
+		{
+			buttonDown = type=="mousedown";
+			ev.type=buttonDown ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+			ev.button.button=SDL_BUTTON_LEFT;
+			ev.button.state=buttonDown ? SDL_PRESSED : SDL_RELEASED;
+			ev.button.clicks=1;
+			ev.button.x=x;
+			ev.button.y=y;
+		}
+		else if ((type=="keydown" || type=="keyup") && (s >> x))
+		{
+			ev.type=type=="keydown" ? SDL_KEYDOWN : SDL_KEYUP;
+			ev.key.state=type=="keydown" ? SDL_PRESSED : SDL_RELEASED;
+			ev.key.keysym.sym=x;
+			ev.key.keysym.scancode=SDL_GetScancodeFromKey(x);
+			ev.key.keysym.mod=KMOD_NONE;
+		}
+		else
+		{
+			LOG(LOG_ERROR,"Benchmark: invalid input script line "<<lineNumber<<": "<<line);
+			continue;
+		}
+		inputEvents.insert(make_pair(frame,ev));
+	}
+	LOG(LOG_INFO,"Benchmark: "<<inputEvents.size()<<" input events loaded");
+}
+
+void BenchmarkRunner::startFrames(uint32_t interval)
+{
+	if (started)
+		return;
+	started=true;
+	frameInterval=uint64_t(interval)*1000;
+	if (!Tracer::enabled)
+		Tracer::start(m_sys);
+	m_sys->addJob(this);
+}
+
+void BenchmarkRunner::playbackInput(uint32_t frame)
+{
+	auto range = inputEvents.equal_range(frame);
+	for (auto it = range.first; it != range.second; it++)
+		m_sys->getInputThread()->handleEvent(&it->second);
+}
+
+void BenchmarkRunner::execute()
+{
+	Tracer::setThreadName("Benchmark");
+	LOG(LOG_INFO,"Benchmark: running "<<frameCount<<" frames");
+	uint64_t benchmarkStart=Tracer::now();
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		if (threadAborting || m_sys->isShuttingDown())
+			break;
+		playbackInput(frame);
+		uint64_t start=Tracer::now();
+		// tick() returns when the vm has handled all events of the frame
+		m_sys->tick();
+		frameTimes.push_back(Tracer::now()-start);
+		virtualTime += frameInterval;
+	}
+	printReport(Tracer::now()-benchmarkStart);
+	m_sys->setShutdownFlag();
+}
+
+void BenchmarkRunner::printReport(uint64_t totalTime)
+{
+	ostringstream out;
+	out << fixed << setprecision(3);
+	out << "benchmark: " << frameTimes.size() << " frames in " << totalTime/1000.0 << " ms" << endl;
+	if (!frameTimes.empty())
+	{
+		vector<uint64_t> sorted(frameTimes);
+		sort(sorted.begin(),sorted.end());
+		auto percentile = [&sorted](uint32_t p) { return sorted[min(size_t(sorted.size()*p/100),sorted.size()-1)]/1000.0; };
+		out << "frame time ms: min " << sorted.front()/1000.0
+			<< " p50 " << percentile(50)
+			<< " p90 " << percentile(90)
+			<< " p95 " << percentile(95)
+			<< " p99 " << percentile(99)
+			<< " max " << sorted.back()/1000.0 << endl;
+	}
+	map<string,TraceTotal> totals;
+	Tracer::getTotals(totals);
+	for (auto it = totals.begin(); it != totals.end(); it++)
+		out << "phase " << it->first << ": " << it->second.count << " spans, " << it->second.time/1000.0 << " ms" << endl;
+	CachedSurfaceStats cacheStats;
+	m_sys->cachedSurfaceManager->getStats(cacheStats);
+	out << "cached bitmaps: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+		<< cacheStats.evictions << " evictions, " << cacheStats.count << " in use (" << cacheStats.bytes/1024 << " KB)" << endl;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 mi = mallinfo2();
+	out << "heap in use: " << (mi.uordblks+mi.hblkhd)/1024 << " KB" << endl;
+#endif
+#ifndef _WIN32
+	rusage usage;
+	if (getrusage(RUSAGE_SELF,&usage)==0)
+	{
+		// ru_maxrss is in bytes on macOS and in kilobytes everywhere else
+#ifdef __APPLE__
+		out << "peak RSS: " << usage.ru_maxrss/1024 << " KB" << endl;
+#else
+		out << "peak RSS: " << usage.ru_maxrss << " KB" << endl;
+#endif
+	}
+#endif
+	cout << out.str() << flush;
+}
@@ -0,0 +1,71 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_BENCHMARK_H
+#define BACKENDS_BENCHMARK_H 1
+
+#include "compat.h"
+#include "threading.h"
+#include "tiny_string.h"
+#include <atomic>
+#include <map>
+#include <vector>
+#include <SDL2/SDL.h>
+
+namespace lightspark
+{
+
+class SystemState;
+
+/*
+ * Runs the frames of the main clip back to back instead of on the frame timer.
+ * getTimer() follows a virtual clock that advances by one frame interval per frame,
+ * so the content behaves as if it was running at its nominal frame rate.
+ * Input can be played back from a script with one event per line:
+ *   <frame> mousemove|mousedown|mouseup <x> <y>
+ *   <frame> keydown|keyup <SDL keycode>
+ * Lines starting with '#' are ignored. At the end a report with frame time
+ * percentiles, per phase times and memory usage is printed and the player is shut down.
+ */
+class BenchmarkRunner: public IThreadJob
+{
+private:
+	SystemState* m_sys;
+	uint32_t frameCount;
+	std::multimap<uint32_t,SDL_Event> inputEvents;
+	std::vector<uint64_t> frameTimes;
+	// virtual time in microseconds since start
+	std::atomic<uint64_t> virtualTime;
+	uint64_t frameInterval;
+	bool started;
+	void loadInputScript(const tiny_string& filename);
+	void playbackInput(uint32_t frame);
+	void printReport(uint64_t totalTime);
+public:
+	BenchmarkRunner(SystemState* s, uint32_t frames, const tiny_string& inputScript);
+	// called instead of adding the SystemState to the frame timer
+	void startFrames(uint32_t interval);
+	// milliseconds of virtual time elapsed since the start of the benchmark
+	uint64_t getVirtualTime() const { return virtualTime/1000; }
+	void execute() override;
+	void jobFence() override {}
+};
+
+}
+#endif /* BACKENDS_BENCHMARK_H */
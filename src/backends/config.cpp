@@ -85,7 +85,7 @@ Config::Config():
 	//DEFAULT SETTINGS
 	defaultCacheDirectory((string) g_get_user_cache_dir() + G_DIR_SEPARATOR_S + "lightspark"),
 	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),
-	renderingEnabled(true)
+	renderingEnabled(true),cacheAsBitmapBudget(128*1024*1024),cacheAsBitmapIntegerScale(false)
 {
 #ifdef _WIN32
 	const char* exePath = getExectuablePath();
@@ -205,6 +205,12 @@ void Config::handleEntry()
 	//Rendering
 	if(group == "rendering" && key == "enabled")
 		renderingEnabled = atoi(value.c_str());
+	//Memory for bitmaps of objects cached as bitmap, in megabytes
+	else if(group == "rendering" && key == "cacheasbitmap_budget")
+		cacheAsBitmapBudget = uint64_t(atoi(value.c_str()))*1024*1024;
+	//Reuse cached bitmaps for integer scale factors
+	else if(group == "rendering" && key == "cacheasbitmap_integerscale")
+		cacheAsBitmapIntegerScale = atoi(value.c_str());
 	//Cache directory
 	else if(group == "cache" && key == "directory")
 		cacheDirectory = value;
@@ -51,6 +51,10 @@ namespace lightspark
 
 		//Specifies if rendering should be done
 		bool renderingEnabled;
+		//Memory in bytes for bitmaps of objects cached as bitmap, default=128MB
+		uint64_t cacheAsBitmapBudget;
+		//Specifies if a cached bitmap is reused when its object is scaled by an integer factor, default=false
+		bool cacheAsBitmapIntegerScale;
 		Config();
 		~Config();
 	public:
@@ -64,6 +68,8 @@ namespace lightspark
 		const std::string& getGnashPath() const { return gnashPath; }
 
 		bool isRenderingEnabled() const { return renderingEnabled; }
+		uint64_t getCacheAsBitmapBudget() const { return cacheAsBitmapBudget; }
+		bool getCacheAsBitmapIntegerScale() const { return cacheAsBitmapIntegerScale; }
 	};
 }
 
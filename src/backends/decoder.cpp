@@ -25,6 +25,7 @@
 #include "platforms/fastpaths.h"
 #include "swf.h"
 #include "backends/rendering.h"
+#include "backends/tracing.h"
 #include "SDL2/SDL_mixer.h"
 #include "scripting/class.h"
 #include "scripting/flash/net/flashnet.h"
@@ -427,6 +428,7 @@ bool FFMpegVideoDecoder::decodeData(uint8_t* data, uint32_t datalen, uint32_t ti
 {
 	if(datalen==0)
 		return false;
+	TraceSpan span("decode","decodeVideo");
 #if defined HAVE_AVCODEC_SEND_PACKET && defined HAVE_AVCODEC_RECEIVE_FRAME
 	AVPacket* pkt = av_packet_alloc();
 	if (!pkt)
@@ -974,6 +976,7 @@ bool FFMpegAudioDecoder::fillDataAndCheckValidity()
 
 uint32_t FFMpegAudioDecoder::decodeData(uint8_t* data, int32_t datalen, uint32_t time)
 {
+	TraceSpan span("decode","decodeAudio");
 #if defined HAVE_AVCODEC_SEND_PACKET && defined HAVE_AVCODEC_RECEIVE_FRAME
 	AVPacket* pkt = av_packet_alloc();
 	if (!pkt)
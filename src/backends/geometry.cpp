@@ -20,6 +20,7 @@
 #include <fstream>
 #include <cmath>
 #include <algorithm>
+#include <cstring>
 #include "swftypes.h"
 #include "logger.h"
 #include "backends/geometry.h"
@@ -30,6 +31,56 @@
 using namespace std;
 using namespace lightspark;
 
+void TokenBuffer::release()
+{
+	if (storage && ATOMIC_DECREMENT(storage->refcount)==0)
+		delete storage;
+	storage=nullptr;
+}
+
+void TokenBuffer::detach(uint32_t mincapacity)
+{
+	Storage* s = new Storage(max(mincapacity,max(uint32_t(64),len*2)));
+	if (len)
+		memcpy(s->data,storage->data,len*sizeof(uint64_t));
+	s->used=len;
+	release();
+	storage=s;
+}
+
+TokenBuffer& TokenBuffer::operator=(const TokenBuffer& o)
+{
+	if (o.storage)
+		++o.storage->refcount;
+	release();
+	storage=o.storage;
+	len=o.len;
+	return *this;
+}
+
+TokenBuffer& TokenBuffer::operator=(TokenBuffer&& o)
+{
+	if (this != &o)
+	{
+		release();
+		storage=o.storage;
+		len=o.len;
+		o.storage=nullptr;
+		o.len=0;
+	}
+	return *this;
+}
+
+void TokenBuffer::clear()
+{
+	// the storage is kept if it isn't shared, so it can be filled again without reallocating
+	if (storage && storage->refcount==1)
+		storage->used=0;
+	else
+		release();
+	len=0;
+}
+
 bool ShapesBuilder::isOutlineEmpty(const std::vector<ShapePathSegment>& outline)
 {
 	return outline.empty();
@@ -21,6 +21,7 @@
 
 #include "compat.h"
 #include "swftypes.h"
+#include "backends/trianglemesh.h"
 #include <list>
 #include <vector>
 #include <map>
@@ -63,7 +64,7 @@ public:
 	}
 };
 
-enum GEOM_TOKEN_TYPE { STRAIGHT=0, CURVE_QUADRATIC, MOVE, SET_FILL, SET_STROKE, CLEAR_FILL, CLEAR_STROKE, CURVE_CUBIC, FILL_KEEP_SOURCE, FILL_TRANSFORM_TEXTURE };
+enum GEOM_TOKEN_TYPE { STRAIGHT=0, CURVE_QUADRATIC, MOVE, SET_FILL, SET_STROKE, CLEAR_FILL, CLEAR_STROKE, CURVE_CUBIC, FILL_KEEP_SOURCE, FILL_TRANSFORM_TEXTURE, FILL_TRIANGLE_MESH };
 
 struct GeomToken
 {
@@ -77,6 +78,7 @@ struct GeomToken
 		} vec;
 		const FILLSTYLE*  fillStyle; // make sure the pointer is valid until rendering is done
 		const LINESTYLE2* lineStyle; // make sure the pointer is valid until rendering is done
+		const TriangleMesh* mesh; // kept alive by tokensVector::meshes
 		number_t value;
 		uint64_t uval;// this is used to have direct access to the value as it is stored in a vector<uint64_t> for performance
 	};
@@ -93,6 +95,7 @@ struct GeomToken
 	}
 	GeomToken(const FILLSTYLE& fs):fillStyle(&fs) {}
 	GeomToken(const LINESTYLE2& ls):lineStyle(&ls) {}
+	GeomToken(const TriangleMesh& m):mesh(&m) {}
 	GeomToken(number_t val):value(val) {}
 	GeomToken(const Vector2& _vec)
 	{
@@ -101,10 +104,75 @@ struct GeomToken
 	}
 };
 
+/*
+ * Buffer of geometry tokens that can only be appended to or cleared.
+ * Copies share the same storage, so passing tokens from Graphics to the
+ * owning DisplayObject and on to the renderer doesn't copy them.
+ * The copy that has the most tokens appends in place, the other copies
+ * still only see the tokens that existed when they were made.
+ * Appending to any other copy, or clearing a shared one, detaches it first.
+ */
+class TokenBuffer
+{
+private:
+	struct Storage
+	{
+		ATOMIC_INT32(refcount);
+		// number of valid tokens, only a copy with exactly this size may append in place
+		std::atomic<uint32_t> used;
+		uint32_t capacity;
+		uint64_t* data;
+		Storage(uint32_t _capacity):refcount(1),used(0),capacity(_capacity),data(new uint64_t[_capacity]) {}
+		~Storage() { delete[] data; }
+	};
+	Storage* storage;
+	uint32_t len;
+	void release();
+	// moves the tokens to new storage with room for at least mincapacity tokens
+	void detach(uint32_t mincapacity);
+public:
+	typedef const uint64_t* const_iterator;
+	TokenBuffer():storage(nullptr),len(0) {}
+	TokenBuffer(const TokenBuffer& o):storage(o.storage),len(o.len)
+	{
+		if (storage)
+			++storage->refcount;
+	}
+	TokenBuffer(TokenBuffer&& o):storage(o.storage),len(o.len)
+	{
+		o.storage=nullptr;
+		o.len=0;
+	}
+	~TokenBuffer() { release(); }
+	TokenBuffer& operator=(const TokenBuffer& o);
+	TokenBuffer& operator=(TokenBuffer&& o);
+	void push_back(uint64_t token)
+	{
+		uint32_t expected=len;
+		if (!storage || len==storage->capacity || !storage->used.compare_exchange_strong(expected,len+1))
+		{
+			detach(len+1);
+			storage->used=len+1;
+		}
+		storage->data[len++]=token;
+	}
+	void emplace_back(uint64_t token) { push_back(token); }
+	void clear();
+	uint32_t size() const { return len; }
+	bool empty() const { return len==0; }
+	uint64_t operator[](uint32_t i) const { return storage->data[i]; }
+	const_iterator begin() const { return storage ? storage->data : nullptr; }
+	const_iterator end() const { return storage ? storage->data+len : nullptr; }
+	// true if both copies contain the same tokens because they share the storage
+	bool sameTokens(const TokenBuffer& o) const { return storage==o.storage && len==o.len; }
+};
+
 struct tokensVector
 {
-	std::vector<uint64_t> filltokens;
-	std::vector<uint64_t> stroketokens;
+	TokenBuffer filltokens;
+	TokenBuffer stroketokens;
+	// meshes referenced by FILL_TRIANGLE_MESH tokens
+	std::vector<_R<TriangleMesh>> meshes;
 	RECT boundsRect;
 	bool canRenderToGL;
 	tokensVector():canRenderToGL(false) {}
@@ -112,6 +180,7 @@ struct tokensVector
 	{
 		filltokens.clear();
 		stroketokens.clear();
+		meshes.clear();
 		canRenderToGL=false;
 	}
 	uint32_t size() const
@@ -26,6 +26,7 @@
 #include "exceptions.h"
 #include "backends/rendering.h"
 #include "backends/config.h"
+#include "backends/tracing.h"
 #include "compat.h"
 #include "scripting/flash/geom/flashgeom.h"
 #include "scripting/flash/text/flashtext.h"
@@ -298,9 +299,9 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	int tokentype = 1;
 	while (tokentype)
 	{
-		std::vector<uint64_t>::const_iterator it;
-		std::vector<uint64_t>::const_iterator itbegin;
-		std::vector<uint64_t>::const_iterator itend;
+		TokenBuffer::const_iterator it;
+		TokenBuffer::const_iterator itbegin;
+		TokenBuffer::const_iterator itend;
 		switch(tokentype)
 		{
 			case 1:
@@ -536,6 +537,25 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 					cairo_pattern_set_matrix(pattern, &origmat);
 					break;
 				}
+				case FILL_TRIANGLE_MESH:
+				{
+					GeomToken p1(*(++it),false);
+					if(skipPaint)
+					{
+						const TriangleMesh* mesh = p1.mesh;
+						for (uint32_t i = 0; i+2 < mesh->indices.size(); i+=3)
+						{
+							cairo_move_to(cr, mesh->positions[2*mesh->indices[i]], mesh->positions[2*mesh->indices[i]+1]);
+							cairo_line_to(cr, mesh->positions[2*mesh->indices[i+1]], mesh->positions[2*mesh->indices[i+1]+1]);
+							cairo_line_to(cr, mesh->positions[2*mesh->indices[i+2]], mesh->positions[2*mesh->indices[i+2]+1]);
+							cairo_close_path(cr);
+							empty = false;
+						}
+						break;
+					}
+					drawTriangleMesh(cr, *p1.mesh, isMask);
+					break;
+				}
 				default:
 					assert(false);
 			}
@@ -554,6 +574,63 @@ bool CairoTokenRenderer::cairoPathFromTokens(cairo_t* cr, const tokensVector& to
 	return empty;
 }
 
+void CairoTokenRenderer::drawTriangleMesh(cairo_t* cr, const TriangleMesh& mesh, bool isMask)
+{
+	cairo_surface_t* target = cairo_get_target(cr);
+	if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE)
+		return;
+	number_t xmin = std::numeric_limits<double>::infinity();
+	number_t ymin = std::numeric_limits<double>::infinity();
+	number_t xmax = -std::numeric_limits<double>::infinity();
+	number_t ymax = -std::numeric_limits<double>::infinity();
+	mesh.getBounds(xmin,xmax,ymin,ymax);
+	if (xmin > xmax || ymin > ymax)
+		return;
+	MATRIX m;
+	cairo_get_matrix(cr, &m);
+
+	// only the part of the target covered by the mesh is rasterized
+	number_t dxmin = std::numeric_limits<double>::infinity();
+	number_t dymin = std::numeric_limits<double>::infinity();
+	number_t dxmax = -std::numeric_limits<double>::infinity();
+	number_t dymax = -std::numeric_limits<double>::infinity();
+	number_t cx[4] = { xmin, xmax, xmin, xmax };
+	number_t cy[4] = { ymin, ymin, ymax, ymax };
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		number_t x, y;
+		m.multiply2D(cx[i],cy[i],x,y);
+		dxmin = std::min(dxmin,x);
+		dxmax = std::max(dxmax,x);
+		dymin = std::min(dymin,y);
+		dymax = std::max(dymax,y);
+	}
+	if (!(dxmin <= dxmax && dymin <= dymax))
+		return;
+	int32_t x0 = std::max(0,int32_t(floor(std::max(dxmin,-1.0))));
+	int32_t y0 = std::max(0,int32_t(floor(std::max(dymin,-1.0))));
+	int32_t x1 = std::min(cairo_image_surface_get_width(target),int32_t(ceil(std::min(dxmax,1e6))));
+	int32_t y1 = std::min(cairo_image_surface_get_height(target),int32_t(ceil(std::min(dymax,1e6))));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	cairo_surface_t* tmp = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, x1-x0, y1-y0);
+	cairo_surface_flush(tmp);
+	m.x0 -= x0;
+	m.y0 -= y0;
+	mesh.rasterize(cairo_image_surface_get_data(tmp), x1-x0, y1-y0, cairo_image_surface_get_stride(tmp), m, isMask);
+	cairo_surface_mark_dirty(tmp);
+
+	// paint with the device transformation, so the result is still clipped by hard masks
+	cairo_save(cr);
+	cairo_identity_matrix(cr);
+	cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+	cairo_set_source_surface(cr, tmp, x0, y0);
+	cairo_paint(cr);
+	cairo_restore(cr);
+	cairo_surface_destroy(tmp);
+}
+
 void CairoRenderer::cairoClean(cairo_t* cr)
 {
 	cairo_set_source_rgba(cr, 0, 0, 0, 0);
@@ -1020,6 +1097,7 @@ AsyncDrawJob::~AsyncDrawJob()
 
 void AsyncDrawJob::execute()
 {
+	TraceSpan span("render","rasterize");
 	owner->startDrawJob();
 	if(!threadAborting)
 		surfaceBytes=drawable->getPixelBuffer(&isBufferOwner);
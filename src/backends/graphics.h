@@ -127,6 +127,17 @@ public:
 	*/
 	virtual uint8_t* upload(bool refresh)=0;
 	virtual TextureChunk& getTexture()=0;
+	/*
+		Get the part of the content that has changed since the last upload, by default the whole content
+		returns false if there is nothing to upload
+	*/
+	virtual bool getUploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h)
+	{
+		x=0;
+		y=0;
+		sizeNeeded(w,h);
+		return true;
+	}
 	/*
 		Signal the completion of the upload to the texture
 		NOTE: fence may be called on shutdown even if the upload has not happen, so be ready for this event
@@ -321,6 +332,8 @@ private:
 	static cairo_pattern_t* FILLSTYLEToCairo(const FILLSTYLE& style, double scaleCorrection, bool isMask);
 	static bool cairoPathFromTokens(cairo_t* cr, const tokensVector &tokens, double scaleCorrection, bool skipFill, bool isMask, number_t xstart, number_t ystart, int* starttoken=nullptr);
 	static void quadraticBezier(cairo_t* cr, double control_x, double control_y, double end_x, double end_y);
+	// rasterizes the mesh with the current transformation and paints it onto the target of cr
+	static void drawTriangleMesh(cairo_t* cr, const TriangleMesh& mesh, bool isMask);
 	/*
 	   The tokens to be drawn
 	*/
@@ -28,6 +28,13 @@ extern "C" {
 
 #include <csetjmp>
 #include "backends/image.h"
+#include "backends/pixelops.h"
+#include "backends/tracing.h"
+#include <zlib.h>
+#include <map>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace lightspark
 {
@@ -193,6 +200,7 @@ uint8_t* ImageDecoder::decodeJPEG(std::istream& str, uint32_t* width, uint32_t*
 
 uint8_t* ImageDecoder::decodeJPEGImpl(jpeg_source_mgr *src, jpeg_source_mgr *headerTables, uint32_t* width, uint32_t* height, bool* hasAlpha)
 {
+	TraceSpan span("decode","decodeJPEG");
 	struct jpeg_decompress_struct cinfo;
 	struct error_mgr err;
 
@@ -322,6 +330,7 @@ uint8_t* ImageDecoder::decodePNG(std::istream& str, uint32_t* width, uint32_t* h
 
 uint8_t* ImageDecoder::decodePNGImpl(png_structp pngPtr, uint32_t* width, uint32_t* height, bool* hasAlpha)
 {
+	TraceSpan span("decode","decodePNG");
 	png_bytep* rowPtrs = nullptr;
 	uint8_t* outData = nullptr;
 	png_infop infoPtr = png_create_info_struct(pngPtr);
@@ -443,4 +452,434 @@ uint8_t* ImageDecoder::decodePalette(uint8_t* pixels, uint32_t width, uint32_t h
 	return outData;
 }
 
+
+// the encoders write rows in this byte order: red, green, blue and, for 4 bytes per pixel, straight alpha
+static void convertRow(const uint8_t* src, uint8_t* dst, uint32_t width, ENCODER_PIXEL_FORMAT format, uint32_t bpp, uint32_t* tmp)
+{
+	if (format == ENCODER_RGB24)
+	{
+		if (bpp == 3)
+		{
+			memcpy(dst,src,width*3);
+			return;
+		}
+		for (uint32_t x = 0; x < width; x++)
+		{
+			memcpy(dst+x*4,src+x*3,3);
+			dst[x*4+3] = 0xff;
+		}
+		return;
+	}
+	PixelOps::unpremultiply(tmp,(const uint32_t*)src,width);
+	for (uint32_t x = 0; x < width; x++)
+	{
+		uint32_t p = tmp[x];
+		dst[0] = (p>>16)&0xff;
+		dst[1] = (p>>8)&0xff;
+		dst[2] = p&0xff;
+		if (bpp == 4)
+			dst[3] = p>>24;
+		dst += bpp;
+	}
+}
+
+static inline uint8_t paethPredictor(uint8_t a, uint8_t b, uint8_t c)
+{
+	int p = a+b-c;
+	int pa = abs(p-a);
+	int pb = abs(p-b);
+	int pc = abs(p-c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+// predictor of PNG filter type (0 none, 1 sub, 2 up, 3 average, 4 paeth)
+static inline uint8_t pngPredictor(uint32_t type, uint8_t left, uint8_t up, uint8_t upleft)
+{
+	switch (type)
+	{
+		case 1:
+			return left;
+		case 2:
+			return up;
+		case 3:
+			return (left+up)>>1;
+		case 4:
+			return paethPredictor(left,up,upleft);
+		default:
+			return 0;
+	}
+}
+
+#ifdef __SSE2__
+static inline __m128i paethPredictorSSE2(__m128i a, __m128i b, __m128i c)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i res[2];
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		__m128i a16 = i ? _mm_unpackhi_epi8(a,zero) : _mm_unpacklo_epi8(a,zero);
+		__m128i b16 = i ? _mm_unpackhi_epi8(b,zero) : _mm_unpacklo_epi8(b,zero);
+		__m128i c16 = i ? _mm_unpackhi_epi8(c,zero) : _mm_unpacklo_epi8(c,zero);
+		// pa = |b-c|, pb = |a-c|, pc = |a+b-2c|
+		__m128i bc = _mm_sub_epi16(b16,c16);
+		__m128i ac = _mm_sub_epi16(a16,c16);
+		__m128i abc = _mm_add_epi16(bc,ac);
+		__m128i pa = _mm_max_epi16(bc,_mm_sub_epi16(zero,bc));
+		__m128i pb = _mm_max_epi16(ac,_mm_sub_epi16(zero,ac));
+		__m128i pc = _mm_max_epi16(abc,_mm_sub_epi16(zero,abc));
+		__m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa,pb),_mm_cmpgt_epi16(pa,pc));
+		__m128i useC = _mm_cmpgt_epi16(pb,pc);
+		__m128i bOrC = _mm_or_si128(_mm_and_si128(useC,c16),_mm_andnot_si128(useC,b16));
+		res[i] = _mm_or_si128(_mm_and_si128(notA,bOrC),_mm_andnot_si128(notA,a16));
+	}
+	return _mm_packus_epi16(res[0],res[1]);
+}
+#endif
+
+/*
+ * Writes the row filtered with filter type to out and returns the sum of the filtered bytes
+ * as signed values, the measure libpng uses to choose the filter of a row
+ */
+static uint32_t filterPNGRow(uint32_t type, const uint8_t* cur, const uint8_t* prev, uint32_t len, uint32_t bpp, uint8_t* out)
+{
+	uint32_t cost = 0;
+	uint32_t i = 0;
+	// the first pixel has no left neighbour
+	for (; i < bpp && i < len; i++)
+	{
+		out[i] = cur[i]-pngPredictor(type,0,prev[i],0);
+		cost += abs(int8_t(out[i]));
+	}
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i sum = zero;
+	for (; i+16 <= len; i+=16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(cur+i));
+		__m128i left = _mm_loadu_si128((const __m128i*)(cur+i-bpp));
+		__m128i up = _mm_loadu_si128((const __m128i*)(prev+i));
+		__m128i pred;
+		switch (type)
+		{
+			case 1:
+				pred = left;
+				break;
+			case 2:
+				pred = up;
+				break;
+			case 3:
+				// _mm_avg_epu8 rounds up
+				pred = _mm_sub_epi8(_mm_avg_epu8(left,up),_mm_and_si128(_mm_xor_si128(left,up),one));
+				break;
+			case 4:
+				pred = paethPredictorSSE2(left,up,_mm_loadu_si128((const __m128i*)(prev+i-bpp)));
+				break;
+			default:
+				pred = zero;
+				break;
+		}
+		__m128i r = _mm_sub_epi8(x,pred);
+		_mm_storeu_si128((__m128i*)(out+i),r);
+		// |r| as signed byte is the smaller one of r and -r as unsigned bytes
+		sum = _mm_add_epi64(sum,_mm_sad_epu8(_mm_min_epu8(r,_mm_sub_epi8(zero,r)),zero));
+	}
+	cost += _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum,8));
+#endif
+	for (; i < len; i++)
+	{
+		out[i] = cur[i]-pngPredictor(type,cur[i-bpp],prev[i],prev[i-bpp]);
+		cost += abs(int8_t(out[i]));
+	}
+	return cost;
+}
+
+static void writeUInt32BE(std::vector<uint8_t>& out, uint32_t v)
+{
+	out.push_back(v>>24);
+	out.push_back((v>>16)&0xff);
+	out.push_back((v>>8)&0xff);
+	out.push_back(v&0xff);
+}
+
+static void writePNGChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, uint32_t len)
+{
+	writeUInt32BE(out,len);
+	out.insert(out.end(),type,type+4);
+	out.insert(out.end(),data,data+len);
+	uLong crc = crc32(crc32(0,Z_NULL,0),(const Bytef*)type,4);
+	// crc32 returns the initial value for a null buffer
+	if (len)
+		crc = crc32(crc,data,len);
+	writeUInt32BE(out,crc);
+}
+
+namespace
+{
+struct PNGBand
+{
+	std::vector<uint8_t> data;
+	uLong adler;
+	uint32_t length;
+	bool success;
+};
+}
+
+bool ImageEncoder::encodePNG(SystemState* sys, const uint8_t* pixels, uint32_t width, uint32_t height, int32_t stride,
+			     ENCODER_PIXEL_FORMAT format, bool alpha, bool fastCompression, std::vector<uint8_t>& out)
+{
+	TraceSpan span("encode","encodePNG");
+	if (width == 0 || height == 0)
+		return false;
+	const uint32_t bpp = alpha ? 4 : 3;
+	const uint32_t len = width*bpp;
+	const uint32_t rowBytes = len+1;
+
+	// every row is filtered independently, the previous row is converted again by each band
+	std::vector<uint8_t> filtered(size_t(rowBytes)*height);
+	PixelOps::forEachRow(sys,height,width,[&](uint32_t first, uint32_t last)
+	{
+		std::vector<uint8_t> rows(len*2+16,0);
+		std::vector<uint8_t> candidate(len);
+		std::vector<uint32_t> tmp(width);
+		uint8_t* prev = &rows[0];
+		uint8_t* cur = &rows[len];
+		if (first > 0)
+			convertRow(pixels+int64_t(first-1)*stride,prev,width,format,bpp,&tmp[0]);
+		for (uint32_t y = first; y < last; y++)
+		{
+			convertRow(pixels+int64_t(y)*stride,cur,width,format,bpp,&tmp[0]);
+			uint8_t* out = &filtered[size_t(y)*rowBytes];
+			if (fastCompression)
+			{
+				out[0] = 1;
+				filterPNGRow(1,cur,prev,len,bpp,out+1);
+			}
+			else
+			{
+				uint32_t best = UINT32_MAX;
+				for (uint32_t type = 0; type < 5; type++)
+				{
+					uint32_t cost = filterPNGRow(type,cur,prev,len,bpp,&candidate[0]);
+					if (cost < best)
+					{
+						best = cost;
+						out[0] = type;
+						memcpy(out+1,&candidate[0],len);
+					}
+				}
+			}
+			std::swap(prev,cur);
+		}
+	});
+
+	// each band is compressed as raw deflate data with the preceding 32KB as dictionary,
+	// all but the last band end with a sync flush so they can be concatenated
+	std::map<uint32_t,PNGBand> bands;
+	Mutex bandsMutex;
+	const int level = fastCompression ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION;
+	PixelOps::forEachRow(sys,height,width,[&](uint32_t first, uint32_t last)
+	{
+		PNGBand band;
+		band.success = false;
+		const uint8_t* in = &filtered[size_t(first)*rowBytes];
+		band.length = (last-first)*rowBytes;
+		band.adler = adler32(adler32(0,Z_NULL,0),in,band.length);
+		z_stream strm;
+		memset(&strm,0,sizeof(z_stream));
+		if (deflateInit2(&strm,level,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY) == Z_OK)
+		{
+			uint32_t dictlen = std::min(uint32_t(32*1024),first*rowBytes);
+			if (dictlen == 0 || deflateSetDictionary(&strm,in-dictlen,dictlen) == Z_OK)
+			{
+				// the sync flush marker needs some bytes in addition to deflateBound
+				band.data.resize(deflateBound(&strm,band.length)+16);
+				strm.next_in = (Bytef*)in;
+				strm.avail_in = band.length;
+				strm.next_out = &band.data[0];
+				strm.avail_out = band.data.size();
+				bool isLast = last == height;
+				int status = deflate(&strm,isLast ? Z_FINISH : Z_SYNC_FLUSH);
+				if (isLast)
+					band.success = status == Z_STREAM_END;
+				else
+					band.success = status == Z_OK && strm.avail_in == 0 && strm.avail_out > 0;
+				band.data.resize(band.data.size()-strm.avail_out);
+			}
+			deflateEnd(&strm);
+		}
+		Locker l(bandsMutex);
+		bands[first].data.swap(band.data);
+		bands[first].adler = band.adler;
+		bands[first].length = band.length;
+		bands[first].success = band.success;
+	});
+
+	// zlib header for the compression level and a 32K window, followed by the bands and the adler32 checksum
+	std::vector<uint8_t> zdata;
+	zdata.push_back(0x78);
+	zdata.push_back(fastCompression ? 0x01 : 0x9c);
+	uLong adler = adler32(0,Z_NULL,0);
+	for (auto it = bands.begin(); it != bands.end(); ++it)
+	{
+		if (!it->second.success)
+		{
+			LOG(LOG_ERROR,"PNG compression failed");
+			return false;
+		}
+		zdata.insert(zdata.end(),it->second.data.begin(),it->second.data.end());
+		adler = adler32_combine(adler,it->second.adler,it->second.length);
+	}
+	writeUInt32BE(zdata,adler);
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	out.insert(out.end(),signature,signature+8);
+	std::vector<uint8_t> header;
+	writeUInt32BE(header,width);
+	writeUInt32BE(header,height);
+	header.push_back(8);
+	header.push_back(alpha ? 6 : 2);
+	// compression, filter and interlace method
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writePNGChunk(out,"IHDR",&header[0],header.size());
+	writePNGChunk(out,"IDAT",&zdata[0],zdata.size());
+	writePNGChunk(out,"IEND",nullptr,0);
+	return true;
+}
+
+struct vector_destination_mgr : public jpeg_destination_mgr
+{
+	std::vector<uint8_t>* out;
+	size_t used;
+};
+
+static void init_destination_vector(j_compress_ptr cinfo)
+{
+	vector_destination_mgr* dest = static_cast<vector_destination_mgr*>(cinfo->dest);
+	dest->used = dest->out->size();
+	dest->out->resize(dest->used+65536);
+	dest->next_output_byte = &(*dest->out)[dest->used];
+	dest->free_in_buffer = dest->out->size()-dest->used;
+}
+
+static boolean empty_output_buffer_vector(j_compress_ptr cinfo)
+{
+	// libjpeg only calls this when the whole buffer is filled
+	vector_destination_mgr* dest = static_cast<vector_destination_mgr*>(cinfo->dest);
+	dest->used = dest->out->size();
+	dest->out->resize(dest->used*2);
+	dest->next_output_byte = &(*dest->out)[dest->used];
+	dest->free_in_buffer = dest->out->size()-dest->used;
+	return TRUE;
+}
+
+static void term_destination_vector(j_compress_ptr cinfo)
+{
+	vector_destination_mgr* dest = static_cast<vector_destination_mgr*>(cinfo->dest);
+	dest->out->resize(dest->out->size()-dest->free_in_buffer);
+}
+
+bool ImageEncoder::encodeJPEG(const uint8_t* pixels, uint32_t width, uint32_t height, int32_t stride,
+			      ENCODER_PIXEL_FORMAT format, uint32_t quality, std::vector<uint8_t>& out)
+{
+	TraceSpan span("encode","encodeJPEG");
+	if (width == 0 || height == 0)
+		return false;
+	struct jpeg_compress_struct cinfo;
+	struct error_mgr err;
+	vector_destination_mgr dest;
+	size_t start = out.size();
+	// allocated before setjmp, so they are released after an error
+	std::vector<uint32_t> tmp(width);
+	std::vector<uint8_t> row(width*3);
+
+	cinfo.err = jpeg_std_error(&err);
+	err.error_exit = error_exit;
+	if (setjmp(err.jmpBuf))
+	{
+		out.resize(start);
+		return false;
+	}
+	jpeg_create_compress(&cinfo);
+	dest.out = &out;
+	dest.used = 0;
+	dest.init_destination = init_destination_vector;
+	dest.empty_output_buffer = empty_output_buffer_vector;
+	dest.term_destination = term_destination_vector;
+	cinfo.dest = &dest;
+
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+#ifdef JCS_EXTENSIONS
+	// libjpeg-turbo reads the native pixels directly and converts them with its SIMD color conversion
+	if (format == ENCODER_ARGB32_PREMULTIPLIED)
+	{
+		cinfo.input_components = 4;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		cinfo.in_color_space = JCS_EXT_BGRX;
+#else
+		cinfo.in_color_space = JCS_EXT_XRGB;
+#endif
+	}
+#endif
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo,std::max(1u,std::min(100u,quality)),TRUE);
+	jpeg_start_compress(&cinfo,TRUE);
+	while (cinfo.next_scanline < cinfo.image_height)
+	{
+		const uint8_t* src = pixels+int64_t(cinfo.next_scanline)*stride;
+		JSAMPROW rowPointer;
+		if (format == ENCODER_RGB24)
+			rowPointer = const_cast<uint8_t*>(src);
+		else if (cinfo.input_components == 4)
+		{
+			PixelOps::unpremultiply(&tmp[0],(const uint32_t*)src,width);
+			rowPointer = (JSAMPROW)&tmp[0];
+		}
+		else
+		{
+			convertRow(src,&row[0],width,format,3,&tmp[0]);
+			rowPointer = &row[0];
+		}
+		jpeg_write_scanlines(&cinfo,&rowPointer,1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+	return true;
+}
+
+ImageEncoderJob::ImageEncoderJob(uint8_t* _pixels, uint32_t w, uint32_t h, uint32_t _stride, bool _bottomUp, ENCODER_PIXEL_FORMAT f,
+				 const std::function<void(std::vector<uint8_t>&)>& _done):
+	pixels(_pixels),width(w),height(h),stride(_stride),bottomUp(_bottomUp),format(f),png(true),alpha(true),fastCompression(false),quality(80),done(_done)
+{
+}
+
+void ImageEncoderJob::execute()
+{
+	std::vector<uint8_t> out;
+	const uint8_t* start = bottomUp ? pixels+size_t(height-1)*stride : pixels;
+	int32_t s = bottomUp ? -int32_t(stride) : int32_t(stride);
+	bool success;
+	// no SystemState, so the image is not split across the ThreadPool this job is running in
+	if (png)
+		success = ImageEncoder::encodePNG(nullptr,start,width,height,s,format,alpha,fastCompression,out);
+	else
+		success = ImageEncoder::encodeJPEG(start,width,height,s,format,quality,out);
+	if (!success)
+		out.clear();
+	done(out);
+}
+
+void ImageEncoderJob::jobFence()
+{
+	delete[] pixels;
+	delete this;
+}
+
 }
@@ -21,6 +21,9 @@
 
 #include <cstdint>
 #include <istream>
+#include <functional>
+#include <vector>
+#include "threading.h"
 
 extern "C" {
 #include <jpeglib.h>
@@ -55,6 +58,58 @@ public:
 	static uint8_t* decodePalette(uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride, uint8_t* palette, unsigned int numColors, unsigned int paletteBPP);
 };
 
+class SystemState;
+
+enum ENCODER_PIXEL_FORMAT { ENCODER_ARGB32_PREMULTIPLIED, ENCODER_RGB24 };
+
+class ImageEncoder
+{
+public:
+	/*
+	 * Appends a PNG image of width*height pixels to out. stride is the distance of two rows in bytes,
+	 * it is negative for images stored bottom up. The alpha channel is only stored if alpha is set.
+	 * Large images are filtered and compressed in bands by the threads of the ThreadPool,
+	 * the bands are joined to a single zlib stream.
+	 * Returns false on error
+	 */
+	static bool encodePNG(SystemState* sys, const uint8_t* pixels, uint32_t width, uint32_t height, int32_t stride,
+			      ENCODER_PIXEL_FORMAT format, bool alpha, bool fastCompression, std::vector<uint8_t>& out);
+	// appends a JPEG image with quality in range 1-100 to out, returns false on error
+	static bool encodeJPEG(const uint8_t* pixels, uint32_t width, uint32_t height, int32_t stride,
+			       ENCODER_PIXEL_FORMAT format, uint32_t quality, std::vector<uint8_t>& out);
+};
+
+/*
+ * Encodes an image as PNG or JPEG in the ThreadPool, so the calling thread is not blocked.
+ * The job takes ownership of the pixels. done is called in the thread of the job
+ * with the encoded image, or with an empty vector if the encoding failed.
+ * The image is encoded by the job's thread only, it doesn't wait for other jobs
+ */
+class ImageEncoderJob: public IThreadJob
+{
+private:
+	uint8_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	bool bottomUp;
+	ENCODER_PIXEL_FORMAT format;
+	bool png;
+	bool alpha;
+	bool fastCompression;
+	uint32_t quality;
+	std::function<void(std::vector<uint8_t>&)> done;
+public:
+	// pixels has to be allocated with new[], bottomUp is set for images that start with the last row
+	ImageEncoderJob(uint8_t* _pixels, uint32_t w, uint32_t h, uint32_t _stride, bool _bottomUp, ENCODER_PIXEL_FORMAT f,
+			const std::function<void(std::vector<uint8_t>&)>& _done);
+	void setPNG(bool _alpha, bool _fastCompression) { png = true; alpha = _alpha; fastCompression = _fastCompression; }
+	void setJPEG(uint32_t _quality) { png = false; quality = _quality; }
+	void execute() override;
+	void threadAbort() override {}
+	void jobFence() override;
+};
+
 }
 
 #endif /* BACKENDS_IMAGE_H */
@@ -55,6 +55,49 @@ void InputThread::wait()
 	terminated=true;
 }
 
+// an event can be recycled if it was handled and is only referenced by the pool
+template<class T>
+static T* findReusableEvent(std::vector<_R<T>>& pool)
+{
+	for (auto it = pool.begin(); it != pool.end(); ++it)
+	{
+		if ((*it)->getRefCount()==1 && !ACQUIRE_READ((*it)->queued))
+			return it->getPtr();
+	}
+	return nullptr;
+}
+
+_R<MouseEvent> InputThread::getMouseEvent(const tiny_string& type, number_t lx, number_t ly, SDL_Keymod buttonState, bool pressed,
+					  _NR<InteractiveObject> relObj, int32_t delta)
+{
+	MouseEvent* ev = findReusableEvent(mouseEventPool);
+	if (ev)
+	{
+		ev->reinit(type,lx,ly,true,buttonState,pressed,relObj,delta);
+		ev->incRef();
+		return _MR(ev);
+	}
+	_R<MouseEvent> res = _MR(Class<MouseEvent>::getInstanceS(m_sys->worker,type,lx,ly,true,buttonState,pressed,relObj,delta));
+	if (mouseEventPool.size() < INPUT_EVENT_POOL_SIZE)
+		mouseEventPool.push_back(res);
+	return res;
+}
+
+_R<KeyboardEvent> InputThread::getKeyboardEvent(const tiny_string& type, uint32_t charcode, uint32_t keycode, SDL_Keymod modifiers, SDL_Keycode sdlkeycode)
+{
+	KeyboardEvent* ev = findReusableEvent(keyboardEventPool);
+	if (ev)
+	{
+		ev->reinit(type,charcode,keycode,modifiers,sdlkeycode);
+		ev->incRef();
+		return _MR(ev);
+	}
+	_R<KeyboardEvent> res = _MR(Class<KeyboardEvent>::getInstanceS(m_sys->worker,type,charcode,keycode,modifiers,sdlkeycode));
+	if (keyboardEventPool.size() < INPUT_EVENT_POOL_SIZE)
+		keyboardEventPool.push_back(res);
+	return res;
+}
+
 bool InputThread::worker(SDL_Event *event)
 {
 	bool ret=false;
@@ -290,7 +333,7 @@ void InputThread::handleMouseDown(uint32_t x, uint32_t y, SDL_Keymod buttonState
 	number_t localX, localY;
 	selected->globalToLocal(x,y,localX,localY);
 	m_sys->currentVm->addIdleEvent(selected,
-		_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseDown",localX,localY,true,buttonState,pressed)));
+		getMouseEvent("mouseDown",localX,localY,buttonState,pressed));
 	Locker locker(mutexListeners);
 	lastMouseDownTarget=selected;
 }
@@ -305,7 +348,7 @@ void InputThread::handleMouseDoubleClick(uint32_t x, uint32_t y, SDL_Keymod butt
 	number_t localX, localY;
 	selected->globalToLocal(x,y,localX,localY);
 	m_sys->currentVm->addIdleEvent(selected,
-		_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"doubleClick",localX,localY,true,buttonState,pressed)));
+		getMouseEvent("doubleClick",localX,localY,buttonState,pressed));
 }
 
 void InputThread::handleMouseUp(uint32_t x, uint32_t y, SDL_Keymod buttonState, bool pressed, uint8_t button)
@@ -320,11 +363,11 @@ void InputThread::handleMouseUp(uint32_t x, uint32_t y, SDL_Keymod buttonState,
 	if (button == SDL_BUTTON_RIGHT)
 	{
 		m_sys->currentVm->addIdleEvent(selected,
-			_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"contextMenu",localX,localY,true,buttonState,pressed)));
+			getMouseEvent("contextMenu",localX,localY,buttonState,pressed));
 		return;
 	}
 	m_sys->currentVm->addIdleEvent(selected,
-		_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseUp",localX,localY,true,buttonState,pressed)));
+		getMouseEvent("mouseUp",localX,localY,buttonState,pressed));
 	mutexListeners.lock();
 	if(lastMouseDownTarget==selected)
 	{
@@ -332,7 +375,7 @@ void InputThread::handleMouseUp(uint32_t x, uint32_t y, SDL_Keymod buttonState,
 		mutexListeners.unlock();
 		//Also send the click event
 		m_sys->currentVm->addIdleEvent(selected,
-			_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"click",localX,localY,true,buttonState,pressed)));
+			getMouseEvent("click",localX,localY,buttonState,pressed));
 	}
 	else if (lastMouseDownTarget)
 	{
@@ -340,7 +383,7 @@ void InputThread::handleMouseUp(uint32_t x, uint32_t y, SDL_Keymod buttonState,
 		lastMouseDownTarget=NullRef;
 		mutexListeners.unlock();
 		m_sys->currentVm->addIdleEvent(tmp,
-			_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"releaseOutside",localX,localY,true,buttonState,pressed)));
+			getMouseEvent("releaseOutside",localX,localY,buttonState,pressed));
 	}
 	else
 	{
@@ -390,9 +433,9 @@ void InputThread::handleMouseMove(uint32_t x, uint32_t y, SDL_Keymod buttonState
 			number_t clocalX, clocalY;
 			currentMouseOver->globalToLocal(x,y,clocalX,clocalY);
 			m_sys->currentVm->addIdleEvent(currentMouseOver,
-				_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseOut",clocalX,clocalY,true,buttonState,pressed,selected)));
+				getMouseEvent("mouseOut",clocalX,clocalY,buttonState,pressed,selected));
 			if (selected.isNull())
-				m_sys->currentVm->addIdleEvent(currentMouseOver,_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"rollOut",clocalX,clocalY,true,buttonState,pressed,selected)));
+				m_sys->currentVm->addIdleEvent(currentMouseOver,getMouseEvent("rollOut",clocalX,clocalY,buttonState,pressed,selected));
 			currentMouseOver.reset();
 		}
 		if (selected.isNull())
@@ -400,13 +443,20 @@ void InputThread::handleMouseMove(uint32_t x, uint32_t y, SDL_Keymod buttonState
 		selected->globalToLocal(x,y,localX,localY);
 		if(currentMouseOver == selected)
 		{
-			m_sys->currentVm->addIdleEvent(selected,
-				_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseMove",localX,localY,true,buttonState,pressed)));
+			// high frequency mouse movements are coalesced into a single event per frame
+			if (lastMouseMoveEvent.isNull() || !m_sys->currentVm->updatePendingMouseEvent(selected.getPtr(),lastMouseMoveEvent.getPtr(),localX,localY,buttonState,pressed))
+			{
+				if (!lastMouseMoveEvent.isNull() && lastMouseMoveEvent->getRefCount()==1 && !ACQUIRE_READ(lastMouseMoveEvent->queued))
+					lastMouseMoveEvent->updateMouseState(localX,localY,buttonState,pressed);
+				else
+					lastMouseMoveEvent = _MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseMove",localX,localY,true,buttonState,pressed));
+				m_sys->currentVm->addIdleEvent(selected,lastMouseMoveEvent);
+			}
 		}
 		else
 		{
 			m_sys->currentVm->addIdleEvent(selected,
-				_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseOver",localX,localY,true,buttonState,pressed,currentMouseOver)));
+				getMouseEvent("mouseOver",localX,localY,buttonState,pressed,currentMouseOver));
 			currentMouseOver = selected;
 		}
 		// it seems that rollOver/rollOut events are created for InteractiveObjects that are not chldren but covered by the current selected target
@@ -414,9 +464,9 @@ void InputThread::handleMouseMove(uint32_t x, uint32_t y, SDL_Keymod buttonState
 		if (rolledover && rolledover != lastRolledOver)
 		{
 			if (lastRolledOver)
-				m_sys->currentVm->addIdleEvent(lastRolledOver,_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"rollOut",localX,localY,true,buttonState,pressed,rolledover)));
+				m_sys->currentVm->addIdleEvent(lastRolledOver,getMouseEvent("rollOut",localX,localY,buttonState,pressed,rolledover));
 			m_sys->currentVm->addIdleEvent(rolledover,
-				_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"rollOver",localX,localY,true,buttonState,pressed,lastRolledOver)));
+				getMouseEvent("rollOver",localX,localY,buttonState,pressed,lastRolledOver));
 			lastRolledOver = rolledover;
 		}
 	}
@@ -443,7 +493,7 @@ void InputThread::handleScrollEvent(uint32_t x, uint32_t y, uint32_t direction,
 	number_t localX, localY;
 	selected->globalToLocal(x,y,localX,localY);
 	m_sys->currentVm->addIdleEvent(selected,
-		_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"mouseWheel",localX,localY,true,buttonState,pressed,NullRef,delta)));
+		getMouseEvent("mouseWheel",localX,localY,buttonState,pressed,NullRef,delta));
 }
 
 void InputThread::handleMouseLeave()
@@ -470,7 +520,7 @@ bool InputThread::handleKeyboardShortcuts(const SDL_KeyboardEvent *keyevent)
 			number_t localX, localY;
 			selected->globalToLocal(x,y,localX,localY);
 			m_sys->currentVm->addIdleEvent(selected,
-				_MR(Class<MouseEvent>::getInstanceS(m_sys->worker,"contextMenu",localX,localY,true,(SDL_Keymod)keyevent->keysym.mod,false)));
+				getMouseEvent("contextMenu",localX,localY,(SDL_Keymod)keyevent->keysym.mod,false));
 			return true;
 		}
 	}
@@ -700,7 +750,7 @@ void InputThread::sendKeyEvent(const SDL_KeyboardEvent *keyevent)
 		type = "keyUp";
 
 	m_sys->currentVm->addIdleEvent(target,
-	    _MR(Class<KeyboardEvent>::getInstanceS(m_sys->worker,type,keyevent->keysym.scancode,getAS3KeyCode(keyevent->keysym.sym), (SDL_Keymod)keyevent->keysym.mod,keyevent->keysym.sym)));
+	    getKeyboardEvent(type,keyevent->keysym.scancode,getAS3KeyCode(keyevent->keysym.sym), (SDL_Keymod)keyevent->keysym.mod,keyevent->keysym.sym));
 }
 
 
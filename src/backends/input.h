@@ -29,6 +29,9 @@
 #include "scripting/flash/ui/keycodes.h"
 #include <vector>
 
+// number of mouse and keyboard events kept for recycling
+#define INPUT_EVENT_POOL_SIZE 8
+
 namespace lightspark
 {
 
@@ -37,6 +40,7 @@ class DisplayObject;
 class InteractiveObject;
 class Sprite;
 class MouseEvent;
+class KeyboardEvent;
 
 class InputThread
 {
@@ -56,6 +60,15 @@ private:
 	_NR<InteractiveObject> currentMouseOver;
 	_NR<InteractiveObject> lastMouseDownTarget;
 	_NR<InteractiveObject> lastRolledOver;
+	// the last mouseMove event sent, it is updated while it is waiting in the event queue and recycled if it was not retained by actionscript
+	_NR<MouseEvent> lastMouseMoveEvent;
+	/* events created by this thread. They are recycled once they were handled and aren't referenced by actionscript,
+	 * the freelist of the worker can't be used as it must only be accessed from the worker's thread */
+	std::vector<_R<MouseEvent>> mouseEventPool;
+	std::vector<_R<KeyboardEvent>> keyboardEventPool;
+	_R<MouseEvent> getMouseEvent(const tiny_string& type, number_t lx, number_t ly, SDL_Keymod buttonState, bool pressed,
+				     _NR<InteractiveObject> relObj=NullRef, int32_t delta=1);
+	_R<KeyboardEvent> getKeyboardEvent(const tiny_string& type, uint32_t charcode, uint32_t keycode, SDL_Keymod modifiers, SDL_Keycode sdlkeycode);
 	SDL_Keymod lastKeymod;
 	set<AS3KeyCode> keyDownSet;
 	SDL_Keycode lastKeyDown;
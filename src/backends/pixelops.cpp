@@ -0,0 +1,751 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/pixelops.h"
+#include "threading.h"
+#include "swf.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define PIXELOPS_X86 1
+#	include <immintrin.h>
+#	define TARGET_SSE2 __attribute__((target("sse2")))
+#	define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace lightspark;
+using namespace std;
+
+namespace
+{
+// unpremultiplyTable[alpha*256+c] is the straight alpha value of the premultiplied channel c
+uint8_t unpremultiplyTable[256*256];
+const char* implementationName = "generic";
+bool haveSSE2 = false;
+
+inline uint32_t clampChannel(float v)
+{
+	if (v <= 0)
+		return 0;
+	if (v >= 255)
+		return 255;
+	return uint32_t(v);
+}
+
+void sourceOverGeneric(uint32_t* dst, const uint32_t* src, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t s = src[i];
+		uint32_t sa = s>>24;
+		if (sa == 0xff)
+			dst[i] = s;
+		else if (sa)
+		{
+			// two channels are multiplied at once, x/255 is computed as (x+128+((x+128)>>8))>>8
+			uint32_t ia = 0xff-sa;
+			uint32_t d = dst[i];
+			uint32_t rb = (d & 0x00ff00ff)*ia + 0x00800080;
+			rb = ((rb + ((rb>>8) & 0x00ff00ff))>>8) & 0x00ff00ff;
+			uint32_t ag = ((d>>8) & 0x00ff00ff)*ia + 0x00800080;
+			ag = (ag + ((ag>>8) & 0x00ff00ff)) & 0xff00ff00;
+			dst[i] = s + rb + ag;
+		}
+	}
+}
+
+void colorTransformGeneric(uint32_t* row, uint32_t count, const float* mul, const float* off, bool keepAlpha)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t p = row[i];
+		uint32_t res = clampChannel((p&0xff)*mul[0]+off[0]);
+		res |= clampChannel(((p>>8)&0xff)*mul[1]+off[1])<<8;
+		res |= clampChannel(((p>>16)&0xff)*mul[2]+off[2])<<16;
+		if (keepAlpha)
+			res |= p&0xff000000;
+		else
+			res |= clampChannel((p>>24)*mul[3]+off[3])<<24;
+		row[i] = res;
+	}
+}
+
+void copyChannelGeneric(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t srcShift, uint32_t dstShift)
+{
+	uint32_t keepMask = ~(0xffu<<dstShift);
+	for (uint32_t i = 0; i < count; i++)
+		dst[i] = (dst[i] & keepMask) | (((src[i]>>srcShift) & 0xff)<<dstShift);
+}
+
+template<THRESHOLD_OP op>
+inline bool thresholdTest(uint32_t v, uint32_t t)
+{
+	switch (op)
+	{
+		case THRESHOLD_LESS: return v < t;
+		case THRESHOLD_LESS_EQUAL: return v <= t;
+		case THRESHOLD_GREATER: return v > t;
+		case THRESHOLD_GREATER_EQUAL: return v >= t;
+		case THRESHOLD_EQUAL: return v == t;
+		case THRESHOLD_NOT_EQUAL: return v != t;
+	}
+	return false;
+}
+
+template<THRESHOLD_OP op>
+uint32_t thresholdGenericImpl(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t threshold, uint32_t color, uint32_t mask, bool copySource)
+{
+	uint32_t t = threshold & mask;
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (thresholdTest<op>(src[i] & mask,t))
+		{
+			dst[i] = color;
+			n++;
+		}
+		else if (copySource)
+			dst[i] = src[i];
+	}
+	return n;
+}
+
+uint32_t thresholdGeneric(uint32_t* dst, const uint32_t* src, uint32_t count, THRESHOLD_OP op, uint32_t threshold, uint32_t color, uint32_t mask, bool copySource)
+{
+	switch (op)
+	{
+		case THRESHOLD_LESS: return thresholdGenericImpl<THRESHOLD_LESS>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_LESS_EQUAL: return thresholdGenericImpl<THRESHOLD_LESS_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_GREATER: return thresholdGenericImpl<THRESHOLD_GREATER>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_GREATER_EQUAL: return thresholdGenericImpl<THRESHOLD_GREATER_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_EQUAL: return thresholdGenericImpl<THRESHOLD_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_NOT_EQUAL: return thresholdGenericImpl<THRESHOLD_NOT_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+	}
+	return 0;
+}
+
+void mergeGeneric(uint32_t* dst, const uint32_t* src, uint32_t count, const uint16_t* mul)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t s = src[i];
+		uint32_t d = dst[i];
+		uint32_t res = 0;
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint32_t sc = (s>>(8*k)) & 0xff;
+			uint32_t dc = (d>>(8*k)) & 0xff;
+			res |= ((sc*mul[k] + dc*(256-mul[k]))>>8)<<(8*k);
+		}
+		dst[i] = res;
+	}
+}
+
+bool findColorGeneric(const uint32_t* row, uint32_t count, uint32_t mask, uint32_t color, bool find, uint32_t& first, uint32_t& last)
+{
+	uint32_t i = 0;
+	while (i < count && ((row[i] & mask) == color) != find)
+		i++;
+	if (i == count)
+		return false;
+	first = i;
+	uint32_t j = count-1;
+	while (((row[j] & mask) == color) != find)
+		j--;
+	last = j;
+	return true;
+}
+
+#ifdef PIXELOPS_X86
+TARGET_SSE2 void sourceOverSSE2(uint32_t* dst, const uint32_t* src, uint32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c255 = _mm_set1_epi16(255);
+	const __m128i c128 = _mm_set1_epi16(128);
+	const __m128i opaque = _mm_set1_epi32(255);
+	uint32_t i = 0;
+	for (; i+4 <= count; i+=4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i sa = _mm_srli_epi32(s,24);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa,opaque)) == 0xffff)
+		{
+			_mm_storeu_si128((__m128i*)(dst+i),s);
+			continue;
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa,zero)) == 0xffff)
+			continue;
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+		__m128i slo = _mm_unpacklo_epi8(s,zero);
+		__m128i shi = _mm_unpackhi_epi8(s,zero);
+		// 255-alpha in all four words of each pixel
+		__m128i alo = _mm_sub_epi16(c255,_mm_shufflehi_epi16(_mm_shufflelo_epi16(slo,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m128i ahi = _mm_sub_epi16(c255,_mm_shufflehi_epi16(_mm_shufflelo_epi16(shi,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m128i dlo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d,zero),alo),c128);
+		__m128i dhi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d,zero),ahi),c128);
+		dlo = _mm_srli_epi16(_mm_add_epi16(dlo,_mm_srli_epi16(dlo,8)),8);
+		dhi = _mm_srli_epi16(_mm_add_epi16(dhi,_mm_srli_epi16(dhi,8)),8);
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_adds_epu8(s,_mm_packus_epi16(dlo,dhi)));
+	}
+	sourceOverGeneric(dst+i,src+i,count-i);
+}
+
+TARGET_AVX2 void sourceOverAVX2(uint32_t* dst, const uint32_t* src, uint32_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c255 = _mm256_set1_epi16(255);
+	const __m256i c128 = _mm256_set1_epi16(128);
+	const __m256i opaque = _mm256_set1_epi32(255);
+	uint32_t i = 0;
+	for (; i+8 <= count; i+=8)
+	{
+		__m256i s = _mm256_loadu_si256((const __m256i*)(src+i));
+		__m256i sa = _mm256_srli_epi32(s,24);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa,opaque)) == -1)
+		{
+			_mm256_storeu_si256((__m256i*)(dst+i),s);
+			continue;
+		}
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa,zero)) == -1)
+			continue;
+		// unpack and pack work on each 128 bit lane, so the pixel order is preserved
+		__m256i d = _mm256_loadu_si256((const __m256i*)(dst+i));
+		__m256i slo = _mm256_unpacklo_epi8(s,zero);
+		__m256i shi = _mm256_unpackhi_epi8(s,zero);
+		__m256i alo = _mm256_sub_epi16(c255,_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(slo,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m256i ahi = _mm256_sub_epi16(c255,_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(shi,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m256i dlo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d,zero),alo),c128);
+		__m256i dhi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d,zero),ahi),c128);
+		dlo = _mm256_srli_epi16(_mm256_add_epi16(dlo,_mm256_srli_epi16(dlo,8)),8);
+		dhi = _mm256_srli_epi16(_mm256_add_epi16(dhi,_mm256_srli_epi16(dhi,8)),8);
+		_mm256_storeu_si256((__m256i*)(dst+i),_mm256_adds_epu8(s,_mm256_packus_epi16(dlo,dhi)));
+	}
+	sourceOverSSE2(dst+i,src+i,count-i);
+}
+
+TARGET_SSE2 void colorTransformSSE2(uint32_t* row, uint32_t count, const float* mul, const float* off, bool keepAlpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 fzero = _mm_setzero_ps();
+	const __m128 f255 = _mm_set1_ps(255);
+	const __m128 vmul = _mm_loadu_ps(mul);
+	const __m128 voff = _mm_loadu_ps(off);
+	const __m128i alphaMask = _mm_set1_epi32(keepAlpha ? 0xff000000 : 0);
+	uint32_t i = 0;
+	for (; i+4 <= count; i+=4)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i*)(row+i));
+		__m128i lo = _mm_unpacklo_epi8(p,zero);
+		__m128i hi = _mm_unpackhi_epi8(p,zero);
+		// one pixel per register, channels in memory order
+		__m128 f0 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo,zero)),vmul),voff);
+		__m128 f1 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo,zero)),vmul),voff);
+		__m128 f2 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi,zero)),vmul),voff);
+		__m128 f3 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi,zero)),vmul),voff);
+		__m128i i0 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f0,fzero),f255));
+		__m128i i1 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f1,fzero),f255));
+		__m128i i2 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f2,fzero),f255));
+		__m128i i3 = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(f3,fzero),f255));
+		__m128i res = _mm_packus_epi16(_mm_packs_epi32(i0,i1),_mm_packs_epi32(i2,i3));
+		res = _mm_or_si128(_mm_andnot_si128(alphaMask,res),_mm_and_si128(alphaMask,p));
+		_mm_storeu_si128((__m128i*)(row+i),res);
+	}
+	colorTransformGeneric(row+i,count-i,mul,off,keepAlpha);
+}
+
+TARGET_SSE2 void copyChannelSSE2(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t srcShift, uint32_t dstShift)
+{
+	const __m128i keepMask = _mm_set1_epi32(~(0xffu<<dstShift));
+	const __m128i channelMask = _mm_set1_epi32(0xff);
+	const __m128i srcCount = _mm_cvtsi32_si128(srcShift);
+	const __m128i dstCount = _mm_cvtsi32_si128(dstShift);
+	uint32_t i = 0;
+	for (; i+4 <= count; i+=4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+		__m128i c = _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s,srcCount),channelMask),dstCount);
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_or_si128(_mm_and_si128(d,keepMask),c));
+	}
+	copyChannelGeneric(dst+i,src+i,count-i,srcShift,dstShift);
+}
+
+// unsigned comparison of values biased by 0x80000000
+template<THRESHOLD_OP op>
+TARGET_SSE2 inline __m128i thresholdTestSSE2(__m128i v, __m128i t)
+{
+	const __m128i ones = _mm_set1_epi32(-1);
+	switch (op)
+	{
+		case THRESHOLD_LESS: return _mm_cmplt_epi32(v,t);
+		case THRESHOLD_LESS_EQUAL: return _mm_xor_si128(_mm_cmpgt_epi32(v,t),ones);
+		case THRESHOLD_GREATER: return _mm_cmpgt_epi32(v,t);
+		case THRESHOLD_GREATER_EQUAL: return _mm_xor_si128(_mm_cmplt_epi32(v,t),ones);
+		case THRESHOLD_EQUAL: return _mm_cmpeq_epi32(v,t);
+		case THRESHOLD_NOT_EQUAL: return _mm_xor_si128(_mm_cmpeq_epi32(v,t),ones);
+	}
+	return _mm_setzero_si128();
+}
+
+template<THRESHOLD_OP op>
+TARGET_SSE2 uint32_t thresholdSSE2Impl(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t threshold, uint32_t color, uint32_t mask, bool copySource)
+{
+	const __m128i bias = _mm_set1_epi32(0x80000000);
+	const __m128i vmask = _mm_set1_epi32(mask);
+	const __m128i vt = _mm_xor_si128(_mm_set1_epi32(threshold & mask),bias);
+	const __m128i vcolor = _mm_set1_epi32(color);
+	uint32_t n = 0;
+	uint32_t i = 0;
+	for (; i+4 <= count; i+=4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i m = thresholdTestSSE2<op>(_mm_xor_si128(_mm_and_si128(s,vmask),bias),vt);
+		int bits = _mm_movemask_ps(_mm_castsi128_ps(m));
+		if (!bits && !copySource)
+			continue;
+		n += __builtin_popcount(bits);
+		__m128i other = copySource ? s : _mm_loadu_si128((const __m128i*)(dst+i));
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_or_si128(_mm_and_si128(m,vcolor),_mm_andnot_si128(m,other)));
+	}
+	return n+thresholdGenericImpl<op>(dst+i,src+i,count-i,threshold,color,mask,copySource);
+}
+
+TARGET_SSE2 uint32_t thresholdSSE2(uint32_t* dst, const uint32_t* src, uint32_t count, THRESHOLD_OP op, uint32_t threshold, uint32_t color, uint32_t mask, bool copySource)
+{
+	switch (op)
+	{
+		case THRESHOLD_LESS: return thresholdSSE2Impl<THRESHOLD_LESS>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_LESS_EQUAL: return thresholdSSE2Impl<THRESHOLD_LESS_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_GREATER: return thresholdSSE2Impl<THRESHOLD_GREATER>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_GREATER_EQUAL: return thresholdSSE2Impl<THRESHOLD_GREATER_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_EQUAL: return thresholdSSE2Impl<THRESHOLD_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+		case THRESHOLD_NOT_EQUAL: return thresholdSSE2Impl<THRESHOLD_NOT_EQUAL>(dst,src,count,threshold,color,mask,copySource);
+	}
+	return 0;
+}
+
+TARGET_SSE2 void mergeSSE2(uint32_t* dst, const uint32_t* src, uint32_t count, const uint16_t* mul)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i vm = _mm_setr_epi16(mul[0],mul[1],mul[2],mul[3],mul[0],mul[1],mul[2],mul[3]);
+	const __m128i vim = _mm_sub_epi16(_mm_set1_epi16(256),vm);
+	uint32_t i = 0;
+	for (; i+4 <= count; i+=4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+		// the sum is at most 255*256, so it fits in 16 bits
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s,zero),vm),_mm_mullo_epi16(_mm_unpacklo_epi8(d,zero),vim));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s,zero),vm),_mm_mullo_epi16(_mm_unpackhi_epi8(d,zero),vim));
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_packus_epi16(_mm_srli_epi16(lo,8),_mm_srli_epi16(hi,8)));
+	}
+	mergeGeneric(dst+i,src+i,count-i,mul);
+}
+
+TARGET_SSE2 bool findColorSSE2(const uint32_t* row, uint32_t count, uint32_t mask, uint32_t color, bool find, uint32_t& first, uint32_t& last)
+{
+	const __m128i vmask = _mm_set1_epi32(mask);
+	const __m128i vcolor = _mm_set1_epi32(color);
+	// movemask of the comparison is 0xf for four non matching pixels
+	const int notFound = find ? 0 : 0xf;
+	uint32_t vectorCount = count & ~3u;
+	uint32_t i = 0;
+	for (; i < vectorCount; i+=4)
+	{
+		__m128i m = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(row+i)),vmask),vcolor);
+		int bits = _mm_movemask_ps(_mm_castsi128_ps(m));
+		if (bits != notFound)
+		{
+			first = i + __builtin_ctz(find ? bits : (~bits & 0xf));
+			break;
+		}
+	}
+	if (i == vectorCount)
+	{
+		// no match in the vectorized part, the remaining pixels are also the last ones
+		uint32_t f,l;
+		if (!findColorGeneric(row+i,count-i,mask,color,find,f,l))
+			return false;
+		first = i+f;
+		last = i+l;
+		return true;
+	}
+	// there is a match, so search the last one from the end
+	uint32_t f,l;
+	if (findColorGeneric(row+vectorCount,count-vectorCount,mask,color,find,f,l))
+	{
+		last = vectorCount+l;
+		return true;
+	}
+	for (uint32_t j = vectorCount; j > i; j-=4)
+	{
+		__m128i m = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(row+j-4)),vmask),vcolor);
+		int bits = _mm_movemask_ps(_mm_castsi128_ps(m));
+		if (bits != notFound)
+		{
+			last = j-4 + 31-__builtin_clz(find ? bits : (~bits & 0xf));
+			return true;
+		}
+	}
+	// the first match is also the last one
+	last = first;
+	return true;
+}
+#endif
+
+// the same functions as in siv::PerlinNoise, with z=0
+inline double perlinFade(double t)
+{
+	return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+inline double perlinLerp(double t, double a, double b)
+{
+	return a + t * (b - a);
+}
+
+inline double perlinGrad(int32_t hash, double x, double y)
+{
+	const int32_t h = hash & 15;
+	const double u = h < 8 ? x : y;
+	const double v = h < 4 ? y : h == 12 || h == 14 ? x : 0.0;
+	return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+#ifdef PIXELOPS_X86
+/* perlinGrad expressed as gradX[h]*x + gradY[h]*y, the result only differs
+ * in the sign of zero, which doesn't change the resulting pixels */
+const double gradX[16] = { 1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0, 1, 0, -1, 0 };
+const double gradY[16] = { 1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1, 1, -1, 1, -1 };
+
+TARGET_SSE2 inline __m128d perlinGradSSE2(int32_t h0, int32_t h1, __m128d x, __m128d y)
+{
+	__m128d gx = _mm_set_pd(gradX[h1 & 15],gradX[h0 & 15]);
+	__m128d gy = _mm_set_pd(gradY[h1 & 15],gradY[h0 & 15]);
+	return _mm_add_pd(_mm_mul_pd(gx,x),_mm_mul_pd(gy,y));
+}
+
+TARGET_SSE2 inline __m128d perlinLerpSSE2(__m128d t, __m128d a, __m128d b)
+{
+	return _mm_add_pd(a,_mm_mul_pd(t,_mm_sub_pd(b,a)));
+}
+#endif
+
+class PixelRowsJob: public IThreadJob
+{
+public:
+	const std::function<void(uint32_t,uint32_t)>* f;
+	uint32_t first;
+	uint32_t last;
+	bool executed;
+	Semaphore* done;
+	PixelRowsJob():f(nullptr),first(0),last(0),executed(false),done(nullptr) {}
+	void execute() override
+	{
+		(*f)(first,last);
+		executed=true;
+	}
+	void jobFence() override
+	{
+		done->signal();
+	}
+};
+}
+
+void (*PixelOps::sourceOver)(uint32_t* dst, const uint32_t* src, uint32_t count) = sourceOverGeneric;
+void (*PixelOps::colorTransform)(uint32_t* row, uint32_t count, const float* mul, const float* off, bool keepAlpha) = colorTransformGeneric;
+void (*PixelOps::copyChannel)(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t srcShift, uint32_t dstShift) = copyChannelGeneric;
+uint32_t (*PixelOps::threshold)(uint32_t* dst, const uint32_t* src, uint32_t count, THRESHOLD_OP op,
+				uint32_t threshold, uint32_t color, uint32_t mask, bool copySource) = thresholdGeneric;
+void (*PixelOps::merge)(uint32_t* dst, const uint32_t* src, uint32_t count, const uint16_t* mul) = mergeGeneric;
+bool (*PixelOps::findColor)(const uint32_t* row, uint32_t count, uint32_t mask, uint32_t color, bool find, uint32_t& first, uint32_t& last) = findColorGeneric;
+
+namespace
+{
+// builds the tables and selects the implementations when the library is loaded
+struct PixelOpsInit
+{
+	PixelOpsInit()
+	{
+		for (uint32_t a = 1; a < 256; a++)
+		{
+			for (uint32_t c = 0; c < 256; c++)
+			{
+				// same rounding as BitmapContainer::getPixel
+				uint32_t v = (c*0xff)/a + ((c*0xff)%a ? 1 : 0);
+				unpremultiplyTable[a*256+c] = v > 0xff ? 0xff : v;
+			}
+		}
+#ifdef PIXELOPS_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2"))
+		{
+			implementationName = "sse2";
+			haveSSE2 = true;
+			PixelOps::sourceOver = sourceOverSSE2;
+			PixelOps::colorTransform = colorTransformSSE2;
+			PixelOps::copyChannel = copyChannelSSE2;
+			PixelOps::threshold = thresholdSSE2;
+			PixelOps::merge = mergeSSE2;
+			PixelOps::findColor = findColorSSE2;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			implementationName = "avx2";
+			PixelOps::sourceOver = sourceOverAVX2;
+		}
+#endif
+	}
+} pixelOpsInit;
+}
+
+void PixelOps::premultiply(uint32_t* dst, const uint32_t* src, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t p = src[i];
+		uint32_t a = p>>24;
+		if (a == 0xff)
+			dst[i] = p;
+		else if (a == 0)
+			dst[i] = 0;
+		else
+		{
+			uint32_t rb = (p & 0x00ff00ff)*a + 0x00800080;
+			rb = ((rb + ((rb>>8) & 0x00ff00ff))>>8) & 0x00ff00ff;
+			uint32_t g = (p & 0x0000ff00)*a + 0x00008000;
+			g = ((g + ((g>>8) & 0x0000ff00))>>8) & 0x0000ff00;
+			dst[i] = (a<<24) | rb | g;
+		}
+	}
+}
+
+void PixelOps::unpremultiply(uint32_t* dst, const uint32_t* src, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t p = src[i];
+		uint32_t a = p>>24;
+		if (a == 0xff || a == 0)
+			dst[i] = p;
+		else
+		{
+			const uint8_t* table = unpremultiplyTable+a*256;
+			dst[i] = (a<<24) | (table[(p>>16)&0xff]<<16) | (table[(p>>8)&0xff]<<8) | table[p&0xff];
+		}
+	}
+}
+
+void PixelOps::paletteMap(uint32_t* dst, const uint32_t* src, uint32_t count, const uint32_t lut[4][256])
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t p = src[i];
+		dst[i] = lut[0][p&0xff] + lut[1][(p>>8)&0xff] + lut[2][(p>>16)&0xff] + lut[3][p>>24];
+	}
+}
+
+void PixelOps::histogram(uint32_t counts[4][256], const uint32_t* row, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t p = row[i];
+		counts[0][p&0xff]++;
+		counts[1][(p>>8)&0xff]++;
+		counts[2][(p>>16)&0xff]++;
+		counts[3][p>>24]++;
+	}
+}
+
+void PixelOps::forEachRow(SystemState* sys, uint32_t rows, uint32_t width, const std::function<void(uint32_t,uint32_t)>& f)
+{
+	uint32_t parts = min(uint32_t(SDL_GetCPUCount()),min(8u,rows/16));
+	if (!sys || uint64_t(rows)*width < PIXELOPS_PARALLEL_THRESHOLD || parts < 2)
+	{
+		f(0,rows);
+		return;
+	}
+	uint32_t rowsPerPart = (rows+parts-1)/parts;
+	vector<PixelRowsJob> jobs(parts-1);
+	Semaphore done(0);
+	for (uint32_t i = 0; i < jobs.size(); i++)
+	{
+		PixelRowsJob& j = jobs[i];
+		j.f = &f;
+		j.first = min(rows,(i+1)*rowsPerPart);
+		j.last = min(rows,(i+2)*rowsPerPart);
+		j.done = &done;
+		sys->addJob(&j);
+	}
+	// the calling thread handles the first part
+	f(0,min(rows,rowsPerPart));
+	for (uint32_t i = 0; i < jobs.size(); i++)
+		done.wait();
+	// the ThreadPool may have been stopped before all jobs were executed
+	for (auto it = jobs.begin(); it != jobs.end(); ++it)
+	{
+		if (!it->executed)
+			f(it->first,it->last);
+	}
+}
+
+const char* PixelOps::getImplementationName()
+{
+	return implementationName;
+}
+
+PerlinNoiseGenerator::PerlinNoiseGenerator(uint32_t seed, uint32_t w, uint32_t h, double baseX, double baseY, uint32_t numOctaves,
+					   bool stitch, bool fractal, const std::vector<double>& offsetsX, const std::vector<double>& offsetsY):
+	octaves(numOctaves),fractalNoise(fractal),width(w),height(h)
+{
+	// same permutation as siv::PerlinNoise
+	for (size_t i = 0; i < 256; ++i)
+		p[i] = i;
+	std::shuffle(std::begin(p), std::begin(p) + 256, std::default_random_engine(seed));
+	for (size_t i = 0; i < 256; ++i)
+		p[256 + i] = p[i];
+	computeLattice(columns,width,baseX,octaves,offsetsX,stitch);
+	computeLattice(rows,height,baseY,octaves,offsetsY,stitch);
+}
+
+void PerlinNoiseGenerator::computeLattice(std::vector<LatticeCoord>& coords, uint32_t size, double base, uint32_t octaves,
+					  const std::vector<double>& offsets, bool stitch)
+{
+	coords.resize(size*octaves);
+	if (!std::isfinite(base) || base == 0.0)
+	{
+		// there are no lattice cells to scale the coordinates to, so all pixels get the same value
+		for (LatticeCoord& l : coords)
+		{
+			l.cell = 0;
+			l.next = stitch ? 0 : 1;
+			l.pos = 0.0;
+			l.fade = perlinFade(0.0);
+		}
+		return;
+	}
+	// wraps a cell index to [0,period) without converting out of range values to integers
+	auto wrapCell = [](double f, double period)
+	{
+		double r = std::fmod(f,period);
+		return r < 0 ? r+period : r;
+	};
+	double scale = 1.0;
+	for (uint32_t i = 0; i < octaves; i++)
+	{
+		double offset = i < offsets.size() && std::isfinite(offsets[i]) ? offsets[i] : 0.0;
+		// number of lattice cells covering the bitmap, the noise repeats after that
+		double period = 0.0;
+		if (stitch)
+		{
+			period = std::round(size/base*scale);
+			period = std::isnan(period) ? 1.0 : min(max(period,1.0),double(INT32_MAX));
+		}
+		for (uint32_t c = 0; c < size; c++)
+		{
+			// the coordinate is doubled for each octave, like in siv::PerlinNoise::octaveNoise
+			double v = (c+offset)/base*scale;
+			if (!std::isfinite(v))
+				v = 0.0;
+			double f = std::floor(v);
+			LatticeCoord& l = coords[i*size+c];
+			if (stitch)
+			{
+				int64_t cell = int64_t(wrapCell(f,period));
+				l.cell = cell & 255;
+				l.next = ((cell+1) % int64_t(period)) & 255;
+			}
+			else
+			{
+				l.cell = int32_t(wrapCell(f,256.0)) & 255;
+				l.next = l.cell+1;
+			}
+			l.pos = v - f;
+			l.fade = perlinFade(l.pos);
+		}
+		scale *= 2.0;
+	}
+}
+
+void PerlinNoiseGenerator::getRow(uint32_t y, double* out) const
+{
+	for (uint32_t x = 0; x < width; x++)
+		out[x] = 0.0;
+	double amp = 1.0;
+	for (uint32_t i = 0; i < octaves; i++)
+	{
+		const LatticeCoord& r = rows[i*height+y];
+		const LatticeCoord* cols = &columns[i*width];
+		uint32_t x = 0;
+#ifdef PIXELOPS_X86
+		if (haveSSE2)
+			x = getRowSSE2(r,cols,amp,out);
+#endif
+		for (; x < width; x++)
+		{
+			const LatticeCoord& c = cols[x];
+			const int32_t A = p[c.cell];
+			const int32_t B = p[c.next];
+			double n = perlinLerp(r.fade,
+				perlinLerp(c.fade, perlinGrad(p[p[A+r.cell]], c.pos, r.pos), perlinGrad(p[p[B+r.cell]], c.pos-1, r.pos)),
+				perlinLerp(c.fade, perlinGrad(p[p[A+r.next]], c.pos, r.pos-1), perlinGrad(p[p[B+r.next]], c.pos-1, r.pos-1)));
+			out[x] += (fractalNoise ? n : std::fabs(n)) * amp;
+		}
+		amp *= 0.5;
+	}
+	if (fractalNoise)
+	{
+		for (uint32_t x = 0; x < width; x++)
+			out[x] = out[x] * 0.5 + 0.5;
+	}
+}
+
+#ifdef PIXELOPS_X86
+TARGET_SSE2 uint32_t PerlinNoiseGenerator::getRowSSE2(const LatticeCoord& r, const LatticeCoord* cols, double amp, double* out) const
+{
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d vamp = _mm_set1_pd(amp);
+	const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+	const __m128d ry0 = _mm_set1_pd(r.pos);
+	const __m128d ry1 = _mm_sub_pd(ry0,one);
+	const __m128d rfade = _mm_set1_pd(r.fade);
+	uint32_t x = 0;
+	for (; x+2 <= width; x+=2)
+	{
+		const LatticeCoord& c0 = cols[x];
+		const LatticeCoord& c1 = cols[x+1];
+		const int32_t A0 = p[c0.cell], B0 = p[c0.next];
+		const int32_t A1 = p[c1.cell], B1 = p[c1.next];
+		__m128d cx0 = _mm_set_pd(c1.pos,c0.pos);
+		__m128d cx1 = _mm_sub_pd(cx0,one);
+		__m128d cfade = _mm_set_pd(c1.fade,c0.fade);
+		__m128d n = perlinLerpSSE2(rfade,
+			perlinLerpSSE2(cfade, perlinGradSSE2(p[p[A0+r.cell]],p[p[A1+r.cell]],cx0,ry0), perlinGradSSE2(p[p[B0+r.cell]],p[p[B1+r.cell]],cx1,ry0)),
+			perlinLerpSSE2(cfade, perlinGradSSE2(p[p[A0+r.next]],p[p[A1+r.next]],cx0,ry1), perlinGradSSE2(p[p[B0+r.next]],p[p[B1+r.next]],cx1,ry1)));
+		if (!fractalNoise)
+			n = _mm_and_pd(n,absMask);
+		_mm_storeu_pd(out+x,_mm_add_pd(_mm_loadu_pd(out+x),_mm_mul_pd(n,vamp)));
+	}
+	return x;
+}
+#endif
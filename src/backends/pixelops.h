@@ -0,0 +1,121 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_PIXELOPS_H
+#define BACKENDS_PIXELOPS_H 1
+
+#include "compat.h"
+#include <functional>
+#include <vector>
+
+namespace lightspark
+{
+
+class SystemState;
+
+// bitmaps with at least this number of pixels are processed by multiple threads
+#define PIXELOPS_PARALLEL_THRESHOLD (512*512)
+
+enum THRESHOLD_OP { THRESHOLD_LESS, THRESHOLD_LESS_EQUAL, THRESHOLD_GREATER, THRESHOLD_GREATER_EQUAL, THRESHOLD_EQUAL, THRESHOLD_NOT_EQUAL };
+
+/*
+ * Operations on rows of native-endian 32 bit ARGB pixels, as stored in a BitmapContainer.
+ * The fastest implementation supported by the cpu is selected at startup.
+ * Unless noted otherwise the operations work on the premultiplied pixels.
+ */
+class PixelOps
+{
+public:
+	// dst = src + dst*(1-src.alpha)
+	static void (*sourceOver)(uint32_t* dst, const uint32_t* src, uint32_t count);
+	/* channel = channel*multiplier + offset, clamped to 0-255. mul and off are in
+	 * memory order of the channels (blue, green, red, alpha). If keepAlpha is set
+	 * the alpha channel is not modified */
+	static void (*colorTransform)(uint32_t* row, uint32_t count, const float* mul, const float* off, bool keepAlpha);
+	// copies the channel at srcShift of src to the channel at dstShift of dst
+	static void (*copyChannel)(uint32_t* dst, const uint32_t* src, uint32_t count, uint32_t srcShift, uint32_t dstShift);
+	/* sets dst to color where (src & mask) op (threshold & mask) is true, otherwise to src if copySource is set.
+	 * Returns the number of pixels set to color */
+	static uint32_t (*threshold)(uint32_t* dst, const uint32_t* src, uint32_t count, THRESHOLD_OP op,
+				     uint32_t threshold, uint32_t color, uint32_t mask, bool copySource);
+	/* dst = (src*multiplier + dst*(256-multiplier))/256 for every channel,
+	 * mul is in memory order of the channels and in range 0-256 */
+	static void (*merge)(uint32_t* dst, const uint32_t* src, uint32_t count, const uint16_t* mul);
+	// sets first and last to the first and last index where (pixel & mask) == color is equal to find, returns false if there is none
+	static bool (*findColor)(const uint32_t* row, uint32_t count, uint32_t mask, uint32_t color, bool find, uint32_t& first, uint32_t& last);
+
+	// conversion between premultiplied and straight alpha, dst and src may be the same
+	static void premultiply(uint32_t* dst, const uint32_t* src, uint32_t count);
+	static void unpremultiply(uint32_t* dst, const uint32_t* src, uint32_t count);
+	// dst = lut[0][blue] + lut[1][green] + lut[2][red] + lut[3][alpha]
+	static void paletteMap(uint32_t* dst, const uint32_t* src, uint32_t count, const uint32_t lut[4][256]);
+	// adds the number of occurences of each channel value, counts is in memory order of the channels
+	static void histogram(uint32_t counts[4][256], const uint32_t* row, uint32_t count);
+
+	/* calls f for consecutive ranges of rows [first,last) covering all rows.
+	 * Large bitmaps are split across the thread pool, so f must only access pixel data.
+	 * Returns after all rows have been processed */
+	static void forEachRow(SystemState* sys, uint32_t rows, uint32_t width, const std::function<void(uint32_t,uint32_t)>& f);
+	// name of the selected implementation, for logging
+	static const char* getImplementationName();
+};
+
+/*
+ * Multi octave perlin noise for BitmapData.perlinNoise. Without stitching and
+ * offsets the fractal noise is bit-identical to siv::PerlinNoise::octaveNoise0_1.
+ * The lattice values of each octave are precomputed for all columns and rows,
+ * so only the hashing and interpolation are done per pixel.
+ */
+class PerlinNoiseGenerator
+{
+private:
+	struct LatticeCoord
+	{
+		// lattice cell and the next one, both in range 0-255 (or 0-256 for the next one without stitching)
+		int32_t cell;
+		int32_t next;
+		// distance to the cell, the distance to the next cell is pos-1
+		double pos;
+		double fade;
+	};
+	int32_t p[512];
+	uint32_t octaves;
+	bool fractalNoise;
+	// coordinates of column x and octave i are at index i*width+x, for rows at i*height+y
+	std::vector<LatticeCoord> columns;
+	std::vector<LatticeCoord> rows;
+	uint32_t width;
+	uint32_t height;
+	static void computeLattice(std::vector<LatticeCoord>& coords, uint32_t size, double base, uint32_t octaves,
+				   const std::vector<double>& offsets, bool stitch);
+	// returns the number of columns computed
+	uint32_t getRowSSE2(const LatticeCoord& r, const LatticeCoord* cols, double amp, double* out) const;
+public:
+	/*
+	 * offsetsX and offsetsY contain the offset of each octave, they may be empty.
+	 * If stitch is set, the noise is repeated seamlessly at the bitmap edges
+	 */
+	PerlinNoiseGenerator(uint32_t seed, uint32_t w, uint32_t h, double baseX, double baseY, uint32_t numOctaves,
+			     bool stitch, bool fractal, const std::vector<double>& offsetsX, const std::vector<double>& offsetsY);
+	// computes the noise of row y in range 0-1
+	void getRow(uint32_t y, double* out) const;
+};
+
+}
+#endif /* BACKENDS_PIXELOPS_H */
@@ -0,0 +1,570 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/profiler.h"
+#include "backends/tracing.h"
+#include "swf.h"
+#include "logger.h"
+#include "compat.h"
+#include "scripting/flash/system/flashsystem.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#	include <signal.h>
+#	include <sys/socket.h>
+#	include <sys/select.h>
+#	include <netinet/in.h>
+#	include <arpa/inet.h>
+#	include <unistd.h>
+#endif
+
+using namespace lightspark;
+using namespace std;
+
+// interval between two samples of the recorded stacks
+#define PROFILER_SAMPLE_INTERVAL_US 1000
+// interval for polling the signals and the control socket while not recording
+#define PROFILER_IDLE_INTERVAL_US 100000
+
+std::atomic<bool> SamplingProfiler::active(false);
+
+const char* SamplingProfiler::phaseNames[PROFILER_PHASE_COUNT] = {
+	"[advanceFrame]", "[initFrame]", "[executeFrameScript]", "[eventDispatch]", "[flushInvalidationQueue]"
+};
+
+#ifndef _WIN32
+static volatile sig_atomic_t pendingToggle = 0;
+static volatile sig_atomic_t pendingSave = 0;
+
+static void profilerSignalHandler(int sig)
+{
+	if (sig == SIGUSR1)
+		pendingToggle = 1;
+	else if (sig == SIGUSR2)
+		pendingSave = 1;
+}
+#endif
+
+static inline uint64_t profilerTime()
+{
+	return g_get_monotonic_time();
+}
+
+// builds the frame name for a method, ';' and ' ' are reserved by the collapsed stack format
+static tiny_string profilerMethodName(ASWorker* wrk, const asAtom& o, uint32_t name)
+{
+	std::string res;
+	if (asAtomHandler::isObject(o))
+		res = asAtomHandler::getObjectNoCheck(o)->getClassName().raw_buf();
+	else
+		res = "global";
+	res += "/";
+	res += wrk->getSystemState()->getStringFromUniqueId(name).raw_buf();
+	replace(res.begin(),res.end(),';','_');
+	replace(res.begin(),res.end(),' ','_');
+	return tiny_string(res);
+}
+
+ProfilerStack::ProfilerStack(const tiny_string& l):label(l),depth(0),overflow(0),generation(0)
+{
+	for (uint32_t i = 0; i < PROFILER_MAX_DEPTH; i++)
+		keys[i].store(nullptr,std::memory_order_relaxed);
+}
+
+ProfilerStack::Stats* ProfilerStack::findStats(const void* key)
+{
+	// stats is only modified by the owning thread, so it can be searched without locking
+	auto it = stats.find(key);
+	return it != stats.end() ? &it->second : nullptr;
+}
+
+ProfilerStack::Stats* ProfilerStack::addStats(const void* key, const tiny_string& name)
+{
+	Locker l(statsMutex);
+	// elements of an unordered_map are not moved by rehashing, so the pointer stays valid
+	return &stats.emplace(std::piecewise_construct,std::forward_as_tuple(key),std::forward_as_tuple(name)).first->second;
+}
+
+void ProfilerStack::push(const void* key, Stats* st, uint32_t workerDepth)
+{
+	uint32_t d = depth.load(std::memory_order_relaxed);
+	if (d == PROFILER_MAX_DEPTH)
+	{
+		overflow++;
+		return;
+	}
+	st->calls.fetch_add(1,std::memory_order_relaxed);
+	st->active++;
+	Frame& f = frames[d];
+	f.stats = st;
+	f.startTime = profilerTime();
+	f.childTime = 0;
+	f.workerDepth = workerDepth;
+	keys[d].store(key,std::memory_order_relaxed);
+	depth.store(d+1,std::memory_order_release);
+}
+
+void ProfilerStack::pop()
+{
+	if (overflow)
+	{
+		overflow--;
+		return;
+	}
+	uint32_t d = depth.load(std::memory_order_relaxed);
+	if (d == 0)
+		return;
+	const Frame& f = frames[d-1];
+	uint64_t elapsed = profilerTime()-f.startTime;
+	depth.store(d-1,std::memory_order_release);
+	if (d > 1)
+		frames[d-2].childTime += elapsed;
+
+	Stats* st = f.stats;
+	st->exclusiveTime.fetch_add(elapsed-min(elapsed,f.childTime),std::memory_order_relaxed);
+	if (st->active)
+		st->active--;
+	// recursive calls are only accounted once in the inclusive time
+	if (st->active == 0)
+		st->inclusiveTime.fetch_add(elapsed,std::memory_order_relaxed);
+}
+
+SamplingProfiler::SamplingProfiler(SystemState* s, int _port, const tiny_string& _outputFile):
+	m_sys(s),t(nullptr),stopped(false),port(_port),outputFile(_outputFile),listenfd(-1),clientfd(-1),generation(0)
+{
+	openControlSocket();
+#ifndef _WIN32
+	signal(SIGUSR1,profilerSignalHandler);
+	signal(SIGUSR2,profilerSignalHandler);
+#endif
+	t = SDL_CreateThread(SamplingProfiler::worker,"SamplingProfiler",this);
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+	stopped=true;
+	SDL_WaitThread(t,nullptr);
+	active.store(false);
+#ifndef _WIN32
+	signal(SIGUSR1,SIG_DFL);
+	signal(SIGUSR2,SIG_DFL);
+	if (clientfd >= 0)
+		::close(clientfd);
+	if (listenfd >= 0)
+		::close(listenfd);
+#endif
+	if (!outputFile.empty())
+		saveOutput();
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+		delete *it;
+}
+
+void SamplingProfiler::openControlSocket()
+{
+#ifndef _WIN32
+	if (port <= 0 || port > 65535)
+		return;
+	listenfd = socket(AF_INET,SOCK_STREAM,0);
+	if (listenfd < 0)
+	{
+		LOG(LOG_ERROR,"SamplingProfiler: unable to create control socket");
+		return;
+	}
+	int reuse = 1;
+	setsockopt(listenfd,SOL_SOCKET,SO_REUSEADDR,&reuse,sizeof(reuse));
+	sockaddr_in addr;
+	memset(&addr,0,sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	// the control socket is only reachable from the local machine
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (::bind(listenfd,(sockaddr*)&addr,sizeof(addr)) < 0 || ::listen(listenfd,1) < 0)
+	{
+		LOG(LOG_ERROR,"SamplingProfiler: unable to listen on port "<<port);
+		::close(listenfd);
+		listenfd = -1;
+		return;
+	}
+	LOG(LOG_INFO,"SamplingProfiler: control socket listening on 127.0.0.1:"<<port);
+#else
+	if (port > 0)
+		LOG(LOG_NOT_IMPLEMENTED,"SamplingProfiler: control socket not supported on this platform");
+#endif
+}
+
+void SamplingProfiler::handleControlInput(uint32_t timeout_us)
+{
+#ifndef _WIN32
+	if (listenfd < 0)
+	{
+		compat_msleep(max(timeout_us/1000,1U));
+		return;
+	}
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(listenfd,&fds);
+	if (clientfd >= 0)
+		FD_SET(clientfd,&fds);
+	timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = timeout_us;
+	if (select(max(listenfd,clientfd)+1,&fds,nullptr,nullptr,&tv) <= 0)
+		return;
+	if (clientfd >= 0 && FD_ISSET(clientfd,&fds))
+	{
+		char buf[256];
+		ssize_t n = recv(clientfd,buf,sizeof(buf),0);
+		if (n <= 0)
+		{
+			::close(clientfd);
+			clientfd = -1;
+			clientInput.clear();
+		}
+		else
+		{
+			clientInput.append(buf,n);
+			size_t pos;
+			while (clientfd >= 0 && (pos = clientInput.find('\n')) != std::string::npos)
+			{
+				std::string cmd = clientInput.substr(0,pos);
+				clientInput.erase(0,pos+1);
+				if (!cmd.empty() && cmd[cmd.size()-1] == '\r')
+					cmd.erase(cmd.size()-1);
+				std::string res = executeCommand(cmd);
+				const char* p = res.c_str();
+				size_t remaining = res.size();
+				while (remaining)
+				{
+#ifdef MSG_NOSIGNAL
+					ssize_t sent = send(clientfd,p,remaining,MSG_NOSIGNAL);
+#else
+					ssize_t sent = send(clientfd,p,remaining,0);
+#endif
+					if (sent <= 0)
+					{
+						::close(clientfd);
+						clientfd = -1;
+						clientInput.clear();
+						break;
+					}
+					p += sent;
+					remaining -= sent;
+				}
+			}
+		}
+	}
+	if (FD_ISSET(listenfd,&fds))
+	{
+		int fd = accept(listenfd,nullptr,nullptr);
+		// only one client is served at a time
+		if (fd >= 0 && clientfd >= 0)
+			::close(fd);
+		else if (fd >= 0)
+			clientfd = fd;
+	}
+#else
+	compat_msleep(max(timeout_us/1000,1U));
+#endif
+}
+
+std::string SamplingProfiler::executeCommand(const std::string& cmd)
+{
+	std::ostringstream res;
+	if (cmd == "start")
+	{
+		start();
+		res << "ok" << endl;
+	}
+	else if (cmd == "stop")
+	{
+		stop();
+		res << "ok" << endl;
+	}
+	else if (cmd == "reset")
+	{
+		reset();
+		res << "ok" << endl;
+	}
+	else if (cmd == "status")
+		res << (active.load() ? "recording" : "idle") << endl;
+	else if (cmd == "stacks")
+		dumpCollapsedStacks(res);
+	else if (cmd == "methods")
+		dumpMethodStats(res);
+	else if (cmd == "save")
+	{
+		saveOutput();
+		res << "ok" << endl;
+	}
+	else if (cmd == "trace start")
+	{
+		Tracer::start(m_sys);
+		res << "ok" << endl;
+	}
+	else if (cmd == "trace stop")
+	{
+		Tracer::stop();
+		res << "ok" << endl;
+	}
+	else if (cmd == "trace clear")
+	{
+		Tracer::clear();
+		res << "ok" << endl;
+	}
+	else if (cmd.compare(0,11,"trace save ") == 0 && cmd.size() > 11)
+		res << (Tracer::save(cmd.substr(11)) ? "ok" : "failed") << endl;
+	else if (cmd == "trace")
+		Tracer::writeJSON(res);
+	else if (!cmd.empty())
+		res << "unknown command, use start|stop|reset|status|stacks|methods|save|trace [start|stop|clear|save <file>]" << endl;
+	return res.str();
+}
+
+int SamplingProfiler::worker(void* d)
+{
+	SamplingProfiler* th = (SamplingProfiler*)d;
+	setTLSSys(th->m_sys);
+	while (!th->stopped)
+	{
+		th->handleControlInput(active.load() ? PROFILER_SAMPLE_INTERVAL_US : PROFILER_IDLE_INTERVAL_US);
+#ifndef _WIN32
+		if (pendingToggle)
+		{
+			pendingToggle = 0;
+			if (active.load())
+				th->stop();
+			else
+				th->start();
+		}
+		if (pendingSave)
+		{
+			pendingSave = 0;
+			th->saveOutput();
+		}
+#endif
+		if (active.load())
+			th->takeSample();
+	}
+	return 0;
+}
+
+void SamplingProfiler::start()
+{
+	generation++;
+	active.store(true);
+	LOG(LOG_INFO,"SamplingProfiler: recording started");
+}
+
+void SamplingProfiler::stop()
+{
+	active.store(false);
+	LOG(LOG_INFO,"SamplingProfiler: recording stopped");
+}
+
+void SamplingProfiler::reset()
+{
+	Locker l(mutex);
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+	{
+		Locker l2((*it)->statsMutex);
+		(*it)->samples.clear();
+		for (auto its = (*it)->stats.begin(); its != (*it)->stats.end(); its++)
+		{
+			its->second.calls = 0;
+			its->second.inclusiveTime = 0;
+			its->second.exclusiveTime = 0;
+		}
+	}
+}
+
+void SamplingProfiler::takeSample()
+{
+	Locker l(mutex);
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+	{
+		ProfilerStack* s = *it;
+		uint32_t d = s->depth.load(std::memory_order_acquire);
+		if (d == 0)
+			continue;
+		// the owning thread may change the stack while we read it, this only makes the sample slightly inaccurate
+		std::vector<const void*> st(d);
+		for (uint32_t i = 0; i < d; i++)
+			st[i] = s->keys[i].load(std::memory_order_relaxed);
+		Locker l2(s->statsMutex);
+		s->samples[st]++;
+	}
+}
+
+ProfilerStack* SamplingProfiler::getStack(ASWorker* wrk)
+{
+	if (wrk->profilerStack)
+		return wrk->profilerStack;
+	Locker l(mutex);
+	std::string label = wrk->isPrimordial ? "main" : "worker"+to_string(stacks.size());
+	ProfilerStack* s = new ProfilerStack(label);
+	s->generation = generation.load();
+	stacks.push_back(s);
+	wrk->profilerStack = s;
+	return s;
+}
+
+void SamplingProfiler::checkGeneration(ProfilerStack* s)
+{
+	uint32_t g = generation.load();
+	if (USUALLY_TRUE(s->generation == g))
+		return;
+	// recording was restarted, the frames on the stack may not have been popped while recording was stopped
+	Locker l(s->statsMutex);
+	s->depth.store(0,std::memory_order_release);
+	s->overflow = 0;
+	for (auto it = s->stats.begin(); it != s->stats.end(); it++)
+		it->second.active = 0;
+	s->generation = g;
+}
+
+void SamplingProfiler::enterMethod(ASWorker* wrk, method_info* mi, const asAtom& o, uint32_t name)
+{
+	ProfilerStack* s = getStack(wrk);
+	checkGeneration(s);
+	ProfilerStack::Stats* st = s->findStats(mi);
+	if (!st)
+		st = s->addStats(mi,profilerMethodName(wrk,o,name));
+	s->push(mi,st,wrk->cur_recursion);
+}
+
+void SamplingProfiler::leaveMethod(ASWorker* wrk)
+{
+	ProfilerStack* s = wrk->profilerStack;
+	// recording may have started while the method was running
+	if (!s)
+		return;
+	checkGeneration(s);
+	if (s->overflow)
+	{
+		s->pop();
+		return;
+	}
+	// frames deeper than the current recursion level were left by exceptions
+	uint32_t d = s->depth.load(std::memory_order_relaxed);
+	while (d && s->frames[d-1].workerDepth >= wrk->cur_recursion)
+	{
+		s->pop();
+		d = s->depth.load(std::memory_order_relaxed);
+	}
+}
+
+void SamplingProfiler::enterPhase(ASWorker* wrk, PROFILER_PHASE phase)
+{
+	ProfilerStack* s = getStack(wrk);
+	checkGeneration(s);
+	const void* key = &phaseNames[phase];
+	ProfilerStack::Stats* st = s->findStats(key);
+	if (!st)
+		st = s->addStats(key,phaseNames[phase]);
+	s->push(key,st,0);
+}
+
+void SamplingProfiler::leavePhase(ASWorker* wrk, PROFILER_PHASE phase)
+{
+	ProfilerStack* s = wrk->profilerStack;
+	if (!s)
+		return;
+	checkGeneration(s);
+	const void* key = &phaseNames[phase];
+	uint32_t d = s->depth.load(std::memory_order_relaxed);
+	uint32_t i = d;
+	while (i > 0 && s->keys[i-1].load(std::memory_order_relaxed) != key)
+		i--;
+	if (i == 0)
+		return;
+	// pop everything above the phase, those frames were left by exceptions
+	s->overflow = 0;
+	while (s->depth.load(std::memory_order_relaxed) >= i)
+		s->pop();
+}
+
+void SamplingProfiler::dumpCollapsedStacks(std::ostream& out)
+{
+	Locker l(mutex);
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+	{
+		ProfilerStack* s = *it;
+		Locker l2(s->statsMutex);
+		for (auto its = s->samples.begin(); its != s->samples.end(); its++)
+		{
+			out << s->label;
+			for (auto itk = its->first.begin(); itk != its->first.end(); itk++)
+			{
+				auto itn = s->stats.find(*itk);
+				out << ";" << (itn != s->stats.end() ? itn->second.name : tiny_string("?"));
+			}
+			out << " " << its->second << endl;
+		}
+	}
+}
+
+void SamplingProfiler::dumpMethodStats(std::ostream& out)
+{
+	Locker l(mutex);
+	out << "# calls inclusive_us exclusive_us thread name" << endl;
+	for (auto it = stacks.begin(); it != stacks.end(); it++)
+	{
+		ProfilerStack* s = *it;
+		Locker l2(s->statsMutex);
+		// the counters are still updated by the owning thread, so they are copied before sorting
+		struct Entry
+		{
+			uint64_t calls;
+			uint64_t inclusiveTime;
+			uint64_t exclusiveTime;
+			const tiny_string* name;
+		};
+		std::vector<Entry> sorted;
+		for (auto its = s->stats.begin(); its != s->stats.end(); its++)
+		{
+			Entry e;
+			e.calls = its->second.calls.load(std::memory_order_relaxed);
+			e.inclusiveTime = its->second.inclusiveTime.load(std::memory_order_relaxed);
+			e.exclusiveTime = its->second.exclusiveTime.load(std::memory_order_relaxed);
+			e.name = &its->second.name;
+			if (e.calls)
+				sorted.push_back(e);
+		}
+		std::sort(sorted.begin(),sorted.end(),
+			[](const Entry& a, const Entry& b) { return a.exclusiveTime > b.exclusiveTime; });
+		for (auto its = sorted.begin(); its != sorted.end(); its++)
+			out << its->calls << " " << its->inclusiveTime << " " << its->exclusiveTime << " " << s->label << " " << *its->name << endl;
+	}
+}
+
+void SamplingProfiler::saveOutput()
+{
+	if (outputFile.empty())
+	{
+		LOG(LOG_ERROR,"SamplingProfiler: no output file set");
+		return;
+	}
+	ofstream stacksfile(outputFile.raw_buf());
+	dumpCollapsedStacks(stacksfile);
+	tiny_string methodsfilename = outputFile+".methods";
+	ofstream methodsfile(methodsfilename.raw_buf());
+	dumpMethodStats(methodsfile);
+	LOG(LOG_INFO,"SamplingProfiler: profiling data written to "<<outputFile<<" and "<<methodsfilename);
+}
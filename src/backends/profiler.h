@@ -0,0 +1,176 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_PROFILER_H
+#define BACKENDS_PROFILER_H 1
+
+#include "compat.h"
+#include "threading.h"
+#include "tiny_string.h"
+#include <atomic>
+#include <list>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace lightspark
+{
+
+class SystemState;
+class ASWorker;
+class method_info;
+union asAtom;
+
+// maximum number of frames recorded per thread, deeper calls are only counted
+#define PROFILER_MAX_DEPTH 4096
+
+// the phases of the frame loop that are attributed separately from the ABC methods
+enum PROFILER_PHASE { PROFILER_PHASE_ADVANCEFRAME=0, PROFILER_PHASE_INITFRAME, PROFILER_PHASE_EXECUTEFRAMESCRIPT,
+					  PROFILER_PHASE_EVENTDISPATCH, PROFILER_PHASE_FLUSHINVALIDATION, PROFILER_PHASE_COUNT };
+
+/*
+ * The call stack of one worker, recorded while the profiler is active.
+ * Frames are only pushed and popped by the thread running the worker.
+ * The sampler thread reads the frame keys and the counters without locking, so they are atomics.
+ */
+class ProfilerStack
+{
+friend class SamplingProfiler;
+private:
+	struct Stats;
+	struct Frame
+	{
+		// the stats of the frame key, resolved once when the frame is pushed
+		Stats* stats;
+		uint64_t startTime;
+		uint64_t childTime;
+		// the recursion level of the worker when the frame was pushed, 0 for phases
+		uint32_t workerDepth;
+	};
+	struct Stats
+	{
+		tiny_string name;
+		std::atomic<uint64_t> calls;
+		std::atomic<uint64_t> inclusiveTime;
+		std::atomic<uint64_t> exclusiveTime;
+		// number of frames of this key currently on the stack, inclusive time is only added for the outermost one
+		// only used by the owning thread
+		uint32_t active;
+		Stats(const tiny_string& n):name(n),calls(0),inclusiveTime(0),exclusiveTime(0),active(0) {}
+	};
+	tiny_string label;
+	Frame frames[PROFILER_MAX_DEPTH];
+	std::atomic<const void*> keys[PROFILER_MAX_DEPTH];
+	std::atomic<uint32_t> depth;
+	// frames not recorded because PROFILER_MAX_DEPTH was reached
+	uint32_t overflow;
+	uint32_t generation;
+	// protects the structure of stats and samples, the owning thread only locks it when adding stats
+	Mutex statsMutex;
+	std::unordered_map<const void*,Stats> stats;
+	std::map<std::vector<const void*>,uint64_t> samples;
+	// returns nullptr if there are no stats for key yet
+	Stats* findStats(const void* key);
+	Stats* addStats(const void* key, const tiny_string& name);
+	void push(const void* key, Stats* st, uint32_t workerDepth);
+	void pop();
+public:
+	ProfilerStack(const tiny_string& l);
+};
+
+/*
+ * Always compiled sampling profiler for ActionScript code.
+ * While active, every ABC method call and every frame loop phase is recorded on a
+ * per worker stack, giving call counts and inclusive/exclusive times.
+ * A separate thread samples these stacks periodically to build collapsed stacks for flame graphs.
+ * It can be toggled at runtime by SIGUSR1 (SIGUSR2 writes the data to the output file)
+ * or by commands sent to a control socket listening on localhost, which also controls the Tracer.
+ * It only exists if one of the --profiler-* options is given, without them the signals keep their
+ * default action and terminate the player.
+ */
+class SamplingProfiler
+{
+private:
+	SystemState* m_sys;
+	SDL_Thread* t;
+	volatile bool stopped;
+	int port;
+	tiny_string outputFile;
+	int listenfd;
+	int clientfd;
+	std::string clientInput;
+	// incremented on every start, stacks with a different generation are cleared on their next use
+	std::atomic<uint32_t> generation;
+	Mutex mutex;
+	std::list<ProfilerStack*> stacks;
+	static const char* phaseNames[PROFILER_PHASE_COUNT];
+	static int worker(void* d);
+	void openControlSocket();
+	// waits up to timeout_us for commands on the control socket and executes them
+	void handleControlInput(uint32_t timeout_us);
+	std::string executeCommand(const std::string& cmd);
+	void takeSample();
+	ProfilerStack* getStack(ASWorker* wrk);
+	void checkGeneration(ProfilerStack* s);
+public:
+	// fast check used by the hooks in the interpreter, true while any profiler is recording
+	static std::atomic<bool> active;
+	SamplingProfiler(SystemState* s, int _port, const tiny_string& _outputFile);
+	~SamplingProfiler();
+	void start();
+	void stop();
+	void reset();
+	void enterMethod(ASWorker* wrk, method_info* mi, const asAtom& o, uint32_t name);
+	void leaveMethod(ASWorker* wrk);
+	void enterPhase(ASWorker* wrk, PROFILER_PHASE phase);
+	void leavePhase(ASWorker* wrk, PROFILER_PHASE phase);
+	void dumpCollapsedStacks(std::ostream& out);
+	void dumpMethodStats(std::ostream& out);
+	// writes the collapsed stacks to the output file and the method stats to <output file>.methods
+	void saveOutput();
+};
+
+/*
+ * Attributes the time until the end of the scope to a frame loop phase
+ */
+class ProfilerPhaseScope
+{
+private:
+	SamplingProfiler* profiler;
+	ASWorker* wrk;
+	PROFILER_PHASE phase;
+public:
+	ProfilerPhaseScope(SamplingProfiler* p, ASWorker* w, PROFILER_PHASE ph):profiler(nullptr),wrk(w),phase(ph)
+	{
+		if (USUALLY_FALSE(SamplingProfiler::active.load(std::memory_order_relaxed)) && p && w)
+		{
+			profiler=p;
+			profiler->enterPhase(wrk,phase);
+		}
+	}
+	~ProfilerPhaseScope()
+	{
+		if (USUALLY_FALSE(profiler))
+			profiler->leavePhase(wrk,phase);
+	}
+};
+
+}
+#endif /* BACKENDS_PROFILER_H */
@@ -22,6 +22,8 @@
 #include "parsing/textfile.h"
 #include "backends/rendering.h"
 #include "backends/input.h"
+#include "backends/tracing.h"
+#include "backends/image.h"
 #include "compat.h"
 #include <sstream>
 #include <unistd.h>
@@ -110,13 +112,16 @@ void RenderThread::finalizeUpload()
 	TextureChunk& tex=u->getTexture();
 	u->contentScale(tex.xContentScale, tex.yContentScale);
 	u->contentOffset(tex.xOffset, tex.yOffset);
-	loadChunkBGRA(tex, w, h, u->upload(false));
+	uint32_t x,y,rw,rh;
+	if(u->getUploadRegion(x,y,rw,rh))
+		loadChunkBGRA(tex, w, h, u->upload(false), x, y, rw, rh);
 	u->uploadFence();
 	prevUploadJob=nullptr;
 }
 
 void RenderThread::handleUpload()
 {
+	TraceSpan span("render","textureUpload");
 	ITextureUploadable* u=getUploadJob();
 	assert(u);
 	uint32_t w,h;
@@ -153,6 +158,7 @@ int RenderThread::worker(void* d)
 	setTLSWorker(th->m_sys->worker);
 	/* set TLS variable for getRenderThread() */
 	tls_set(renderThread, th);
+	Tracer::setThreadName("RenderThread");
 
 	ThreadProfile* profile=th->m_sys->allocateProfiler(RGB(200,0,0));
 	profile->setTag("Render");
@@ -200,6 +206,7 @@ bool RenderThread::doRender(ThreadProfile* profile,Chronometer* chronometer)
 	event.wait();
 	if(m_sys->isShuttingDown())
 		return false;
+	TraceSpan span("render","render");
 	if (chronometer)
 		chronometer->checkpoint();
 
@@ -392,52 +399,34 @@ void RenderThread::renderSettingsPage()
 }
 void RenderThread::generateScreenshot()
 {
-	char* buf = new char[windowWidth*windowHeight*3];
-	if (!buf)
-	{
-		LOG(LOG_ERROR,"generating screenshot memory failed");
-		return;
-	}
+	uint8_t* buf = new uint8_t[windowWidth*windowHeight*3];
 	engineData->exec_glReadPixels(windowWidth, windowHeight, buf);
-	
-	char* name_used=nullptr;
-	int fd = g_file_open_tmp("lightsparkXXXXXX.bmp",&name_used,nullptr);
-	if(fd == -1)
-	{
-		LOG(LOG_ERROR,"generating screenshot file failed");
-		return;
-	}
-	
-	unsigned char bmp_file_header[14] = { 'B', 'M', 0, 0, 0, 0, 0, 0, 0, 0, 54, 0, 0, 0, };
-	unsigned char bmp_info_header[40] = { 40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 24, 0, };
-	size_t size = 54 + windowWidth * windowHeight * 3;
-
-	bmp_file_header[2] = (size)&0xff;
-	bmp_file_header[3] = (size >> 8);
-	bmp_file_header[4] = (size >> 16);
-	bmp_file_header[5] = (size >> 24);
-
-	bmp_info_header[4] = (windowWidth)&0xff;
-	bmp_info_header[5] = (windowWidth >> 8)&0xff;
-	bmp_info_header[6] = (windowWidth >> 16)&0xff;
-	bmp_info_header[7] = (windowWidth >> 24)&0xff;
-
-	bmp_info_header[8] = (windowHeight)&0xff;
-	bmp_info_header[9] = (windowHeight >> 8)&0xff;
-	bmp_info_header[10] = (windowHeight >> 16)&0xff;
-	bmp_info_header[11] = (windowHeight >> 24)&0xff;
-		
-	if (write(fd,bmp_file_header,14)<0)
-		LOG(LOG_INFO,"screenshot header write error");
-	if (write(fd,bmp_info_header,40)<0)
-		LOG(LOG_INFO,"screenshot header write error");
-	if (write(fd,buf,windowWidth * windowHeight * 3)<0)
-		LOG(LOG_INFO,"screenshot write error");
-	close(fd);
-	delete[] buf;
-	LOG(LOG_INFO,"screenshot generated:"<<name_used);
-	g_free(name_used);
 	screenshotneeded=false;
+
+	// the rows are read bottom up, the image is encoded and written by the ThreadPool
+	ImageEncoderJob* job = new ImageEncoderJob(buf,windowWidth,windowHeight,windowWidth*3,true,ENCODER_RGB24,
+		[](std::vector<uint8_t>& png)
+		{
+			if (png.empty())
+			{
+				LOG(LOG_ERROR,"encoding screenshot failed");
+				return;
+			}
+			char* name_used=nullptr;
+			int fd = g_file_open_tmp("lightsparkXXXXXX.png",&name_used,nullptr);
+			if(fd == -1)
+			{
+				LOG(LOG_ERROR,"generating screenshot file failed");
+				return;
+			}
+			if (write(fd,&png[0],png.size())<0)
+				LOG(LOG_INFO,"screenshot write error");
+			close(fd);
+			LOG(LOG_INFO,"screenshot generated:"<<name_used);
+			g_free(name_used);
+		});
+	job->setPNG(false,false);
+	m_sys->addJob(job);
 }
 
 void RenderThread::deinit()
@@ -1082,7 +1071,8 @@ TextureChunk RenderThread::allocateTexture(uint32_t w, uint32_t h, bool compact)
 	return ret;
 }
 
-void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data)
+void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data,
+				 uint32_t regionX, uint32_t regionY, uint32_t regionW, uint32_t regionH)
 {
 	//Fast bailout if the TextureChunk is not valid
 	if(chunk.chunks==nullptr || data == nullptr)
@@ -1101,6 +1091,10 @@ void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t
 		uint32_t curY=(i/blocksW)*CHUNKSIZE_REAL;
 		if (curX > w || curY > h)
 			break;
+		// skip chunks that are not affected by the changes
+		if (curX+CHUNKSIZE_REAL <= regionX || curX >= regionX+regionW
+			|| curY+CHUNKSIZE_REAL <= regionY || curY >= regionY+regionH)
+			continue;
 		uint32_t sizeX=min(int(w-curX),CHUNKSIZE_REAL)+2;
 		uint32_t sizeY=min(int(h-curY),CHUNKSIZE_REAL)+2;
 		const uint32_t blockX=((chunk.chunks[i]%blocksPerSide)*CHUNKSIZE);
@@ -156,7 +156,9 @@ public:
 	/**
 		Load the given data in the given texture chunk
 	*/
-	void loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data);
+	// only the chunks intersecting the region regionX,regionY,regionW,regionH are loaded
+	void loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data,
+			   uint32_t regionX, uint32_t regionY, uint32_t regionW, uint32_t regionH);
 	/**
 		Enqueue something to be uploaded to texture
 	*/
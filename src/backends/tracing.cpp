@@ -0,0 +1,272 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/tracing.h"
+#include "swf.h"
+#include "logger.h"
+#include "threading.h"
+#include <fstream>
+#include <list>
+#include <unordered_map>
+
+using namespace lightspark;
+using namespace std;
+
+namespace
+{
+struct TraceEvent
+{
+	const char* category;
+	const char* name;
+	uint64_t start;
+	uint64_t end;
+	uint32_t detail;
+};
+
+class TraceBuffer
+{
+public:
+	const char* threadName;
+	SDL_threadID threadID;
+	// protects events and count against concurrent writing of the trace
+	Mutex mutex;
+	TraceEvent events[TRACE_BUFFER_SIZE];
+	uint64_t count;
+	// totals are kept for all spans, including those already overwritten in the ring buffer
+	std::unordered_map<const char*,TraceTotal> totals;
+	// set when the thread terminated, protected by buffersMutex
+	bool exited;
+	TraceBuffer(const char* n, SDL_threadID id):threadName(n),threadID(id),count(0),exited(false) {}
+};
+
+Mutex buffersMutex;
+/* buffers of terminated threads are kept until the trace is cleared, but at most TRACE_MAX_EXITED_BUFFERS of them.
+ * ThreadPool creates a new thread for every job that doesn't fit into the pool, so there may be many short lived threads */
+std::list<TraceBuffer*> buffers;
+// totals of the buffers that were reused for other threads
+std::unordered_map<const char*,TraceTotal> exitedTotals;
+
+// called by SDL when a thread that recorded spans terminates
+void threadExited(void* data)
+{
+	Locker l(buffersMutex);
+	((TraceBuffer*)data)->exited = true;
+}
+
+TraceBuffer* getBuffer(const char* threadName)
+{
+	Locker l(buffersMutex);
+	TraceBuffer* oldest = nullptr;
+	uint32_t exitedCount = 0;
+	for (auto it = buffers.begin(); it != buffers.end(); it++)
+	{
+		if (!(*it)->exited)
+			continue;
+		if (!oldest)
+			oldest = *it;
+		exitedCount++;
+	}
+	TraceBuffer* b;
+	if (exitedCount >= TRACE_MAX_EXITED_BUFFERS)
+	{
+		b = oldest;
+		buffers.remove(b);
+		Locker l2(b->mutex);
+		for (auto it = b->totals.begin(); it != b->totals.end(); it++)
+		{
+			TraceTotal& t = exitedTotals[it->first];
+			t.count += it->second.count;
+			t.time += it->second.time;
+		}
+		b->totals.clear();
+		b->count = 0;
+		b->threadName = threadName;
+		b->threadID = SDL_ThreadID();
+		b->exited = false;
+	}
+	else
+		b = new TraceBuffer(threadName,SDL_ThreadID());
+	buffers.push_back(b);
+	return b;
+}
+}
+
+DEFINE_AND_INITIALIZE_TLS(trace_buffer);
+DEFINE_AND_INITIALIZE_TLS(trace_thread_name);
+
+std::atomic<bool> Tracer::enabled(false);
+SystemState* Tracer::sys = nullptr;
+uint64_t Tracer::startTime = 0;
+
+void Tracer::start(SystemState* s)
+{
+	sys = s;
+	if (!startTime)
+		startTime = now();
+	enabled.store(true);
+	LOG(LOG_INFO,"Tracer: recording started");
+}
+
+void Tracer::stop()
+{
+	enabled.store(false);
+	LOG(LOG_INFO,"Tracer: recording stopped");
+}
+
+void Tracer::clear()
+{
+	Locker l(buffersMutex);
+	exitedTotals.clear();
+	auto it = buffers.begin();
+	while (it != buffers.end())
+	{
+		if ((*it)->exited)
+		{
+			delete *it;
+			it = buffers.erase(it);
+			continue;
+		}
+		Locker l2((*it)->mutex);
+		(*it)->count = 0;
+		(*it)->totals.clear();
+		it++;
+	}
+}
+
+void Tracer::setThreadName(const char* name)
+{
+	tls_set(trace_thread_name,(void*)name);
+	TraceBuffer* b = (TraceBuffer*)tls_get(trace_buffer);
+	if (b)
+		b->threadName = name;
+}
+
+void Tracer::record(const char* category, const char* name, uint64_t start, uint64_t end, uint32_t detail)
+{
+	TraceBuffer* b = (TraceBuffer*)tls_get(trace_buffer);
+	if (!b)
+	{
+		const char* threadName = (const char*)tls_get(trace_thread_name);
+		b = getBuffer(threadName ? threadName : "thread");
+		SDL_TLSSet(trace_buffer,b,threadExited);
+	}
+	Locker l(b->mutex);
+	TraceEvent& e = b->events[b->count % TRACE_BUFFER_SIZE];
+	e.category = category;
+	e.name = name;
+	e.start = start;
+	e.end = end;
+	e.detail = detail;
+	b->count++;
+	TraceTotal& t = b->totals[name];
+	t.count++;
+	t.time += end-start;
+}
+
+static void writeJSONString(std::ostream& out, const char* s)
+{
+	out << '"';
+	for (const char* p = s; *p; p++)
+	{
+		unsigned char c = *p;
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (c < 0x20)
+		{
+			char buf[8];
+			snprintf(buf,8,"\\u%04x",c);
+			out << buf;
+		}
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+void Tracer::writeJSON(std::ostream& out)
+{
+	Locker l(buffersMutex);
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for (auto it = buffers.begin(); it != buffers.end(); it++)
+	{
+		TraceBuffer* b = *it;
+		Locker l2(b->mutex);
+		if (!first)
+			out << ",";
+		first = false;
+		out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->threadID << ",\"args\":{\"name\":";
+		writeJSONString(out,b->threadName);
+		out << "}}";
+		uint64_t begin = b->count > TRACE_BUFFER_SIZE ? b->count-TRACE_BUFFER_SIZE : 0;
+		for (uint64_t i = begin; i < b->count; i++)
+		{
+			const TraceEvent& e = b->events[i % TRACE_BUFFER_SIZE];
+			out << ",\n{\"name\":";
+			writeJSONString(out,e.name);
+			out << ",\"cat\":";
+			writeJSONString(out,e.category);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->threadID;
+			out << ",\"ts\":" << (e.start-min(e.start,startTime)) << ",\"dur\":" << (e.end-e.start);
+			if (e.detail != TRACE_NO_DETAIL && sys)
+			{
+				out << ",\"args\":{\"detail\":";
+				writeJSONString(out,sys->getStringFromUniqueId(e.detail).raw_buf());
+				out << "}";
+			}
+			out << "}";
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}" << endl;
+}
+
+void Tracer::getTotals(std::map<std::string,TraceTotal>& totals)
+{
+	Locker l(buffersMutex);
+	for (auto it = exitedTotals.begin(); it != exitedTotals.end(); it++)
+	{
+		TraceTotal& t = totals[it->first];
+		t.count += it->second.count;
+		t.time += it->second.time;
+	}
+	for (auto it = buffers.begin(); it != buffers.end(); it++)
+	{
+		Locker l2((*it)->mutex);
+		for (auto itt = (*it)->totals.begin(); itt != (*it)->totals.end(); itt++)
+		{
+			// the same literal may have different addresses in different translation units
+			TraceTotal& t = totals[itt->first];
+			t.count += itt->second.count;
+			t.time += itt->second.time;
+		}
+	}
+}
+
+bool Tracer::save(const tiny_string& filename)
+{
+	ofstream f(filename.raw_buf());
+	if (!f)
+	{
+		LOG(LOG_ERROR,"Tracer: unable to write trace to "<<filename);
+		return false;
+	}
+	writeJSON(f);
+	LOG(LOG_INFO,"Tracer: trace written to "<<filename);
+	return true;
+}
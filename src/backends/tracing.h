@@ -0,0 +1,102 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_TRACING_H
+#define BACKENDS_TRACING_H 1
+
+#include "compat.h"
+#include "tiny_string.h"
+#include <atomic>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace lightspark
+{
+
+class SystemState;
+
+struct TraceTotal
+{
+	uint64_t count;
+	uint64_t time;
+	TraceTotal():count(0),time(0) {}
+};
+
+// number of spans kept per thread, older spans are overwritten
+#define TRACE_BUFFER_SIZE 8192
+// number of buffers of terminated threads kept, the oldest one is reused for the next thread
+#define TRACE_MAX_EXITED_BUFFERS 16
+#define TRACE_NO_DETAIL UINT32_MAX
+
+/*
+ * Records timed spans into per thread ring buffers and writes them in the
+ * Chrome trace event format, which can be loaded into chrome://tracing or Perfetto.
+ * All names and categories have to be string literals, only the optional detail
+ * is a string id of the SystemState and resolved when the trace is written.
+ */
+class Tracer
+{
+private:
+	static SystemState* sys;
+	static uint64_t startTime;
+public:
+	static std::atomic<bool> enabled;
+	static void start(SystemState* s);
+	static void stop();
+	// removes all recorded spans
+	static void clear();
+	// sets the name shown for the calling thread, name has to be a string literal
+	static void setThreadName(const char* name);
+	static void record(const char* category, const char* name, uint64_t start, uint64_t end, uint32_t detail);
+	static void writeJSON(std::ostream& out);
+	// adds the number and total duration of all spans recorded since the last clear, grouped by name
+	static void getTotals(std::map<std::string,TraceTotal>& totals);
+	static bool save(const tiny_string& filename);
+	static inline uint64_t now()
+	{
+		return g_get_monotonic_time();
+	}
+};
+
+/*
+ * Records the time until the end of the scope as a span, if tracing is enabled
+ */
+class TraceSpan
+{
+private:
+	const char* category;
+	const char* name;
+	uint64_t start;
+	uint32_t detail;
+public:
+	TraceSpan(const char* c, const char* n, uint32_t d=TRACE_NO_DETAIL):category(c),name(n),start(0),detail(d)
+	{
+		if (USUALLY_FALSE(Tracer::enabled.load(std::memory_order_relaxed)))
+			start=Tracer::now();
+	}
+	~TraceSpan()
+	{
+		if (USUALLY_FALSE(start))
+			Tracer::record(category,name,start,Tracer::now(),detail);
+	}
+};
+
+}
+#endif /* BACKENDS_TRACING_H */
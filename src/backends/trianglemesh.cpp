@@ -0,0 +1,281 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "backends/trianglemesh.h"
+#include "backends/pixelops.h"
+#include "scripting/flash/display/BitmapContainer.h"
+#include "scripting/flash/display/flashdisplay.h"
+#include <cmath>
+#include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace lightspark;
+using namespace std;
+
+namespace
+{
+
+struct TriangleSetup
+{
+	// vertices in pixel coordinates
+	double x[3];
+	double y[3];
+	double ymin;
+	double ymax;
+	/* u*t, v*t (in texels) and t as planes a + dx*x + dy*y over the pixel coordinates,
+	 * their linear interpolation gives perspective correct texture coordinates */
+	double a[3];
+	double dx[3];
+	double dy[3];
+};
+
+// a*(256-f)/256 + b*f/256 for all channels, f in range 0-256
+inline uint32_t lerpPixel(uint32_t a, uint32_t b, uint32_t f)
+{
+	uint32_t rb = (((a & 0x00ff00ff)*(256-f) + (b & 0x00ff00ff)*f)>>8) & 0x00ff00ff;
+	uint32_t ag = (((a>>8) & 0x00ff00ff)*(256-f) + ((b>>8) & 0x00ff00ff)*f) & 0xff00ff00;
+	return rb | ag;
+}
+
+inline int32_t texelIndex(int32_t i, int32_t size, bool repeat)
+{
+	if (repeat)
+	{
+		i %= size;
+		return i < 0 ? i+size : i;
+	}
+	return i < 0 ? 0 : i >= size ? size-1 : i;
+}
+
+// keeps the texture coordinates in a range that can be converted to int
+inline float clampCoord(float v)
+{
+	if (!(v > -1e6f))
+		return -1e6f;
+	if (v > 1e6f)
+		return 1e6f;
+	return v;
+}
+
+class TextureSampler
+{
+private:
+	const BitmapContainer* tex;
+	int32_t width;
+	int32_t height;
+	bool repeat;
+	bool smooth;
+public:
+	// sample must only be called if fill has a bitmap
+	TextureSampler(const FILLSTYLE& fill):tex(fill.bitmap.getPtr()),width(tex ? tex->getWidth() : 0),height(tex ? tex->getHeight() : 0),
+		repeat(fill.FillStyleType == REPEATING_BITMAP || fill.FillStyleType == NON_SMOOTHED_REPEATING_BITMAP),
+		smooth(fill.FillStyleType == REPEATING_BITMAP || fill.FillStyleType == CLIPPED_BITMAP)
+	{
+	}
+	uint32_t sample(float u, float v) const
+	{
+		u = clampCoord(u);
+		v = clampCoord(v);
+		if (!smooth)
+		{
+			int32_t x = texelIndex(int32_t(floorf(u)),width,repeat);
+			int32_t y = texelIndex(int32_t(floorf(v)),height,repeat);
+			return tex->getPixelRow(y)[x];
+		}
+		u -= 0.5f;
+		v -= 0.5f;
+		float fu = floorf(u);
+		float fv = floorf(v);
+		uint32_t fx = uint32_t((u-fu)*256);
+		uint32_t fy = uint32_t((v-fv)*256);
+		int32_t x0 = texelIndex(int32_t(fu),width,repeat);
+		int32_t x1 = texelIndex(int32_t(fu)+1,width,repeat);
+		const uint32_t* row0 = tex->getPixelRow(texelIndex(int32_t(fv),height,repeat));
+		const uint32_t* row1 = tex->getPixelRow(texelIndex(int32_t(fv)+1,height,repeat));
+		return lerpPixel(lerpPixel(row0[x0],row0[x1],fx),lerpPixel(row1[x0],row1[x1],fx),fy);
+	}
+};
+
+// computes the texture coordinates of count pixels starting at pixel center (x,y)
+void spanTextureCoords(const TriangleSetup& t, double x, double y, uint32_t count, float* us, float* vs)
+{
+	float ut = t.a[0] + t.dx[0]*x + t.dy[0]*y;
+	float vt = t.a[1] + t.dx[1]*x + t.dy[1]*y;
+	float tt = t.a[2] + t.dx[2]*x + t.dy[2]*y;
+	uint32_t i = 0;
+#ifdef __SSE2__
+	const __m128 steps = _mm_set_ps(3,2,1,0);
+	__m128 vut = _mm_add_ps(_mm_set1_ps(ut),_mm_mul_ps(_mm_set1_ps(t.dx[0]),steps));
+	__m128 vvt = _mm_add_ps(_mm_set1_ps(vt),_mm_mul_ps(_mm_set1_ps(t.dx[1]),steps));
+	__m128 vtt = _mm_add_ps(_mm_set1_ps(tt),_mm_mul_ps(_mm_set1_ps(t.dx[2]),steps));
+	const __m128 dut = _mm_set1_ps(4*t.dx[0]);
+	const __m128 dvt = _mm_set1_ps(4*t.dx[1]);
+	const __m128 dtt = _mm_set1_ps(4*t.dx[2]);
+	for (; i+4 <= count; i+=4)
+	{
+		_mm_storeu_ps(us+i,_mm_div_ps(vut,vtt));
+		_mm_storeu_ps(vs+i,_mm_div_ps(vvt,vtt));
+		vut = _mm_add_ps(vut,dut);
+		vvt = _mm_add_ps(vvt,dvt);
+		vtt = _mm_add_ps(vtt,dtt);
+	}
+	ut += i*t.dx[0];
+	vt += i*t.dx[1];
+	tt += i*t.dx[2];
+#endif
+	for (; i < count; i++)
+	{
+		us[i] = ut/tt;
+		vs[i] = vt/tt;
+		ut += t.dx[0];
+		vt += t.dx[1];
+		tt += t.dx[2];
+	}
+}
+
+}
+
+bool TriangleMesh::isTextured() const
+{
+	return !uvt.empty() && !fill.bitmap.isNull() && !fill.bitmap->isEmpty();
+}
+
+void TriangleMesh::getBounds(number_t& xmin, number_t& xmax, number_t& ymin, number_t& ymax) const
+{
+	for (auto it = indices.begin(); it != indices.end(); ++it)
+	{
+		number_t x = positions[2*(*it)];
+		number_t y = positions[2*(*it)+1];
+		xmin = min(x,xmin);
+		xmax = max(x,xmax);
+		ymin = min(y,ymin);
+		ymax = max(y,ymax);
+	}
+}
+
+void TriangleMesh::rasterize(uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride, const MATRIX& m, bool isMask) const
+{
+	bool textured = isTextured();
+	// like the cairo path, nothing is drawn if the bitmap fill has no pixels
+	if (!uvt.empty() && !textured)
+		return;
+	double texWidth = textured ? fill.bitmap->getWidth() : 0;
+	double texHeight = textured ? fill.bitmap->getHeight() : 0;
+
+	vector<TriangleSetup> triangles;
+	triangles.reserve(indices.size()/3);
+	for (uint32_t i = 0; i+2 < indices.size(); i+=3)
+	{
+		TriangleSetup t;
+		double attr[3][3];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t v = indices[i+j];
+			m.multiply2D(positions[2*v],positions[2*v+1],t.x[j],t.y[j]);
+			if (textured)
+			{
+				double w = uvt[3*v+2];
+				attr[0][j] = uvt[3*v]*texWidth*w;
+				attr[1][j] = uvt[3*v+1]*texHeight*w;
+				attr[2][j] = w;
+			}
+		}
+		double det = (t.x[1]-t.x[0])*(t.y[2]-t.y[0]) - (t.x[2]-t.x[0])*(t.y[1]-t.y[0]);
+		if (det == 0 || std::isnan(det))
+			continue;
+		t.ymin = min(t.y[0],min(t.y[1],t.y[2]));
+		t.ymax = max(t.y[0],max(t.y[1],t.y[2]));
+		if (t.ymax < 0 || t.ymin >= height)
+			continue;
+		if (textured)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				double d1 = attr[k][1]-attr[k][0];
+				double d2 = attr[k][2]-attr[k][0];
+				t.dx[k] = (d1*(t.y[2]-t.y[0]) - d2*(t.y[1]-t.y[0]))/det;
+				t.dy[k] = (d2*(t.x[1]-t.x[0]) - d1*(t.x[2]-t.x[0]))/det;
+				t.a[k] = attr[k][0] - t.dx[k]*t.x[0] - t.dy[k]*t.y[0];
+			}
+		}
+		triangles.push_back(t);
+	}
+	if (triangles.empty())
+		return;
+
+	uint32_t color = 0;
+	if (!textured)
+	{
+		uint32_t straight = ((isMask ? 0xffu : uint32_t(fill.Color.Alpha))<<24) |
+				    (uint32_t(fill.Color.Red)<<16) | (uint32_t(fill.Color.Green)<<8) | fill.Color.Blue;
+		PixelOps::premultiply(&color,&straight,1);
+		if (color == 0)
+			return;
+	}
+
+	vector<uint32_t> span(width);
+	vector<float> us(width);
+	vector<float> vs(width);
+	if (!textured)
+		std::fill(span.begin(),span.end(),color);
+	TextureSampler sampler(fill);
+	for (auto it = triangles.begin(); it != triangles.end(); ++it)
+	{
+		const TriangleSetup& t = *it;
+		// rows whose pixel centers are in [ymin,ymax)
+		int64_t rowStart = max(int64_t(0),int64_t(ceil(t.ymin-0.5)));
+		int64_t rowEnd = min(int64_t(height),int64_t(ceil(t.ymax-0.5)));
+		for (int64_t y = rowStart; y < rowEnd; y++)
+		{
+			double cy = y+0.5;
+			double xl = numeric_limits<double>::infinity();
+			double xr = -numeric_limits<double>::infinity();
+			for (uint32_t e = 0; e < 3; e++)
+			{
+				uint32_t n = e == 2 ? 0 : e+1;
+				// half open intervals, so a vertex on the scanline is only counted once
+				if ((t.y[e] <= cy) == (t.y[n] <= cy))
+					continue;
+				double x = t.x[e] + (cy-t.y[e])*(t.x[n]-t.x[e])/(t.y[n]-t.y[e]);
+				xl = min(xl,x);
+				xr = max(xr,x);
+			}
+			int64_t x0 = max(int64_t(0),int64_t(ceil(xl-0.5)));
+			int64_t x1 = min(int64_t(width),int64_t(ceil(xr-0.5)));
+			if (x0 >= x1)
+				continue;
+			uint32_t count = x1-x0;
+			uint32_t* row = (uint32_t*)(pixels+y*stride)+x0;
+			if (textured)
+			{
+				spanTextureCoords(t,x0+0.5,cy,count,&us[0],&vs[0]);
+				for (uint32_t i = 0; i < count; i++)
+					span[i] = sampler.sample(us[i],vs[i]);
+			}
+			else if ((color>>24) == 0xff)
+			{
+				std::fill(row,row+count,color);
+				continue;
+			}
+			PixelOps::sourceOver(row,&span[0],count);
+		}
+	}
+}
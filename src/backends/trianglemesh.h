@@ -0,0 +1,71 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_TRIANGLEMESH_H
+#define BACKENDS_TRIANGLEMESH_H 1
+
+#include "compat.h"
+#include "swftypes.h"
+#include "smartrefs.h"
+#include <vector>
+
+namespace lightspark
+{
+
+enum TRIANGLE_CULLING { CULLING_NONE, CULLING_POSITIVE, CULLING_NEGATIVE };
+
+/*
+ * Triangles drawn by Graphics.drawTriangles with a solid or a bitmap fill.
+ * The mesh is rasterized directly instead of being converted to a cairo path
+ * for every triangle.
+ */
+class TriangleMesh: public RefCountable
+{
+public:
+	// copy of the fill active when the triangles were drawn, keeps the bitmap alive
+	FILLSTYLE fill;
+	// x and y of every vertex in local coordinates
+	std::vector<float> positions;
+	// u, v and t of every vertex, empty if the mesh is not textured. t is 1 if it wasn't specified
+	std::vector<float> uvt;
+	// three vertex indices for every triangle, culled triangles are not included
+	std::vector<uint32_t> indices;
+	TriangleMesh(const FILLSTYLE& _fill):fill(_fill) {}
+	bool isTextured() const;
+	void getBounds(number_t& xmin, number_t& xmax, number_t& ymin, number_t& ymax) const;
+	/*
+	 * Draws the triangles into a premultiplied ARGB32 buffer using source over compositing.
+	 * m maps the local coordinates to pixels. Textures are mapped perspective correct.
+	 * It is called by the renderer jobs that already run on the ThreadPool, so it doesn't split the work further
+	 */
+	void rasterize(uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride, const MATRIX& m, bool isMask) const;
+	// returns false if the triangle should be removed by culling
+	static bool isVisible(TRIANGLE_CULLING culling, number_t x0, number_t y0, number_t x1, number_t y1, number_t x2, number_t y2)
+	{
+		number_t cross = (x1-x0)*(y2-y0) - (y1-y0)*(x2-x0);
+		if (culling == CULLING_POSITIVE)
+			return cross <= 0;
+		if (culling == CULLING_NEGATIVE)
+			return cross >= 0;
+		return true;
+	}
+};
+
+}
+#endif /* BACKENDS_TRIANGLEMESH_H */
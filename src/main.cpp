@@ -334,6 +334,12 @@ int main(int argc, char* argv[])
 	char* profilingFileName=nullptr;
 #endif
 	char *HTTPcookie=nullptr;
+	int samplingProfilerPort=0;
+	char* samplingProfilerOutput=nullptr;
+	bool samplingProfilerStart=false;
+	char* traceOutput=nullptr;
+	uint32_t benchmarkFrames=0;
+	char* benchmarkInput=nullptr;
 	SecurityManager::SANDBOXTYPE sandboxType=SecurityManager::LOCAL_WITH_FILE;
 	bool useInterpreter=true;
 	bool useFastInterpreter=false;
@@ -461,6 +467,62 @@ int main(int argc, char* argv[])
 			}
 			HTTPcookie=argv[i];
 		}
+		else if(strcmp(argv[i],"--profiler-port")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			samplingProfilerPort=atoi(argv[i]);
+		}
+		else if(strcmp(argv[i],"--profiler-output")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			samplingProfilerOutput=argv[i];
+		}
+		else if(strcmp(argv[i],"--profiler-start")==0)
+		{
+			samplingProfilerStart=true;
+		}
+		else if(strcmp(argv[i],"--benchmark")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			benchmarkFrames=max(1,atoi(argv[i]));
+			// the benchmark runs without a window, the display objects are still rasterized
+			EngineData::enablerendering = false;
+		}
+		else if(strcmp(argv[i],"--benchmark-input")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			benchmarkInput=argv[i];
+		}
+		else if(strcmp(argv[i],"--trace-output")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=nullptr;
+				break;
+			}
+			traceOutput=argv[i];
+		}
 		else
 		{
 			//No options flag, so set the swf file name
@@ -482,6 +544,8 @@ int main(int argc, char* argv[])
 #endif
 			" [--log-level|-l 0-4] [--parameters-file|-p params-file] [--security-sandbox|-s sandbox]" <<
 			" [--exit-on-error] [--HTTP-cookies cookie] [--air] [--avmplus] [--disable-rendering]" <<
+			" [--profiler-port port] [--profiler-output file] [--profiler-start] [--trace-output file]" <<
+			" [--benchmark frames] [--benchmark-input input-file]" <<
 #ifdef PROFILING_SUPPORT
 			" [--profiling-output|-o profiling-file]" <<
 #endif
@@ -573,6 +637,12 @@ int main(int argc, char* argv[])
 #endif
 	if(HTTPcookie)
 		sys->setCookies(HTTPcookie);
+	if(samplingProfilerPort || samplingProfilerOutput || samplingProfilerStart)
+		sys->enableSamplingProfiler(samplingProfilerPort,samplingProfilerOutput ? samplingProfilerOutput : "",samplingProfilerStart);
+	if(traceOutput)
+		sys->enableTracing(traceOutput);
+	if(benchmarkFrames)
+		sys->enableBenchmark(benchmarkFrames,benchmarkInput ? benchmarkInput : "");
 
 	// create path for shared object local storage
 	char absolutepath[PATH_MAX];
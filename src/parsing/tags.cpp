@@ -654,6 +654,7 @@ DefineFontInfoTag::DefineFontInfoTag(RECORDHEADER h, std::istream& in,RootMovieC
 			fonttag->CodeTable.push_back(t);
 		}
 	}
+	fonttag->buildGlyphIndex();
 	root->registerEmbeddedFont(fonttag->getFontname(),fonttag);
 }
 
@@ -665,6 +666,83 @@ FontTag::FontTag(RECORDHEADER h, int _scaling, RootMovieClip* root):DictionaryTa
 	fillStyles.push_back(fs);
 }
 
+void FontTag::buildGlyphIndex()
+{
+	glyphIndexMap.clear();
+	// the first glyph wins if a code is used more than once
+	for (uint32_t i = 0; i < CodeTable.size(); i++)
+		glyphIndexMap.insert(make_pair(uint32_t(CodeTable[i]),i));
+}
+
+void FontTag::appendGlyphTokens(tokensVector& tokens, uint32_t index, int tokenscaling, int32_t x, int32_t y, const list<FILLSTYLE>& fillstyleColor)
+{
+	const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(index).ShapeRecords;
+	if (tokenscaling == 0)
+	{
+		// all points are the same, so the outlines are joined differently than in the cached tokens
+		MATRIX glyphMatrix(0, 0, 0, 0, x, y);
+		TokenContainer::FromShaperecordListToShapeVector(sr,tokens,fillstyleColor,glyphMatrix);
+		return;
+	}
+	TokenBuffer glyph;
+	{
+		Locker l(glyphTokensMutex);
+		if (glyphTokens.size() != GlyphShapeTable.size())
+		{
+			glyphTokens.resize(GlyphShapeTable.size());
+			glyphTokensValid.resize(GlyphShapeTable.size(),false);
+		}
+		if (!glyphTokensValid[index])
+		{
+			// glyphs only have fills
+			tokensVector tmptokens;
+			TokenContainer::FromShaperecordListToShapeVector(sr,tmptokens,fillStyles);
+			glyphTokens[index] = tmptokens.filltokens;
+			glyphTokensValid[index] = true;
+		}
+		// the copy shares the tokens
+		glyph = glyphTokens[index];
+	}
+	for (auto it = glyph.begin(); it != glyph.end(); ++it)
+	{
+		GeomToken p(*it,false);
+		tokens.filltokens.push_back(p.uval);
+		uint32_t points = 0;
+		switch (p.type)
+		{
+			case SET_FILL:
+			{
+				// use the fill style at the same position in fillstyleColor
+				const FILLSTYLE* style = GeomToken(*(++it),false).fillStyle;
+				auto styleIt = fillstyleColor.begin();
+				for (auto fsIt = fillStyles.begin(); fsIt != fillStyles.end() && &(*fsIt) != style; ++fsIt)
+				{
+					++styleIt;
+					assert(styleIt != fillstyleColor.end());
+				}
+				tokens.filltokens.push_back(GeomToken(*styleIt).uval);
+				break;
+			}
+			case MOVE:
+			case STRAIGHT:
+				points = 1;
+				break;
+			case CURVE_QUADRATIC:
+				points = 2;
+				break;
+			default:
+				LOG(LOG_ERROR,"unexpected token in glyph:"<<p.type);
+				break;
+		}
+		for (uint32_t i = 0; i < points; i++)
+		{
+			GeomToken v(*(++it),false);
+			Vector2 pos(int32_t(int64_t(v.vec.x)*tokenscaling+x), int32_t(int64_t(v.vec.y)*tokenscaling+y));
+			tokens.filltokens.push_back(GeomToken(pos).uval);
+		}
+	}
+}
+
 ASObject* FontTag::instance(Class_base* c)
 { 
 	Class_base* retClass=nullptr;
@@ -685,44 +763,38 @@ const TextureChunk* FontTag::getCharTexture(const CharIterator& chrIt, int fontp
 {
 	assert (*chrIt != 13 && *chrIt != 10);
 	int tokenscaling = fontpixelsize * this->scaling;
-	codetableindex=UINT32_MAX;
-
-	for (unsigned int i = 0; i < CodeTable.size(); i++)
-	{
-		if (CodeTable[i] == *chrIt)
-		{
-			codetableindex=i;
-			auto it = getGlyphShapes().at(i).scaledtexturecache.find(tokenscaling);
-			if (it == getGlyphShapes().at(i).scaledtexturecache.end())
-			{
-				const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
-				number_t ystart = getRenderCharStartYPos()/1024.0f;
-				ystart *=number_t(tokenscaling);
-				MATRIX glyphMatrix(number_t(tokenscaling)/1024.0f, number_t(tokenscaling)/1024.0f, 0, 0,0,ystart);
-				tokensVector tmptokens;
-				TokenContainer::FromShaperecordListToShapeVector(sr,tmptokens,fillStyles,glyphMatrix);
-				number_t xmin, xmax, ymin, ymax;
-				if (!TokenContainer::boundsRectFromTokens(tmptokens,0.05,xmin,xmax,ymin,ymax))
-					return nullptr;
-				std::vector<IDrawable::MaskData> masks;
-				CairoTokenRenderer r(tmptokens,MATRIX()
-							, xmin, ymin, xmax, ymax
-							, xmin, ymin, xmax, ymax,0
-							, 1, 1
-							, false,_NR<DisplayObject>()
-							, 0.05,1.0, masks
-							, 1.0,1.0,1.0,1.0
-							, 0,0,0,0
-							, SMOOTH_MODE::SMOOTH_SUBPIXEL,0,0);
-				uint8_t* buf = r.getPixelBuffer();
-				CharacterRenderer* renderer = new CharacterRenderer(buf,xmax,ymax);
-				getSys()->getRenderThread()->addUploadJob(renderer);
-				it = getGlyphShapes().at(i).scaledtexturecache.insert(make_pair(tokenscaling,renderer)).first;
-			}
-			return &(*it).second->getTexture();
-		}
-	}
-	return nullptr;
+	codetableindex=getGlyphIndex(*chrIt);
+	if (codetableindex == UINT32_MAX)
+		return nullptr;
+	uint32_t i = codetableindex;
+	auto it = getGlyphShapes().at(i).scaledtexturecache.find(tokenscaling);
+	if (it == getGlyphShapes().at(i).scaledtexturecache.end())
+	{
+		const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
+		number_t ystart = getRenderCharStartYPos()/1024.0f;
+		ystart *=number_t(tokenscaling);
+		MATRIX glyphMatrix(number_t(tokenscaling)/1024.0f, number_t(tokenscaling)/1024.0f, 0, 0,0,ystart);
+		tokensVector tmptokens;
+		TokenContainer::FromShaperecordListToShapeVector(sr,tmptokens,fillStyles,glyphMatrix);
+		number_t xmin, xmax, ymin, ymax;
+		if (!TokenContainer::boundsRectFromTokens(tmptokens,0.05,xmin,xmax,ymin,ymax))
+			return nullptr;
+		std::vector<IDrawable::MaskData> masks;
+		CairoTokenRenderer r(tmptokens,MATRIX()
+					, xmin, ymin, xmax, ymax
+					, xmin, ymin, xmax, ymax,0
+					, 1, 1
+					, false,_NR<DisplayObject>()
+					, 0.05,1.0, masks
+					, 1.0,1.0,1.0,1.0
+					, 0,0,0,0
+					, SMOOTH_MODE::SMOOTH_SUBPIXEL,0,0);
+		uint8_t* buf = r.getPixelBuffer();
+		CharacterRenderer* renderer = new CharacterRenderer(buf,xmax,ymax);
+		getSys()->getRenderThread()->addUploadJob(renderer);
+		it = getGlyphShapes().at(i).scaledtexturecache.insert(make_pair(tokenscaling,renderer)).first;
+	}
+	return &(*it).second->getTexture();
 }
 
 bool FontTag::hasGlyphs(const tiny_string text) const
@@ -734,18 +806,9 @@ bool FontTag::hasGlyphs(const tiny_string text) const
 	}
 	for (CharIterator it = text.begin(); it != text.end(); it++)
 	{
-		bool found = false;
 		if (*it <= 0x20)
 			continue;
-		for (unsigned int i = 0; i < CodeTable.size(); i++)
-		{
-			if (CodeTable[i] == *it)
-			{
-				found = true;
-				break;
-			}
-		}
-		if (!found)
+		if (getGlyphIndex(*it) == UINT32_MAX)
 			return false;
 	}
 	return true;
@@ -777,17 +840,8 @@ void DefineFontTag::getTextBounds(const tiny_string& text, int fontpixelsize, nu
 			tmpwidth = 0;
 			height+=tokenscaling;
 		}
-		else
-		{
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
-			{
-				if (CodeTable[i] == *it)
-				{
-					tmpwidth += tokenscaling;
-					break;
-				}
-			}
-		}
+		else if (getGlyphIndex(*it) != UINT32_MAX)
+			tmpwidth += tokenscaling;
 	}
 	if (width < tmpwidth)
 		width = tmpwidth;
@@ -816,6 +870,7 @@ DefineFontTag::DefineFontTag(RECORDHEADER h, std::istream& in, RootMovieClip* ro
 		in >> t;
 		GlyphShapeTable.push_back(t);
 	}
+	buildGlyphIndex();
 	root->registerEmbeddedFont("",this);
 }
 
@@ -835,23 +890,14 @@ void DefineFontTag::fillTextTokens(tokensVector &tokens, const tiny_string text,
 		}
 		else
 		{
-			bool found = false;
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
+			uint32_t i = getGlyphIndex(*it);
+			if (i != UINT32_MAX)
 			{
-				if (CodeTable[i] == *it)
-				{
-					const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
-					Vector2 glyphPos = curPos*tokenscaling;
-					MATRIX glyphMatrix(tokenscaling, tokenscaling, 0, 0,
-							   glyphPos.x+startposx*1024*20,
-							   glyphPos.y);
-					TokenContainer::FromShaperecordListToShapeVector(sr,tokens,fillstyleColor,glyphMatrix);
-					curPos.x += tokenscaling;
-					found = true;
-					break;
-				}
+				Vector2 glyphPos = curPos*tokenscaling;
+				appendGlyphTokens(tokens,i,tokenscaling,glyphPos.x+startposx*1024*20,glyphPos.y,fillstyleColor);
+				curPos.x += tokenscaling;
 			}
-			if (!found)
+			else
 				LOG(LOG_INFO,"DefineFontTag:Character not found:"<<(int)*it<<" "<<text<<" "<<this->getFontname()<<" "<<CodeTable.size());
 		}
 	}
@@ -886,17 +932,13 @@ void DefineFont2Tag::getTextBounds(const tiny_string& text, int fontpixelsize, n
 		}
 		else
 		{
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
-			{
-				if (CodeTable[i] == *it)
-				{
-					if (FontFlagsHasLayout)
-						tmpwidth += number_t(FontAdvanceTable[i])/1024.0 * fontpixelsize;
-					else
-						tmpwidth += tokenscaling;
-					break;
-				}
-			}
+			uint32_t i = getGlyphIndex(*it);
+			if (i == UINT32_MAX)
+				continue;
+			if (FontFlagsHasLayout)
+				tmpwidth += number_t(FontAdvanceTable[i])/1024.0 * fontpixelsize;
+			else
+				tmpwidth += tokenscaling;
 		}
 	}
 	if (width < tmpwidth)
@@ -995,6 +1037,7 @@ DefineFont2Tag::DefineFont2Tag(RECORDHEADER h, std::istream& in, RootMovieClip*
 	}
 	//TODO: implmented Kerning support
 	ignore(in,KerningCount*4);
+	buildGlyphIndex();
 	root->registerEmbeddedFont(getFontname(),this);
 }
 
@@ -1014,26 +1057,17 @@ void DefineFont2Tag::fillTextTokens(tokensVector &tokens, const tiny_string text
 		}
 		else
 		{
-			bool found = false;
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
+			uint32_t i = getGlyphIndex(*it);
+			if (i != UINT32_MAX)
 			{
-				if (CodeTable[i] == *it)
-				{
-					const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
-					Vector2 glyphPos = curPos*tokenscaling;
-					MATRIX glyphMatrix(tokenscaling, tokenscaling, 0, 0,
-							   glyphPos.x+startposx*1024*20,
-							   glyphPos.y);
-					TokenContainer::FromShaperecordListToShapeVector(sr,tokens,fillstyleColor,glyphMatrix);
-					if (FontFlagsHasLayout)
-						curPos.x += FontAdvanceTable[i];
-					else
-						curPos.x += tokenscaling;
-					found = true;
-					break;
-				}
+				Vector2 glyphPos = curPos*tokenscaling;
+				appendGlyphTokens(tokens,i,tokenscaling,glyphPos.x+startposx*1024*20,glyphPos.y,fillstyleColor);
+				if (FontFlagsHasLayout)
+					curPos.x += FontAdvanceTable[i];
+				else
+					curPos.x += tokenscaling;
 			}
-			if (!found)
+			else
 				LOG(LOG_INFO,"DefineFont2Tag:Character not found:"<<(int)*it<<" "<<text<<" "<<this->getFontname()<<" "<<CodeTable.size());
 		}
 	}
@@ -1069,28 +1103,24 @@ void DefineFont3Tag::getTextBounds(const tiny_string& text, int fontpixelsize, n
 		}
 		else
 		{
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
+			uint32_t i = getGlyphIndex(*it);
+			if (i == UINT32_MAX)
+				continue;
+			if (FontFlagsHasLayout)
+				tmpwidth += number_t(FontAdvanceTable[i])/1024.0/20.0 * tokenscaling;
+			else
 			{
-				if (CodeTable[i] == *it)
-				{
-					if (FontFlagsHasLayout)
-						tmpwidth += number_t(FontAdvanceTable[i])/1024.0/20.0 * tokenscaling;
-					else
-					{
-						const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
-						number_t ystart = getRenderCharStartYPos()/1024.0f;
-						ystart *=number_t(tokenscaling);
-						MATRIX glyphMatrix(number_t(tokenscaling)/1024.0f, number_t(tokenscaling)/1024.0f, 0, 0,0,ystart);
-						tokensVector tmptokens;
-						TokenContainer::FromShaperecordListToShapeVector(sr,tmptokens,fillStyles,glyphMatrix);
-						number_t xmin, xmax, ymin, ymax;
-						if (TokenContainer::boundsRectFromTokens(tmptokens,0.05,xmin,xmax,ymin,ymax))
-							tmpwidth += xmax-xmin;
-						else
-							tmpwidth += tokenscaling/2.0;
-					}
-					break;
-				}
+				const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
+				number_t ystart = getRenderCharStartYPos()/1024.0f;
+				ystart *=number_t(tokenscaling);
+				MATRIX glyphMatrix(number_t(tokenscaling)/1024.0f, number_t(tokenscaling)/1024.0f, 0, 0,0,ystart);
+				tokensVector tmptokens;
+				TokenContainer::FromShaperecordListToShapeVector(sr,tmptokens,fillStyles,glyphMatrix);
+				number_t xmin, xmax, ymin, ymax;
+				if (TokenContainer::boundsRectFromTokens(tmptokens,0.05,xmin,xmax,ymin,ymax))
+					tmpwidth += xmax-xmin;
+				else
+					tmpwidth += tokenscaling/2.0;
 			}
 		}
 	}
@@ -1214,6 +1244,7 @@ DefineFont3Tag::DefineFont3Tag(RECORDHEADER h, std::istream& in, RootMovieClip*
 	}
 	//TODO: implment Kerning support
 	ignore(in,KerningCount* (FontFlagsWideCodes ? 6 : 4));
+	buildGlyphIndex();
 	root->registerEmbeddedFont(getFontname(),this);
 
 }
@@ -1233,24 +1264,15 @@ void DefineFont3Tag::fillTextTokens(tokensVector &tokens, const tiny_string text
 		}
 		else
 		{
-			bool found = false;
-			for (unsigned int i = 0; i < CodeTable.size(); i++)
+			uint32_t i = getGlyphIndex(*it);
+			if (i != UINT32_MAX)
 			{
-				if (CodeTable[i] == *it)
-				{
-					const std::vector<SHAPERECORD>& sr = getGlyphShapes().at(i).ShapeRecords;
-					Vector2 glyphPos = curPos*tokenscaling;
-					MATRIX glyphMatrix(tokenscaling, tokenscaling, 0, 0,
-							   glyphPos.x+startposx*1024*20,
-							   glyphPos.y+startposy*1024*20);
-					TokenContainer::FromShaperecordListToShapeVector(sr,tokens,fillstyleColor,glyphMatrix);
-					if (FontFlagsHasLayout)
-						curPos.x += FontAdvanceTable[i];
-					found = true;
-					break;
-				}
+				Vector2 glyphPos = curPos*tokenscaling;
+				appendGlyphTokens(tokens,i,tokenscaling,glyphPos.x+startposx*1024*20,glyphPos.y+startposy*1024*20,fillstyleColor);
+				if (FontFlagsHasLayout)
+					curPos.x += FontAdvanceTable[i];
 			}
-			if (!found)
+			else
 				LOG(LOG_INFO,"DefineFont3Tag:Character not found:"<<(int)*it<<" "<<text<<" "<<this->getFontname()<<" "<<CodeTable.size());
 		}
 	}
@@ -1658,8 +1680,8 @@ void DefineMorphShapeTag::getTokensForRatio(tokensVector& tokens, uint32_t ratio
 		it = tokensmap.insert(make_pair(ratio,tokensVector())).first;
 		TokenContainer::FromDefineMorphShapeTagToShapeVector(this,it->second,ratio);
 	}
-	tokens.filltokens.assign(it->second.filltokens.begin(),it->second.filltokens.end());
-	tokens.stroketokens.assign(it->second.stroketokens.begin(),it->second.stroketokens.end());
+	tokens.filltokens=it->second.filltokens;
+	tokens.stroketokens=it->second.stroketokens;
 }
 
 DefineMorphShape2Tag::DefineMorphShape2Tag(RECORDHEADER h, std::istream& in, RootMovieClip* root):DefineMorphShapeTag(h, root, 2)
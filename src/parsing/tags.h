@@ -23,7 +23,9 @@
 #include "compat.h"
 #include <vector>
 #include <iostream>
+#include <unordered_map>
 #include "swftypes.h"
+#include "threading.h"
 #include "backends/geometry.h"
 #include "backends/decoder.h"
 #include "scripting/flash/display/flashdisplay.h"
@@ -487,6 +489,23 @@ protected:
 	bool FontFlagsBold;
 	virtual number_t getRenderCharStartYPos() const =0;
 	std::list<FILLSTYLE> fillStyles;
+	// index in CodeTable of every character code, has to be rebuilt when CodeTable changes
+	std::unordered_map<uint32_t,uint32_t> glyphIndexMap;
+	/* fill tokens of every glyph with a scaling of 1, converted on first use.
+	 * The coordinates of the glyphs are integers, so scaling and moving the cached
+	 * tokens by integers gives the same tokens as converting the SHAPERECORDs again */
+	std::vector<TokenBuffer> glyphTokens;
+	std::vector<bool> glyphTokensValid;
+	Mutex glyphTokensMutex;
+	void buildGlyphIndex();
+	// returns the index of the glyph for character code in CodeTable, or UINT32_MAX if there is none
+	uint32_t getGlyphIndex(uint32_t code) const
+	{
+		auto it = glyphIndexMap.find(code);
+		return it == glyphIndexMap.end() ? UINT32_MAX : it->second;
+	}
+	// appends the tokens of the glyph at index, scaled by tokenscaling and moved by (x,y), with the fill styles in fillstyleColor
+	void appendGlyphTokens(tokensVector& tokens, uint32_t index, int tokenscaling, int32_t x, int32_t y, const list<FILLSTYLE>& fillstyleColor);
 public:
 	/* Multiply the coordinates of the SHAPEs by this
 	 * value to get a resolution of 1024*20th pixel
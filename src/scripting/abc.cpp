@@ -83,6 +83,7 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/flash/system/flashsystem.h"
 #include "scripting/flash/net/flashnet.h"
+#include "backends/tracing.h"
 
 using namespace std;
 using namespace lightspark;
@@ -990,7 +991,11 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 	//LOG(LOG_INFO,"handleEvent:"<<e.second->type);
 	e.second->check();
 	if(!e.first.isNull())
+	{
+		ProfilerPhaseScope phase(m_sys->samplingProfiler,getWorker(),PROFILER_PHASE_EVENTDISPATCH);
+		TraceSpan span("vm","dispatchEvent",USUALLY_FALSE(Tracer::enabled.load(std::memory_order_relaxed)) ? e.second->getTypeID() : TRACE_NO_DETAIL);
 		publicHandleEvent(e.first.getPtr(), e.second);
+	}
 	else
 	{
 		//Should be handled by the Vm itself
@@ -1101,6 +1106,8 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			{
 				InitFrameEvent* ev=static_cast<InitFrameEvent*>(e.second.getPtr());
 				LOG(LOG_CALLS,"INIT_FRAME");
+				ProfilerPhaseScope phase(m_sys->samplingProfiler,getWorker(),PROFILER_PHASE_INITFRAME);
+				TraceSpan span("vm","initFrame (step 3)");
 				assert(!ev->clip.isNull());
 				ev->clip->initFrame();
 				break;
@@ -1109,6 +1116,8 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			{
 				ExecuteFrameScriptEvent* ev=static_cast<ExecuteFrameScriptEvent*>(e.second.getPtr());
 				LOG(LOG_CALLS,"EXECUTE_FRAMESCRIPT");
+				ProfilerPhaseScope phase(m_sys->samplingProfiler,getWorker(),PROFILER_PHASE_EXECUTEFRAMESCRIPT);
+				TraceSpan span("vm","executeFrameScript (step 5)");
 				assert(!ev->clip.isNull());
 				ev->clip->executeFrameScript();
 				if (ev->clip == m_sys->stage)
@@ -1120,6 +1129,8 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 				Locker l(m_sys->getRenderThread()->mutexRendering);
 				AdvanceFrameEvent* ev=static_cast<AdvanceFrameEvent*>(e.second.getPtr());
 				LOG(LOG_CALLS,"ADVANCE_FRAME");
+				ProfilerPhaseScope phase(m_sys->samplingProfiler,getWorker(),PROFILER_PHASE_ADVANCEFRAME);
+				TraceSpan span("vm","advanceFrame (steps 0-1)");
 				if (ev->clip)
 					ev->clip->advanceFrame();
 				else
@@ -1137,6 +1148,7 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			{
 				// DisplayObjects that are removed from the display list keep their Parent set until all removedFromStage events are handled
 				// see http://www.senocular.com/flash/tutorials/orderofoperations/#ObjectDestruction
+				TraceSpan span("vm","idle cleanup (step 9)");
 				m_sys->resetParentList();
 				{
 					Locker l(event_queue_mutex);
@@ -1156,6 +1168,8 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			case FLUSH_INVALIDATION_QUEUE:
 			{
 				//Flush the invalidation queue
+				ProfilerPhaseScope phase(m_sys->samplingProfiler,getWorker(),PROFILER_PHASE_FLUSHINVALIDATION);
+				TraceSpan span("vm","flushInvalidationQueue");
 				m_sys->flushInvalidationQueue();
 				break;
 			}
@@ -1275,6 +1289,21 @@ void ABCVm::addIdleEvent(_NR<EventDispatcher> obj ,_R<Event> ev)
 	RELEASE_WRITE(ev->queued,true);
 }
 
+/*! \brief coalesce mouse events: update the data of an event that is still waiting in the idle event queue
+* * the event is only updated if it is the last one in the queue, so the order of the events is not changed
+* * \return false if the event is not waiting at the end of the idle event queue for obj */
+bool ABCVm::updatePendingMouseEvent(EventDispatcher* obj, MouseEvent* ev, number_t localX, number_t localY, SDL_Keymod modifiers, bool buttonDown)
+{
+	Locker l(event_queue_mutex);
+	if(shuttingdown || idleevents_queue.empty())
+		return false;
+	const eventType& last = idleevents_queue.back();
+	if (last.first.getPtr() != obj || last.second.getPtr() != ev)
+		return false;
+	ev->updateMouseState(localX,localY,modifiers,buttonDown);
+	return true;
+}
+
 Class_inherit* ABCVm::findClassInherit(const string& s, RootMovieClip* root)
 {
 	LOG(LOG_CALLS,"Setting class name to " << s);
@@ -1557,6 +1586,7 @@ int ABCVm::Run(void* d)
 
 	/* set TLS variable for isVmThread() */
 	tls_set(is_vm_thread, GINT_TO_POINTER(1));
+	Tracer::setThreadName("ABCVm");
 #ifndef NDEBUG
 	inStartupOrClose= false;
 #endif
@@ -1392,6 +1392,7 @@ public:
 	bool addEvent(_NR<EventDispatcher>,_R<Event>, bool isGlobalMessage=false) DLL_PUBLIC;
 	bool prependEvent(_NR<EventDispatcher>, _R<Event> , bool force=false) DLL_PUBLIC;
 	void addIdleEvent(_NR<EventDispatcher>,_R<Event> ) DLL_PUBLIC;
+	bool updatePendingMouseEvent(EventDispatcher* obj, MouseEvent* ev, number_t localX, number_t localY, SDL_Keymod modifiers, bool buttonDown);
 	int getEventQueueSize();
 	void shutdown();
 	bool hasEverStarted() const { return status!=CREATED; }
@@ -35,4 +35,5 @@ void ABCVm::registerClassesFlashGeom(Global* builtin)
 	builtin->registerBuiltin("Matrix3D","flash.geom",Class<Matrix3D>::getRef(m_sys));
 	builtin->registerBuiltin("Orientation3D","flash.geom",Class<Orientation3D>::getRef(m_sys));
 	builtin->registerBuiltin("PerspectiveProjection","flash.geom",Class<PerspectiveProjection>::getRef(m_sys));
+	builtin->registerBuiltin("Utils3D","flash.geom",Class<Utils3D>::getRef(m_sys));
 }
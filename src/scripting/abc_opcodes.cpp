@@ -2602,6 +2602,8 @@ bool ABCVm::newClassRecursiveLink(Class_base* target, Class_base* c)
 		LOG_CALL("Linking with interface " << interfaces[i]->class_name);
 		interfaces[i]->linkInterface(target);
 	}
+	if (target==c)
+		target->buildInterfaceBits();
 	return true;
 }
 
@@ -23,13 +23,14 @@
 #include "scripting/flash/filters/flashfilters.h"
 #include "backends/rendering.h"
 #include "backends/image.h"
+#include "backends/pixelops.h"
 #include "swf.h"
 
 using namespace std;
 using namespace lightspark;
 
 BitmapContainer::BitmapContainer(MemoryAccount* m):stride(0),width(0),height(0),
-	data(reporter_allocator<uint8_t>(m))
+	data(reporter_allocator<uint8_t>(m)),uploadPending(false)
 {
 }
 
@@ -78,6 +79,7 @@ bool BitmapContainer::fromRGB(uint8_t* rgb, uint32_t w, uint32_t h, BITMAP_FORMA
 	else
 		CairoRenderer::convertBitmapToCairo(data, rgb, width, height, &dataSize, &stride, format==RGB15 ? 2 : (format==RGB24 ? 3 : 4));
 	delete[] rgb;
+	markDirty();
 	if(data.empty())
 	{
 		LOG(LOG_ERROR, "Error decoding image");
@@ -153,6 +155,17 @@ void BitmapContainer::clear()
 	width=0;
 	height=0;
 	bitmaptexture.makeEmpty();
+	dirtyRect=RECT();
+	Locker l(uploadMutex);
+	uploadRect=RECT();
+}
+
+void BitmapContainer::markDirty(const RECT& r)
+{
+	RECT clippedRect;
+	clipRect(r, clippedRect);
+	if (clippedRect.Xmin < clippedRect.Xmax && clippedRect.Ymin < clippedRect.Ymax)
+		addDirtyRect(clippedRect.Xmin,clippedRect.Ymin,clippedRect.Xmax,clippedRect.Ymax);
 }
 
 uint8_t* BitmapContainer::upload(bool refresh)
@@ -165,8 +178,27 @@ TextureChunk& BitmapContainer::getTexture()
 	return bitmaptexture;
 }
 
+bool BitmapContainer::getUploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h)
+{
+	Locker l(uploadMutex);
+	// changes made from now on need a new upload
+	uploadPending=false;
+	if (uploadRect.Xmin >= uploadRect.Xmax || uploadRect.Ymin >= uploadRect.Ymax)
+		return false;
+	x=uploadRect.Xmin;
+	y=uploadRect.Ymin;
+	w=uploadRect.Xmax-uploadRect.Xmin;
+	h=uploadRect.Ymax-uploadRect.Ymin;
+	uploadRect=RECT();
+	return true;
+}
+
 void BitmapContainer::uploadFence()
 {
+	{
+		Locker l(uploadMutex);
+		uploadPending=false;
+	}
 	decRef();// is increffed in checkTexture
 }
 bool BitmapContainer::checkTexture()
@@ -178,6 +210,27 @@ bool BitmapContainer::checkTexture()
 	if (!bitmaptexture.isValid())
 	{
 		bitmaptexture=getSys()->getRenderThread()->allocateTexture(width, height, true);
+		markDirty();
+	}
+	{
+		Locker l(uploadMutex);
+		if (dirtyRect.Xmin < dirtyRect.Xmax && dirtyRect.Ymin < dirtyRect.Ymax)
+		{
+			if (uploadRect.Xmin >= uploadRect.Xmax || uploadRect.Ymin >= uploadRect.Ymax)
+				uploadRect=dirtyRect;
+			else
+			{
+				uploadRect.Xmin=imin(uploadRect.Xmin,dirtyRect.Xmin);
+				uploadRect.Xmax=imax(uploadRect.Xmax,dirtyRect.Xmax);
+				uploadRect.Ymin=imin(uploadRect.Ymin,dirtyRect.Ymin);
+				uploadRect.Ymax=imax(uploadRect.Ymax,dirtyRect.Ymax);
+			}
+			dirtyRect=RECT();
+		}
+		// nothing changed or the pending upload will pick up the changes
+		if (uploadPending || uploadRect.Xmin >= uploadRect.Xmax || uploadRect.Ymin >= uploadRect.Ymax)
+			return false;
+		uploadPending=true;
 	}
 	incRef();// is decreffed in uploadFence
 	return true;
@@ -190,6 +243,7 @@ void BitmapContainer::setAlpha(int32_t x, int32_t y, uint8_t alpha)
 
 	uint32_t *p=reinterpret_cast<uint32_t *>(&data[y*stride + 4*x]);
 	*p = ((uint32_t)alpha << 24) + (*p & 0xFFFFFF);
+	addDirtyRect(x,y,x+1,y+1);
 }
 
 void BitmapContainer::setPixel(int32_t x, int32_t y, uint32_t color, bool setAlpha, bool ispremultiplied)
@@ -215,6 +269,7 @@ void BitmapContainer::setPixel(int32_t x, int32_t y, uint32_t color, bool setAlp
 	}
 	else
 		*p=(*p & 0xff000000) | (color & 0x00ffffff);
+	addDirtyRect(x,y,x+1,y+1);
 }
 
 uint32_t BitmapContainer::getPixel(int32_t x, int32_t y,bool premultiplied) const
@@ -259,6 +314,7 @@ void BitmapContainer::copyRectangle(_R<BitmapContainer> source,
 
 	if (copyWidth <= 0 || copyHeight <= 0)
 		return;
+	addDirtyRect(clippedX,clippedY,clippedX+copyWidth,clippedY+copyHeight);
 	int sx = clippedSourceRect.Xmin;
 	int sy = clippedSourceRect.Ymin;
 	if (mergeAlpha==false)
@@ -271,24 +327,26 @@ void BitmapContainer::copyRectangle(_R<BitmapContainer> source,
 				4*copyWidth);
 		}
 	}
-	else
+	else if (source.getPtr() == this)
 	{
-		uint8_t* sourcedata = &source->data[0];
-		bool needsdeletion = false;
-		if (sourcedata == &data[0])
+		// only one row of the source is copied, the rows are processed
+		// in an order that doesn't overwrite source rows not yet processed
+		vector<uint32_t> rowBuffer(copyWidth);
+		bool bottomUp = clippedY > sy;
+		for (int i=0; i<copyHeight; i++)
 		{
-			// cairo doesn't work if source and destination buffers are the same 
-			sourcedata = new uint8_t[data.size()];
-			memcpy (sourcedata,&data[0],data.size());
-			needsdeletion = true;
+			int row = bottomUp ? copyHeight-i-1 : i;
+			memcpy(&rowBuffer[0],getPixelRow(sy+row,sx),4*copyWidth);
+			PixelOps::sourceOver(getPixelRow(clippedY+row,clippedX),&rowBuffer[0],copyWidth);
 		}
-		//Slow path using Cairo
-		CairoRenderContext ctxt(&data[0], width, height,false);
-		ctxt.simpleBlit(clippedX, clippedY, sourcedata,
-				source->getWidth(), source->getHeight(),
-				sx, sy, copyWidth, copyHeight);
-		if (needsdeletion)
-			delete[] sourcedata;
+	}
+	else
+	{
+		PixelOps::forEachRow(getSys(),copyHeight,copyWidth,[&](uint32_t first, uint32_t last)
+		{
+			for (uint32_t row=first; row<last; row++)
+				PixelOps::sourceOver(getPixelRow(clippedY+row,clippedX),source->getPixelRow(sy+row,sx),copyWidth);
+		});
 	}
 }
 
@@ -302,12 +360,16 @@ void BitmapContainer::applyFilter(_R<BitmapContainer> source,
 	int32_t clippedY;
 	clipRect(source, sourceRect, destX, destY, clippedSourceRect, clippedX, clippedY);
 	filter->applyFilter(this,source.getPtr(),clippedSourceRect,destX,destY,1.0,1.0);
+	// blur borders and shadow offsets may write outside of the destination rectangle
+	markDirty();
 }
 
 void BitmapContainer::fillRectangle(const RECT& inputRect, uint32_t color, bool useAlpha)
 {
 	RECT clippedRect;
 	clipRect(inputRect, clippedRect);
+	if (clippedRect.Xmin < clippedRect.Xmax && clippedRect.Ymin < clippedRect.Ymax)
+		addDirtyRect(clippedRect.Xmin,clippedRect.Ymin,clippedRect.Xmax,clippedRect.Ymax);
 
 	for(int32_t y=clippedRect.Ymin;y<clippedRect.Ymax;y++)
 	{
@@ -336,6 +398,8 @@ bool BitmapContainer::scroll(int32_t x, int32_t y)
 
 	if (copyWidth <= 0 && copyHeight <= 0)
 		return false;
+	if (copyWidth > 0 && copyHeight > 0)
+		addDirtyRect(destX,destY,destX+copyWidth,destY+copyHeight);
 
 	uint8_t *dataBase = &data[0];
 	for(int i=0; i<copyHeight; i++)
@@ -384,6 +448,9 @@ void BitmapContainer::floodFill(int32_t startX, int32_t startY, uint32_t color)
 		return;
 
 	uint32_t seedColor = getPixel(startX, startY);
+	// bounding box of the filled pixels
+	int32_t fillXmin = startX, fillXmax = startX;
+	int32_t fillYmin = startY, fillYmax = startY;
 
 	// Comment on the codeproject.com: "needed in some cases" ???
 	segments.push(LineSegment(startX, startX, startY+1, 1));
@@ -414,6 +481,12 @@ void BitmapContainer::floodFill(int32_t startX, int32_t startY, uint32_t color)
 			p--;
 			t--;
 		}
+		if (t < r.x1)
+		{
+			fillXmin = imin(fillXmin, t+1);
+			fillYmin = imin(fillYmin, r.y);
+			fillYmax = imax(fillYmax, r.y);
+		}
 
 		if (t >= r.x1)
 		{
@@ -444,12 +517,19 @@ void BitmapContainer::floodFill(int32_t startX, int32_t startY, uint32_t color)
 		do
 		{
 			p = getDataNoBoundsChecking(t, r.y);
+			int32_t fillStart = t;
 			while (t < width && *p == seedColor)
 			{
 				*p = color;
 				p++;
 				t++;
 			}
+			if (t > fillStart)
+			{
+				fillXmax = imax(fillXmax, t-1);
+				fillYmin = imin(fillYmin, r.y);
+				fillYmax = imax(fillYmax, r.y);
+			}
 
 			// push the segment on the next line
 			if (t >= left+1)
@@ -475,6 +555,7 @@ void BitmapContainer::floodFill(int32_t startX, int32_t startY, uint32_t color)
 		}
 		while (t <= r.x2);
 	}
+	addDirtyRect(fillXmin,fillYmin,fillXmax+1,fillYmax+1);
 }
 
 void BitmapContainer::clipRect(const RECT& sourceRect, RECT& clippedRect) const
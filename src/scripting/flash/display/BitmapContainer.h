@@ -24,6 +24,7 @@
 #include "memory_support.h"
 #include "smartrefs.h"
 #include "swftypes.h"
+#include "threading.h"
 #include <vector>
 #include "backends/graphics.h"
 
@@ -45,6 +46,31 @@ protected:
 	// buffer to contain the 
 	std::vector<uint8_t> data_colortransformed;
 	uint32_t *getDataNoBoundsChecking(int32_t x, int32_t y) const;
+	/* the region changed since the last call to checkTexture, only
+	 * accessed by the thread modifying the pixels. It is moved to
+	 * uploadRect when the upload is requested, so all changes done while
+	 * the BitmapData is locked are uploaded at once */
+	RECT dirtyRect;
+	// region to be uploaded by the render thread, protected by uploadMutex
+	Mutex uploadMutex;
+	RECT uploadRect;
+	// true if the container is in the upload queue of the render thread
+	bool uploadPending;
+	inline void addDirtyRect(int32_t xmin, int32_t ymin, int32_t xmax, int32_t ymax)
+	{
+		if (dirtyRect.Xmin >= dirtyRect.Xmax || dirtyRect.Ymin >= dirtyRect.Ymax)
+		{
+			dirtyRect.Xmin = xmin;
+			dirtyRect.Xmax = xmax;
+			dirtyRect.Ymin = ymin;
+			dirtyRect.Ymax = ymax;
+			return;
+		}
+		dirtyRect.Xmin = imin(dirtyRect.Xmin,xmin);
+		dirtyRect.Xmax = imax(dirtyRect.Xmax,xmax);
+		dirtyRect.Ymin = imin(dirtyRect.Ymin,ymin);
+		dirtyRect.Ymax = imax(dirtyRect.Ymax,ymax);
+	}
 public:
 	TextureChunk bitmaptexture;
 	BitmapContainer(MemoryAccount* m);
@@ -52,6 +78,9 @@ public:
 	uint32_t getDataSize() const { return data.size(); }
 	uint8_t* getData() { return &data[0]; }
 	const uint8_t* getData() const { return &data[0]; }
+	// pointer to the pixel at (x,y) without bounds checking
+	uint32_t* getPixelRow(int32_t y, int32_t x=0) { return (uint32_t*)&data[y*stride + 4*x]; }
+	const uint32_t* getPixelRow(int32_t y, int32_t x=0) const { return (const uint32_t*)&data[y*stride + 4*x]; }
 	uint8_t* getDataColorTransformed() 
 	{
 		data_colortransformed.reserve(data.size());
@@ -91,13 +120,19 @@ public:
 	void floodFill(int32_t x, int32_t y, uint32_t color);
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
+	size_t getStride() const { return stride; }
 	bool isEmpty() const { return data.empty(); }
 	void clear();
+	// marks a region of the pixels as changed, it will be uploaded to the texture on the next upload
+	void markDirty(const RECT& r);
+	// marks all pixels as changed
+	void markDirty() { addDirtyRect(0,0,width,height); }
 
 	//ITextureUploadable interface
 	void sizeNeeded(uint32_t& w, uint32_t& h) const override { w=width; h=height; }
 	uint8_t* upload(bool refresh) override;
 	TextureChunk& getTexture() override;
+	bool getUploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h) override;
 	void uploadFence() override;
 
 	bool checkTexture();
@@ -30,14 +30,49 @@
 #include "scripting/flash/utils/ByteArray.h"
 #include "scripting/flash/filters/flashfilters.h"
 #include "scripting/flash/system/flashsystem.h"
+#include "scripting/flash/display/pngencoderoptions.h"
+#include "scripting/flash/display/jpegencoderoptions.h"
+#include "scripting/flash/display/jpegxrencoderoptions.h"
 #include "backends/rendering.h"
-#include "3rdparty/perlinnoise/PerlinNoise.hpp"
+#include "backends/pixelops.h"
+#include "backends/image.h"
 
 #include <cstdlib> 
 
 using namespace lightspark;
 using namespace std;
 
+namespace
+{
+/*
+ * Access to the rows of a source rectangle. If source and destination are the
+ * same bitmap the rectangle is copied, so the rows can be processed in any order
+ */
+class SourceRows
+{
+private:
+	BitmapContainer* source;
+	RECT rect;
+	vector<uint32_t> copy;
+public:
+	SourceRows(BitmapContainer* s, BitmapContainer* dest, const RECT& r):source(s),rect(r)
+	{
+		if (s != dest)
+			return;
+		uint32_t w = rect.Xmax-rect.Xmin;
+		copy.resize(w*(rect.Ymax-rect.Ymin));
+		for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
+			memcpy(&copy[(y-rect.Ymin)*w],source->getPixelRow(y,rect.Xmin),w*4);
+	}
+	const uint32_t* getRow(uint32_t y) const
+	{
+		if (!copy.empty())
+			return &copy[y*(rect.Xmax-rect.Xmin)];
+		return source->getPixelRow(rect.Ymin+y,rect.Xmin);
+	}
+};
+}
+
 BitmapData::BitmapData(ASWorker* wrk, Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_BITMAPDATA),pixels(_MR(new BitmapContainer(c->memoryAccount))),locked(0),transparent(true)
 {
 }
@@ -101,8 +136,9 @@ void BitmapData::sinit(Class_base* c)
 	c->setDeclaredMethodByQName("noise","",Class<IFunction>::getFunction(c->getSystemState(),noise),NORMAL_METHOD,true);
 	c->setDeclaredMethodByQName("perlinNoise","",Class<IFunction>::getFunction(c->getSystemState(),perlinNoise),NORMAL_METHOD,true);
 	c->setDeclaredMethodByQName("threshold","",Class<IFunction>::getFunction(c->getSystemState(),threshold),NORMAL_METHOD,true);
-	c->setDeclaredMethodByQName("merge","",Class<IFunction>::getFunction(c->getSystemState(),threshold),NORMAL_METHOD,true);
+	c->setDeclaredMethodByQName("merge","",Class<IFunction>::getFunction(c->getSystemState(),merge),NORMAL_METHOD,true);
 	c->setDeclaredMethodByQName("paletteMap","",Class<IFunction>::getFunction(c->getSystemState(),paletteMap),NORMAL_METHOD,true);
+	c->setDeclaredMethodByQName("encode","",Class<IFunction>::getFunction(c->getSystemState(),encode,2,Class<ByteArray>::getRef(c->getSystemState()).getPtr()),NORMAL_METHOD,true);
 	// properties
 	c->setDeclaredMethodByQName("height","",Class<IFunction>::getFunction(c->getSystemState(),_getHeight,0,Class<Integer>::getRef(c->getSystemState()).getPtr()),GETTER_METHOD,true);
 	c->setDeclaredMethodByQName("rect","",Class<IFunction>::getFunction(c->getSystemState(),getRect,0,Class<Rectangle>::getRef(c->getSystemState()).getPtr()),GETTER_METHOD,true);
@@ -294,6 +330,7 @@ void BitmapData::drawDisplayObject(DisplayObject* d, const MATRIX& initialMatrix
 		delete drawable;
 	}
 	d->Render(ctxt,true);
+	pixels->markDirty();
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,draw)
@@ -331,8 +368,23 @@ ASFUNCTIONBODY_ATOM(BitmapData,draw)
 		ctxt.transformedBlit(initialMatrix, data->pixels->getData(),
 				data->pixels->getWidth(), data->pixels->getHeight(),
 				CairoRenderContext::FILTER_NONE);
+		// only the transformed bounds of the source are changed
+		number_t xmin=0,xmax=0,ymin=0,ymax=0;
+		for (uint32_t i=0; i < 4; i++)
+		{
+			number_t x,y;
+			initialMatrix.multiply2D(i&1 ? data->pixels->getWidth() : 0,i&2 ? data->pixels->getHeight() : 0,x,y);
+			xmin = i ? min(xmin,x) : x;
+			xmax = i ? max(xmax,x) : x;
+			ymin = i ? min(ymin,y) : y;
+			ymax = i ? max(ymax,y) : y;
+		}
+		th->pixels->markDirty(RECT(floor(xmin),ceil(xmax)+1,floor(ymin),ceil(ymax)+1));
 		if (ctransform)
+		{
 			ctransform->applyTransformation(data->pixels->getData(),data->getBitmapContainer()->getWidth()*data->getBitmapContainer()->getHeight()*4);
+			data->pixels->markDirty();
+		}
 	}
 	else if(drawable->is<DisplayObject>())
 	{
@@ -343,7 +395,10 @@ ASFUNCTIONBODY_ATOM(BitmapData,draw)
 			initialMatrix=matrix->getMATRIX();
 		d->DrawToBitmap(th,initialMatrix,smoothing,false);
 		if (ctransform)
+		{
 			ctransform->applyTransformation(th->pixels->getData(),th->getBitmapContainer()->getWidth()*th->getBitmapContainer()->getHeight()*4);
+			th->pixels->markDirty();
+		}
 	}
 	else
 		LOG(LOG_NOT_IMPLEMENTED,"BitmapData.draw does not support " << drawable->toDebugString());
@@ -622,7 +677,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,copyChannel)
 	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
 	if(th->pixels.isNull())
 		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
-	
+
 	_NR<BitmapData> source;
 	_NR<Rectangle> sourceRect;
 	_NR<Point> destPoint;
@@ -649,28 +704,26 @@ ASFUNCTIONBODY_ATOM(BitmapData,copyChannel)
 	int regionWidth = clippedSourceRect.Xmax - clippedSourceRect.Xmin;
 	int regionHeight = clippedSourceRect.Ymax - clippedSourceRect.Ymin;
 
-	if (regionWidth < 0 || regionHeight < 0)
+	if (regionWidth <= 0 || regionHeight <= 0)
 		return;
 
-	uint32_t constantChannelsMask = ~(0xFF << destShift);
-	for (int32_t y=0; y<regionHeight; y++)
+	SourceRows sourceRows(source->pixels.getPtr(), th->pixels.getPtr(), clippedSourceRect);
+	BitmapContainer* dest = th->pixels.getPtr();
+	// the channels are copied between the pixels with straight alpha
+	PixelOps::forEachRow(wrk->getSystemState(),regionHeight,regionWidth,[&](uint32_t first, uint32_t last)
 	{
-		for (int32_t x=0; x<regionWidth; x++)
+		vector<uint32_t> srcRow(regionWidth);
+		vector<uint32_t> dstRow(regionWidth);
+		for (uint32_t y=first; y<last; y++)
 		{
-			int32_t sx = clippedSourceRect.Xmin+x;
-			int32_t sy = clippedSourceRect.Ymin+y;
-			uint32_t sourcePixel = source->pixels->getPixel(sx, sy,false);
-			uint32_t channel = (sourcePixel >> sourceShift) & 0xFF;
-			int32_t dx = clippedDestX + x;
-			int32_t dy = clippedDestY + y;
-			uint32_t oldPixel = th->pixels->getPixel(dx, dy,sourceChannel == BitmapDataChannel::ALPHA);
-			uint32_t destChannelValue = channel << destShift;
-
-			uint32_t newColor = ((oldPixel & constantChannelsMask) | destChannelValue);
-			th->pixels->setPixel(dx, dy, newColor, true,sourceChannel == BitmapDataChannel::ALPHA);
+			uint32_t* d = dest->getPixelRow(clippedDestY+y,clippedDestX);
+			PixelOps::unpremultiply(&srcRow[0],sourceRows.getRow(y),regionWidth);
+			PixelOps::unpremultiply(&dstRow[0],d,regionWidth);
+			PixelOps::copyChannel(&dstRow[0],&srcRow[0],regionWidth,sourceShift,destShift);
+			PixelOps::premultiply(d,&dstRow[0],regionWidth);
 		}
-	}
-
+	});
+	th->pixels->markDirty(RECT(clippedDestX,clippedDestX+regionWidth,clippedDestY,clippedDestY+regionHeight));
 	th->notifyUsers();
 }
 
@@ -731,17 +784,11 @@ ASFUNCTIONBODY_ATOM(BitmapData,histogram)
 		th->pixels->clipRect(inputRect->getRect(), rect);
 	}
 
-	unsigned int counts[4][256] = {{0}};
-	for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
+	uint32_t counts[4][256] = {{0}};
+	if (rect.Xmax > rect.Xmin)
 	{
 		for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
-		{
-			uint32_t pixel = th->pixels->getPixel(x, y);
-			for (int i=0; i<4; i++)
-			{
-				counts[i][(pixel >> (8*i)) & 0xFF]++;
-			}
-		}
+			PixelOps::histogram(counts, th->pixels->getPixelRow(y, rect.Xmin), rect.Xmax-rect.Xmin);
 	}
 
 	asAtom v=asAtomHandler::invalidAtom;
@@ -780,23 +827,19 @@ ASFUNCTIONBODY_ATOM(BitmapData,getColorBoundsRect)
 	int xmax = 0;
 	int ymin = th->getHeight();
 	int ymax = 0;
-	for (int32_t x=0; x<th->getWidth(); x++)
+	for (int32_t y=0; y<th->getHeight(); y++)
 	{
-		for (int32_t y=0; y<th->getHeight(); y++)
+		uint32_t first;
+		uint32_t last;
+		if (PixelOps::findColor(th->pixels->getPixelRow(y), th->getWidth(), mask, color, findColor, first, last))
 		{
-			uint32_t pixel = th->pixels->getPixel(x, y);
-			if ((findColor && ((pixel & mask) == color)) ||
-			    (!findColor && ((pixel & mask) != color)))
-			{
-				if (x < xmin)
-					xmin = x;
-				if (x > xmax)
-					xmax = x;
-				if (y < ymin)
-					ymin = y;
-				if (y > ymax)
-					ymax = y;
-			}
+			if ((int)first < xmin)
+				xmin = first;
+			if ((int)last > xmax)
+				xmax = last;
+			if (y < ymin)
+				ymin = y;
+			ymax = y;
 		}
 	}
 
@@ -825,9 +868,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,getPixels)
 
 	ByteArray *ba = Class<ByteArray>::getInstanceS(wrk);
 	vector<uint32_t> pixelvec = th->pixels->getPixelVector(rect->getRect());
-	vector<uint32_t>::const_iterator it;
-	for (it=pixelvec.begin(); it!=pixelvec.end(); ++it)
-		ba->writeUnsignedInt(ba->endianIn(*it));
+	ba->writeUnsignedInts(pixelvec.data(),pixelvec.size());
 	ret = asAtomHandler::fromObject(ba);
 }
 
@@ -875,8 +916,16 @@ ASFUNCTIONBODY_ATOM(BitmapData,setPixels)
 	RECT rect;
 	th->pixels->clipRect(inputRect->getRect(), rect);
 
+	vector<uint32_t> row(max(rect.Xmax-rect.Xmin,0));
 	for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
 	{
+		// read complete rows at once, only fall back to single pixels at the end of the ByteArray
+		if (inputByteArray->readUnsignedInts(row.data(),row.size()))
+		{
+			for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
+				th->pixels->setPixel(x, y, row[x-rect.Xmin], th->transparent);
+			continue;
+		}
 		for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
 		{
 			uint32_t pixel;
@@ -926,7 +975,9 @@ ASFUNCTIONBODY_ATOM(BitmapData,setVector)
 ASFUNCTIONBODY_ATOM(BitmapData,colorTransform)
 {
 	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
-	
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
 	_NR<Rectangle> inputRect;
 	_NR<ColorTransform> inputColorTransform;
 	ARG_UNPACK_ATOM (inputRect) (inputColorTransform);
@@ -938,42 +989,37 @@ ASFUNCTIONBODY_ATOM(BitmapData,colorTransform)
 
 	RECT rect;
 	th->pixels->clipRect(inputRect->getRect(), rect);
-	
-	vector<uint32_t> pixelvec = th->pixels->getPixelVector(rect);
+	int32_t width = rect.Xmax-rect.Xmin;
+	int32_t height = rect.Ymax-rect.Ymin;
+	if (width <= 0 || height <= 0)
+		return;
 
-	unsigned int i = 0;
-	for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
+	// in memory order of the channels
+	const float mul[4] = { float(inputColorTransform->blueMultiplier), float(inputColorTransform->greenMultiplier),
+			       float(inputColorTransform->redMultiplier), float(inputColorTransform->alphaMultiplier) };
+	const float off[4] = { float(inputColorTransform->blueOffset), float(inputColorTransform->greenOffset),
+			       float(inputColorTransform->redOffset), float(inputColorTransform->alphaOffset) };
+	bool keepAlpha = !th->transparent;
+	BitmapContainer* pixels = th->pixels.getPtr();
+	// the transformation is applied to the pixels with straight alpha
+	PixelOps::forEachRow(wrk->getSystemState(),height,width,[&](uint32_t first, uint32_t last)
 	{
-		for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
+		vector<uint32_t> row(width);
+		for (uint32_t y=first; y<last; y++)
 		{
-
-			uint32_t pixel = pixelvec[i];
-
-			int a, r, g, b;
-			a = ((pixel >> 24 )&0xff) * inputColorTransform->alphaMultiplier + inputColorTransform->alphaOffset;
-			if (a > 255) a = 255;
-			if (a < 0) a = 0;
-			r = ((pixel >> 16 )&0xff) * inputColorTransform->redMultiplier + inputColorTransform->redOffset;
-			if (r > 255) r = 255;
-			if (r < 0) r = 0;
-			g = ((pixel >> 8 )&0xff) * inputColorTransform->greenMultiplier + inputColorTransform->greenOffset;
-			if (g > 255) g = 255;
-			if (g < 0) g = 0;
-			b = ((pixel )&0xff) * inputColorTransform->blueMultiplier + inputColorTransform->blueOffset;
-			if (b > 255) b = 255;
-			if (b < 0) b = 0;
-			
-			pixel = (a<<24) | (r<<16) | (g<<8) | b;
-			
-			th->pixels->setPixel(x, y, pixel, th->transparent);
-			i++;
+			uint32_t* d = pixels->getPixelRow(rect.Ymin+y,rect.Xmin);
+			PixelOps::unpremultiply(&row[0],d,width);
+			PixelOps::colorTransform(&row[0],width,mul,off,keepAlpha);
+			PixelOps::premultiply(d,&row[0],width);
 		}
-	}
+	});
+	th->pixels->markDirty(rect);
+	th->notifyUsers();
 }
 ASFUNCTIONBODY_ATOM(BitmapData,compare)
 {
 	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
-	
+
 	_NR<BitmapData> otherBitmapData;
 	ARG_UNPACK_ATOM (otherBitmapData);
 
@@ -990,44 +1036,42 @@ ASFUNCTIONBODY_ATOM(BitmapData,compare)
 		asAtomHandler::setInt(ret,wrk,-4);
 		return;
 	}
-	RECT rect;
-	rect.Xmin = 0;
-	rect.Xmax = th->getWidth();
-	rect.Ymin = 0;
-	rect.Ymax = th->getHeight();
-	
-	vector<uint32_t> pixelvec = th->pixels->getPixelVector(rect);
-	vector<uint32_t> otherpixelvec = otherBitmapData->pixels->getPixelVector(rect);
-	
-	BitmapData* res = Class<BitmapData>::getInstanceS(wrk,rect.Xmax,rect.Ymax);
-	unsigned int i = 0;
+	int32_t width = th->getWidth();
+	int32_t height = th->getHeight();
+
+	BitmapData* res = Class<BitmapData>::getInstanceS(wrk,width,height);
 	bool different = false;
-	for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
+	for (int32_t y=0; y<height; y++)
 	{
-		for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
+		const uint32_t* row = th->pixels->getPixelRow(y);
+		const uint32_t* otherrow = otherBitmapData->pixels->getPixelRow(y);
+		// skip equal rows, the result is initialized to 0
+		if (memcmp(row,otherrow,width*4) == 0)
+			continue;
+		different = true;
+		uint32_t* resrow = res->pixels->getPixelRow(y);
+		for (int32_t x=0; x<width; x++)
 		{
-
-			uint32_t pixel = pixelvec[i];
-			uint32_t otherpixel = otherpixelvec[i];
+			uint32_t pixel = row[x];
+			uint32_t otherpixel = otherrow[x];
 			if (pixel == otherpixel)
-				res->pixels->setPixel(x, y, 0, true);
+				resrow[x] = 0;
 			else if ((pixel & 0x00FFFFFF) == (otherpixel & 0x00FFFFFF))
-			{
-				different = true;
-				res->pixels->setPixel(x, y, ((pixel & 0xFF000000) - (otherpixel & 0xFF000000)) | 0x00FFFFFF , true);
-			}
-			else 
-			{
-				different = true;
-				res->pixels->setPixel(x, y, ((pixel & 0x00FFFFFF) - (otherpixel & 0x00FFFFFF)), true);
-			}
-			i++;
+				resrow[x] = ((pixel & 0xFF000000) - (otherpixel & 0xFF000000)) | 0x00FFFFFF;
+			else
+				resrow[x] = (pixel & 0x00FFFFFF) - (otherpixel & 0x00FFFFFF);
 		}
 	}
 	if (!different)
+	{
+		res->decRef();
 		asAtomHandler::setInt(ret,wrk,0);
+	}
 	else
+	{
+		res->pixels->markDirty();
 		ret = asAtomHandler::fromObject(res);
+	}
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,applyFilter)
@@ -1070,6 +1114,8 @@ ASFUNCTIONBODY_ATOM(BitmapData,noise)
 
 	uint32_t range = high-low;
 
+	// the random numbers are generated column by column, so this can't be split into rows
+	BitmapContainer* pixels = th->pixels.getPtr();
 	for (int32_t x=0; x<th->getWidth(); x++)
 	{
 		for (int32_t y=0; y<th->getHeight(); y++)
@@ -1092,9 +1138,11 @@ ASFUNCTIONBODY_ATOM(BitmapData,noise)
 				if((channelOptions & 0x8) == 0x8) // A
 					pixel |= ((rand() % range + low) & 0xff);
 			}
-			th->pixels->setPixel(x, y,pixel,true,true);
+			*pixels->getPixelRow(y,x) = pixel;
 		}
 	}
+	pixels->markDirty();
+	th->notifyUsers();
 }
 ASFUNCTIONBODY_ATOM(BitmapData,perlinNoise)
 {
@@ -1113,55 +1161,66 @@ ASFUNCTIONBODY_ATOM(BitmapData,perlinNoise)
 	_NR<Array> offsets;
 	ARG_UNPACK_ATOM(baseX)(baseY)(numOctaves)(randomSeed)(stitch) (fractalNoise) (channelOptions, 7) (grayScale, false) (offsets, NullRef);
 
-	if (stitch)
-		LOG(LOG_NOT_IMPLEMENTED,"perlinNoise: parameter stitch is ignored");
-	if (fractalNoise)
-		LOG(LOG_NOT_IMPLEMENTED,"perlinNoise: parameter fractalNoise is ignored");
+	vector<double> offsetsX;
+	vector<double> offsetsY;
 	if (!offsets.isNull())
-		LOG(LOG_NOT_IMPLEMENTED,"perlinNoise: parameter offsets is ignored");
+	{
+		for (uint32_t i=0; i<offsets->size() && i<numOctaves; i++)
+		{
+			asAtom o = offsets->at(i);
+			if (!asAtomHandler::is<Point>(o))
+				break;
+			offsetsX.push_back(asAtomHandler::as<Point>(o)->getX());
+			offsetsY.push_back(asAtomHandler::as<Point>(o)->getY());
+		}
+	}
 
-	const siv::PerlinNoise perlin(randomSeed);
-	for (int32_t x=0; x<th->getWidth(); x++)
+	uint32_t width = th->getWidth();
+	const PerlinNoiseGenerator perlin(randomSeed, width, th->getHeight(), baseX, baseY, numOctaves,
+					  stitch, fractalNoise, offsetsX, offsetsY);
+	BitmapContainer* pixels = th->pixels.getPtr();
+	PixelOps::forEachRow(wrk->getSystemState(),th->getHeight(),width,[&](uint32_t first, uint32_t last)
 	{
-		for (int32_t y=0; y<th->getHeight(); y++)
+		vector<double> noise(width);
+		for (uint32_t y=first; y<last; y++)
 		{
-			uint32_t pixel = 0x000000ff;
-			number_t v1 = perlin.octaveNoise0_1(x / baseX, y / baseY, numOctaves);
-			if (grayScale)
+			perlin.getRow(y,&noise[0]);
+			uint32_t* row = pixels->getPixelRow(y);
+			for (uint32_t x=0; x<width; x++)
 			{
-				uint8_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint8_t>(v1 * 255.0 + 0.5);
-				pixel |= v<<24 | v<<16 | v<<8;
-			}
-			else
-			{
-				if((channelOptions & 0x1) == 0x1) // R
+				uint32_t pixel = 0x000000ff;
+				number_t v1 = noise[x];
+				if (grayScale)
 				{
-					uint32_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint32_t>(v1 * UINT32_MAX + 0.5);
-					pixel |= v&0xff000000;
+					uint8_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint8_t>(v1 * 255.0 + 0.5);
+					pixel |= v<<24 | v<<16 | v<<8;
 				}
-				if((channelOptions & 0x2) == 0x2) // G
-				{
-					uint32_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint32_t>(v1 * UINT32_MAX + 0.5);
-					pixel |= v&0x00ff0000;
-				}
-				if((channelOptions & 0x4) == 0x4) // B
-				{
-					uint32_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint32_t>(v1 * UINT32_MAX + 0.5);
-					pixel |= v&0x0000ff00;
-				}
-				if((channelOptions & 0x8) == 0x8) // A
+				else
 				{
+					// all channels use the same noise
 					uint32_t v = v1 >= 1.0 ? 255 : v1 <= 0.0 ? 0 : static_cast<std::uint32_t>(v1 * UINT32_MAX + 0.5);
-					pixel |= v&0x000000ff;
+					if((channelOptions & 0x1) == 0x1) // R
+						pixel |= v&0xff000000;
+					if((channelOptions & 0x2) == 0x2) // G
+						pixel |= v&0x00ff0000;
+					if((channelOptions & 0x4) == 0x4) // B
+						pixel |= v&0x0000ff00;
+					if((channelOptions & 0x8) == 0x8) // A
+						pixel |= v&0x000000ff;
 				}
+				row[x] = pixel;
 			}
-			th->pixels->setPixel(x, y,pixel,true,true);
-			//LOG(LOG_INFO,"perlinnoise pixel:"<<x<<" "<<y<<" "<<hex<<th->pixels->getPixel(x,y)<<" "<<grayScale);
 		}
-	}
+	});
+	pixels->markDirty();
+	th->notifyUsers();
 }
 ASFUNCTIONBODY_ATOM(BitmapData,threshold)
 {
+	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
 	_NR<BitmapData> sourceBitmapData;
 	_NR<Rectangle> sourceRect;
 	_NR<Point> destPoint;
@@ -1172,10 +1231,82 @@ ASFUNCTIONBODY_ATOM(BitmapData,threshold)
 	bool copySource;
 	ARG_UNPACK_ATOM(sourceBitmapData)(sourceRect)(destPoint)(operation)(threshold) (color,0) (mask, 0xFFFFFFFF) (copySource, false);
 
-	LOG(LOG_NOT_IMPLEMENTED,"BitmapData.threshold not implemented");
+	if (sourceBitmapData.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceBitmapData");
+	if (sourceRect.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceRect");
+	if (destPoint.isNull())
+		throwError<TypeError>(kNullPointerError, "destPoint");
+	if (sourceBitmapData->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
+	THRESHOLD_OP op;
+	if (operation == "<")
+		op = THRESHOLD_LESS;
+	else if (operation == "<=")
+		op = THRESHOLD_LESS_EQUAL;
+	else if (operation == ">")
+		op = THRESHOLD_GREATER;
+	else if (operation == ">=")
+		op = THRESHOLD_GREATER_EQUAL;
+	else if (operation == "==")
+		op = THRESHOLD_EQUAL;
+	else if (operation == "!=")
+		op = THRESHOLD_NOT_EQUAL;
+	else
+	{
+		throwError<ArgumentError>(kInvalidArgumentError, "operation");
+		return;
+	}
+
+	RECT clippedSourceRect;
+	int32_t clippedDestX;
+	int32_t clippedDestY;
+	th->pixels->clipRect(sourceBitmapData->pixels, sourceRect->getRect(),
+			     destPoint->getX(), destPoint->getY(),
+			     clippedSourceRect, clippedDestX, clippedDestY);
+	int regionWidth = clippedSourceRect.Xmax - clippedSourceRect.Xmin;
+	int regionHeight = clippedSourceRect.Ymax - clippedSourceRect.Ymin;
+	if (regionWidth <= 0 || regionHeight <= 0)
+	{
+		asAtomHandler::setUInt(ret,wrk,0);
+		return;
+	}
+
+	if (!th->transparent)
+		color |= 0xFF000000;
+	uint32_t premultipliedColor;
+	PixelOps::premultiply(&premultipliedColor,&color,1);
+
+	SourceRows sourceRows(sourceBitmapData->pixels.getPtr(), th->pixels.getPtr(), clippedSourceRect);
+	BitmapContainer* dest = th->pixels.getPtr();
+	std::atomic<uint32_t> count(0);
+	// the test is done on the pixels with straight alpha, the destination stays premultiplied
+	PixelOps::forEachRow(wrk->getSystemState(),regionHeight,regionWidth,[&](uint32_t first, uint32_t last)
+	{
+		vector<uint32_t> srcRow(regionWidth);
+		uint32_t n = 0;
+		for (uint32_t y=first; y<last; y++)
+		{
+			uint32_t* d = dest->getPixelRow(clippedDestY+y,clippedDestX);
+			const uint32_t* s = sourceRows.getRow(y);
+			if (copySource)
+				memcpy(d,s,regionWidth*4);
+			PixelOps::unpremultiply(&srcRow[0],s,regionWidth);
+			n += PixelOps::threshold(d,&srcRow[0],regionWidth,op,threshold,premultipliedColor,mask,false);
+		}
+		count += n;
+	});
+	th->pixels->markDirty(RECT(clippedDestX,clippedDestX+regionWidth,clippedDestY,clippedDestY+regionHeight));
+	th->notifyUsers();
+	asAtomHandler::setUInt(ret,wrk,count);
 }
 ASFUNCTIONBODY_ATOM(BitmapData,merge)
 {
+	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
 	_NR<BitmapData> sourceBitmapData;
 	_NR<Rectangle> sourceRect;
 	_NR<Point> destPoint;
@@ -1185,11 +1316,52 @@ ASFUNCTIONBODY_ATOM(BitmapData,merge)
 	uint32_t alphaMultiplier;
 	ARG_UNPACK_ATOM(sourceBitmapData)(sourceRect) (destPoint) (redMultiplier) (greenMultiplier) (blueMultiplier) (alphaMultiplier);
 
-	LOG(LOG_NOT_IMPLEMENTED,"BitmapData.merge not implemented");
+	if (sourceBitmapData.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceBitmapData");
+	if (sourceRect.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceRect");
+	if (destPoint.isNull())
+		throwError<TypeError>(kNullPointerError, "destPoint");
+	if (sourceBitmapData->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
+	RECT clippedSourceRect;
+	int32_t clippedDestX;
+	int32_t clippedDestY;
+	th->pixels->clipRect(sourceBitmapData->pixels, sourceRect->getRect(),
+			     destPoint->getX(), destPoint->getY(),
+			     clippedSourceRect, clippedDestX, clippedDestY);
+	int regionWidth = clippedSourceRect.Xmax - clippedSourceRect.Xmin;
+	int regionHeight = clippedSourceRect.Ymax - clippedSourceRect.Ymin;
+	if (regionWidth <= 0 || regionHeight <= 0)
+		return;
+
+	// in memory order of the channels
+	const uint16_t mul[4] = { uint16_t(min(blueMultiplier,256u)), uint16_t(min(greenMultiplier,256u)),
+				  uint16_t(min(redMultiplier,256u)), uint16_t(min(alphaMultiplier,256u)) };
+	SourceRows sourceRows(sourceBitmapData->pixels.getPtr(), th->pixels.getPtr(), clippedSourceRect);
+	BitmapContainer* dest = th->pixels.getPtr();
+	PixelOps::forEachRow(wrk->getSystemState(),regionHeight,regionWidth,[&](uint32_t first, uint32_t last)
+	{
+		vector<uint32_t> srcRow(regionWidth);
+		vector<uint32_t> dstRow(regionWidth);
+		for (uint32_t y=first; y<last; y++)
+		{
+			uint32_t* d = dest->getPixelRow(clippedDestY+y,clippedDestX);
+			PixelOps::unpremultiply(&srcRow[0],sourceRows.getRow(y),regionWidth);
+			PixelOps::unpremultiply(&dstRow[0],d,regionWidth);
+			PixelOps::merge(&dstRow[0],&srcRow[0],regionWidth,mul);
+			PixelOps::premultiply(d,&dstRow[0],regionWidth);
+		}
+	});
+	th->pixels->markDirty(RECT(clippedDestX,clippedDestX+regionWidth,clippedDestY,clippedDestY+regionHeight));
+	th->notifyUsers();
 }
 ASFUNCTIONBODY_ATOM(BitmapData,paletteMap)
 {
-//	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
+	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
 
 	_NR<BitmapData> sourceBitmapData;
 	_NR<Rectangle> sourceRect;
@@ -1200,6 +1372,114 @@ ASFUNCTIONBODY_ATOM(BitmapData,paletteMap)
 	_NR<Array> alphaArray;
 	ARG_UNPACK_ATOM(sourceBitmapData)(sourceRect) (destPoint) (redArray, NullRef) (greenArray, NullRef) (blueArray, NullRef) (alphaArray, NullRef);
 
-	LOG(LOG_NOT_IMPLEMENTED,"BitmapData.paletteMap not implemented");
+	if (sourceBitmapData.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceBitmapData");
+	if (sourceRect.isNull())
+		throwError<TypeError>(kNullPointerError, "sourceRect");
+	if (destPoint.isNull())
+		throwError<TypeError>(kNullPointerError, "destPoint");
+	if (sourceBitmapData->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
+	RECT clippedSourceRect;
+	int32_t clippedDestX;
+	int32_t clippedDestY;
+	th->pixels->clipRect(sourceBitmapData->pixels, sourceRect->getRect(),
+			     destPoint->getX(), destPoint->getY(),
+			     clippedSourceRect, clippedDestX, clippedDestY);
+	int regionWidth = clippedSourceRect.Xmax - clippedSourceRect.Xmin;
+	int regionHeight = clippedSourceRect.Ymax - clippedSourceRect.Ymin;
+	if (regionWidth <= 0 || regionHeight <= 0)
+		return;
+
+	// the lookup tables are in memory order of the channels, missing arrays keep the channel unchanged
+	uint32_t lut[4][256];
+	Array* arrays[4] = { blueArray.getPtr(), greenArray.getPtr(), redArray.getPtr(), alphaArray.getPtr() };
+	for (uint32_t k=0; k<4; k++)
+	{
+		uint32_t size = arrays[k] ? arrays[k]->size() : 0;
+		for (uint32_t i=0; i<256; i++)
+		{
+			if (!arrays[k])
+				lut[k][i] = i<<(8*k);
+			else if (i < size)
+			{
+				asAtom v = arrays[k]->at(i);
+				lut[k][i] = asAtomHandler::toUInt(v);
+			}
+			else
+				lut[k][i] = 0;
+		}
+	}
+
+	SourceRows sourceRows(sourceBitmapData->pixels.getPtr(), th->pixels.getPtr(), clippedSourceRect);
+	BitmapContainer* dest = th->pixels.getPtr();
+	PixelOps::forEachRow(wrk->getSystemState(),regionHeight,regionWidth,[&](uint32_t first, uint32_t last)
+	{
+		vector<uint32_t> row(regionWidth);
+		for (uint32_t y=first; y<last; y++)
+		{
+			PixelOps::unpremultiply(&row[0],sourceRows.getRow(y),regionWidth);
+			PixelOps::paletteMap(&row[0],&row[0],regionWidth,lut);
+			PixelOps::premultiply(dest->getPixelRow(clippedDestY+y,clippedDestX),&row[0],regionWidth);
+		}
+	});
+	th->pixels->markDirty(RECT(clippedDestX,clippedDestX+regionWidth,clippedDestY,clippedDestY+regionHeight));
+	th->notifyUsers();
 }
 
+
+ASFUNCTIONBODY_ATOM(BitmapData,encode)
+{
+	BitmapData* th = asAtomHandler::as<BitmapData>(obj);
+	if(th->pixels.isNull())
+		throw Class<ArgumentError>::getInstanceS(wrk,"Disposed BitmapData", 2015);
+
+	_NR<Rectangle> rect;
+	_NR<ASObject> compressor;
+	_NR<ByteArray> byteArray;
+	ARG_UNPACK_ATOM (rect)(compressor)(byteArray, NullRef);
+
+	if (rect.isNull())
+		throwError<TypeError>(kNullPointerError, "rect");
+	if (compressor.isNull())
+		throwError<TypeError>(kNullPointerError, "compressor");
+
+	RECT clipped;
+	th->pixels->clipRect(rect->getRect(),clipped);
+	uint32_t width = max(clipped.Xmax-clipped.Xmin,0);
+	uint32_t height = max(clipped.Ymax-clipped.Ymin,0);
+	const uint8_t* start = (const uint8_t*)th->pixels->getPixelRow(clipped.Ymin,clipped.Xmin);
+	int32_t stride = th->pixels->getStride();
+	vector<uint8_t> encoded;
+	bool success = false;
+	if (compressor->getClass() == Class<PNGEncoderOptions>::getClass(wrk->getSystemState()))
+	{
+		PNGEncoderOptions* options = compressor->as<PNGEncoderOptions>();
+		success = ImageEncoder::encodePNG(wrk->getSystemState(),start,width,height,stride,ENCODER_ARGB32_PREMULTIPLIED,
+						  th->transparent,options->fastCompression,encoded);
+	}
+	else if (compressor->getClass() == Class<JPEGEncoderOptions>::getClass(wrk->getSystemState()))
+	{
+		JPEGEncoderOptions* options = compressor->as<JPEGEncoderOptions>();
+		success = ImageEncoder::encodeJPEG(start,width,height,stride,ENCODER_ARGB32_PREMULTIPLIED,options->quality,encoded);
+	}
+	else if (compressor->getClass() == Class<JPEGXREncoderOptions>::getClass(wrk->getSystemState()))
+		LOG(LOG_NOT_IMPLEMENTED,"BitmapData.encode with JPEGXREncoderOptions");
+	else
+		throwError<ArgumentError>(kInvalidArgumentError, "compressor");
+	if (!success)
+		LOG(LOG_ERROR,"BitmapData.encode failed");
+
+	ByteArray* ba;
+	if (byteArray.isNull())
+		ba = Class<ByteArray>::getInstanceS(wrk);
+	else
+	{
+		ba = byteArray.getPtr();
+		ba->incRef();
+	}
+	if (!encoded.empty())
+		ba->writeBytes(&encoded[0],encoded.size());
+	ret = asAtomHandler::fromObject(ba);
+}
@@ -92,6 +92,7 @@ public:
 	ASFUNCTION_ATOM(threshold);
 	ASFUNCTION_ATOM(merge);
 	ASFUNCTION_ATOM(paletteMap);
+	ASFUNCTION_ATOM(encode);
 };
 
 }
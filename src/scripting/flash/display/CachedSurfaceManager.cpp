@@ -0,0 +1,158 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/flash/display/CachedSurfaceManager.h"
+#include "scripting/flash/display/flashdisplay.h"
+#include <cmath>
+
+using namespace lightspark;
+using namespace std;
+
+CachedSurfaceManager::CachedSurfaceManager(uint64_t budget, bool integerScale):
+	memoryBudget(budget),memoryUsed(0),reuseIntegerScale(integerScale)
+{
+	stats.hits=0;
+	stats.misses=0;
+	stats.evictions=0;
+	stats.count=0;
+	stats.bytes=0;
+}
+
+bool CachedSurfaceManager::isIntegerScale(const MATRIX& m, const MATRIX& cached)
+{
+	const number_t c[4] = { cached.xx, cached.yx, cached.xy, cached.yy };
+	const number_t n[4] = { m.xx, m.yx, m.xy, m.yy };
+	// the factor is taken from the largest component to keep the rounding error small
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; i++)
+	{
+		if (fabs(c[i]) > fabs(c[largest]))
+			largest = i;
+	}
+	if (c[largest] == 0)
+		return false;
+	number_t factor = n[largest]/c[largest];
+	if (!(factor > 0))
+		return false;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (fabs(n[i]-factor*c[i]) > 1e-9*fabs(n[largest]))
+			return false;
+	}
+	number_t r = factor >= 1 ? factor : 1/factor;
+	return fabs(r-round(r)) < 1e-6*r;
+}
+
+bool CachedSurfaceManager::reuse(DisplayObject* o, const MATRIX& m, const MATRIX& initialMatrix, bool hasFilters, MATRIX& bitmapMatrix)
+{
+	Locker l(mutex);
+	auto it = entries.find(o);
+	if (it == entries.end())
+		return false;
+	Entry& e = it->second;
+	lru.splice(lru.end(),lru,e.lru);
+	if (e.stageScaleX != initialMatrix.getScaleX() || e.stageScaleY != initialMatrix.getScaleY())
+		return false;
+	if (m.xx == e.matrix.xx && m.yx == e.matrix.yx && m.xy == e.matrix.xy && m.yy == e.matrix.yy)
+	{
+		if (m.x0 == e.matrix.x0 && m.y0 == e.matrix.y0)
+			bitmapMatrix = e.bitmapMatrix;
+		else
+		{
+			bitmapMatrix = e.bitmapMatrix;
+			bitmapMatrix.x0 += m.x0-e.matrix.x0;
+			bitmapMatrix.y0 += m.y0-e.matrix.y0;
+		}
+	}
+	else if (reuseIntegerScale && !hasFilters && isIntegerScale(m,e.matrix))
+	{
+		// move the bitmap from the old to the new matrix
+		bitmapMatrix = m.multiplyMatrix(e.matrix.getInverted()).multiplyMatrix(e.bitmapMatrix);
+	}
+	else
+		return false;
+	stats.hits++;
+	return true;
+}
+
+void CachedSurfaceManager::drawn(DisplayObject* o, const MATRIX& m, const MATRIX& initialMatrix, const MATRIX& bitmapMatrix, uint32_t width, uint32_t height)
+{
+	vector<_NR<Bitmap>> evicted;
+	{
+		Locker l(mutex);
+		auto it = entries.find(o);
+		if (it == entries.end())
+		{
+			it = entries.insert(make_pair(o,Entry())).first;
+			it->second.bytes = 0;
+			it->second.lru = lru.insert(lru.end(),o);
+		}
+		else
+			lru.splice(lru.end(),lru,it->second.lru);
+		Entry& e = it->second;
+		e.matrix = m;
+		e.stageScaleX = initialMatrix.getScaleX();
+		e.stageScaleY = initialMatrix.getScaleY();
+		e.bitmapMatrix = bitmapMatrix;
+		memoryUsed -= e.bytes;
+		e.bytes = uint64_t(width)*height*4;
+		memoryUsed += e.bytes;
+		stats.misses++;
+
+		// release the bitmaps of objects that are not displayed, starting with the least recently used
+		auto cur = lru.begin();
+		while (memoryUsed > memoryBudget && cur != lru.end())
+		{
+			DisplayObject* d = *cur;
+			if (d == o || d->isOnStage())
+			{
+				cur++;
+				continue;
+			}
+			auto evictit = entries.find(d);
+			memoryUsed -= evictit->second.bytes;
+			entries.erase(evictit);
+			cur = lru.erase(cur);
+			// the bitmap is released after unlocking, in case it is the last reference
+			evicted.push_back(d->cachedBitmap);
+			d->cachedBitmap.reset();
+			d->setNeedsTextureRecalculation();
+			stats.evictions++;
+		}
+	}
+}
+
+void CachedSurfaceManager::remove(DisplayObject* o)
+{
+	Locker l(mutex);
+	auto it = entries.find(o);
+	if (it == entries.end())
+		return;
+	memoryUsed -= it->second.bytes;
+	lru.erase(it->second.lru);
+	entries.erase(it);
+}
+
+void CachedSurfaceManager::getStats(CachedSurfaceStats& s)
+{
+	Locker l(mutex);
+	s = stats;
+	s.count = entries.size();
+	s.bytes = memoryUsed;
+}
@@ -0,0 +1,95 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_FLASH_DISPLAY_CACHEDSURFACEMANAGER_H
+#define SCRIPTING_FLASH_DISPLAY_CACHEDSURFACEMANAGER_H 1
+
+#include "compat.h"
+#include "swftypes.h"
+#include "threading.h"
+#include <list>
+#include <unordered_map>
+
+namespace lightspark
+{
+
+class DisplayObject;
+
+struct CachedSurfaceStats
+{
+	// number of times a cached bitmap was reused or had to be drawn
+	uint64_t hits;
+	uint64_t misses;
+	// number of bitmaps released to stay inside the memory budget
+	uint64_t evictions;
+	uint32_t count;
+	uint64_t bytes;
+};
+
+/*
+ * Keeps track of the bitmaps drawn for DisplayObjects that are cached as bitmap.
+ * It decides which changes of the owner's matrix require the bitmap to be drawn again:
+ * - translation never does, the bitmap is only moved. This includes owners with filters, as the
+ *   filtered pixels don't depend on the position
+ * - scaling by an integer factor does if reusing those is disabled in the configuration or the owner has filters
+ * - any other change of scale, rotation or skew always does
+ * The bitmaps of objects that are not on stage are released, least recently used first,
+ * when all bitmaps together need more memory than the budget.
+ */
+class CachedSurfaceManager
+{
+private:
+	struct Entry
+	{
+		// matrix of the owner and scale of the stage at the time the bitmap was drawn
+		MATRIX matrix;
+		number_t stageScaleX;
+		number_t stageScaleY;
+		// maps the pixels of the bitmap to the coordinates of the owner's parent
+		MATRIX bitmapMatrix;
+		uint64_t bytes;
+		std::list<DisplayObject*>::iterator lru;
+	};
+	Mutex mutex;
+	std::unordered_map<DisplayObject*,Entry> entries;
+	// least recently used first
+	std::list<DisplayObject*> lru;
+	uint64_t memoryBudget;
+	uint64_t memoryUsed;
+	bool reuseIntegerScale;
+	CachedSurfaceStats stats;
+	// checks if the linear part of m is the one of cached multiplied by an integer or by 1/integer
+	static bool isIntegerScale(const MATRIX& m, const MATRIX& cached);
+public:
+	CachedSurfaceManager(uint64_t budget, bool integerScale);
+	/*
+	 * Called before the cached bitmap of o is used, m is the current matrix of o.
+	 * Returns false if the bitmap has to be drawn again. Otherwise bitmapMatrix is set to
+	 * the matrix mapping the pixels of the existing bitmap to the coordinates of the parent of o
+	 */
+	bool reuse(DisplayObject* o, const MATRIX& m, const MATRIX& initialMatrix, bool hasFilters, MATRIX& bitmapMatrix);
+	// registers the bitmap that was just drawn for o
+	void drawn(DisplayObject* o, const MATRIX& m, const MATRIX& initialMatrix, const MATRIX& bitmapMatrix, uint32_t width, uint32_t height);
+	// called when the cached bitmap of o is released
+	void remove(DisplayObject* o);
+	void getStats(CachedSurfaceStats& s);
+};
+
+}
+#endif /* SCRIPTING_FLASH_DISPLAY_CACHEDSURFACEMANAGER_H */
@@ -27,8 +27,10 @@
 #include "scripting/flash/geom/flashgeom.h"
 #include "scripting/flash/accessibility/flashaccessibility.h"
 #include "scripting/flash/display/BitmapData.h"
+#include "scripting/flash/display/CachedSurfaceManager.h"
 #include "scripting/flash/geom/flashgeom.h"
 #include "scripting/flash/filters/flashfilters.h"
+#include "scripting/flash/filters/FilterChain.h"
 #include "scripting/toplevel/Number.h"
 #include <algorithm>
 
@@ -128,6 +130,8 @@ void DisplayObject::finalize()
 {
 	removeAVM1Listeners();
 	EventDispatcher::finalize();
+	if (cachedBitmap)
+		getSystemState()->cachedSurfaceManager->remove(this);
 	cachedBitmap.reset();
 	cachedAsBitmapOf=nullptr;
 	parent=nullptr;
@@ -162,6 +166,8 @@ bool DisplayObject::destruct()
 {
 	// TODO make all DisplayObject derived classes reusable
 	removeAVM1Listeners();
+	if (cachedBitmap)
+		getSystemState()->cachedSurfaceManager->remove(this);
 	cachedBitmap.reset();
 	cachedAsBitmapOf=nullptr;
 	ismask=false;
@@ -1751,7 +1757,10 @@ IDrawable* DisplayObject::getCachedBitmapDrawable(DisplayObject* target,const MA
 	}
 	uint32_t w=(ceil(xmax-xmin)+maxfilterborder*2)*initialMatrix.getScaleX();
 	uint32_t h=(ceil(ymax-ymin)+maxfilterborder*2)*initialMatrix.getScaleY();
-	if (needsTextureRecalculation|| !cachedBitmap)
+	// the bitmap is kept if only the position of this object changed
+	CachedSurfaceManager* manager = getSystemState()->cachedSurfaceManager;
+	MATRIX m1;
+	if (needsTextureRecalculation || !cachedBitmap || !manager->reuse(this,m,initialMatrix,!filters.isNull() && filters->size(),m1))
 	{
 		if (!cachedBitmap
 				|| cachedBitmap->getBitmapSize().width != w
@@ -1764,24 +1773,10 @@ IDrawable* DisplayObject::getCachedBitmapDrawable(DisplayObject* target,const MA
 		m0.translate(-(xmin-maxfilterborder) ,-(ymin-maxfilterborder));
 		m0.scale(initialMatrix.getScaleX(),initialMatrix.getScaleY());
 		DrawToBitmap(cachedBitmap->bitmapData.getPtr(),m0,true,true);
-		if (filters)
-		{
-			for (uint32_t i = 0; i < filters->size(); i++)
-			{
-				asAtom f = asAtomHandler::invalidAtom;
-				filters->at_nocheck(f,i);
-				if (asAtomHandler::is<BitmapFilter>(f))
-					asAtomHandler::as<BitmapFilter>(f)->applyFilter(cachedBitmap->bitmapData->getBitmapContainer().getPtr(),nullptr,RECT(0,w,0,h),0,0,initialMatrix.getScaleX(),initialMatrix.getScaleY());
-			}
-		}
-		// apply colortransform for cached bitmap after the filters are applied
-		ColorTransform* ct = colorTransform.getPtr();
-		if (ct)
-		{
-			ct->applyTransformation(cachedBitmap->bitmapData->getBitmapContainer()->getData()
-									,cachedBitmap->bitmapData->getBitmapContainer()->getWidth()*cachedBitmap->bitmapData->getBitmapContainer()->getHeight()*4);
-		}
-		
+		// apply the filters and then the colortransform for cached bitmap
+		getSystemState()->filterChain->apply(cachedBitmap->bitmapData->getBitmapContainer().getPtr(),filters.getPtr(),colorTransform.getPtr(),
+											 initialMatrix.getScaleX(),initialMatrix.getScaleY());
+
 		cachedBitmap->resetNeedsTextureRecalculation();
 		cachedBitmap->hasChanged=true;
 		if (!this->cachedAsBitmapOf)
@@ -1789,13 +1784,14 @@ IDrawable* DisplayObject::getCachedBitmapDrawable(DisplayObject* target,const MA
 			// force texture upload
 			cachedBitmap->bitmapData->addUser(cachedBitmap.getPtr());
 		}
+		m1 = MATRIX(1,1,0,0,(xmin-maxfilterborder)*initialMatrix.getScaleX(),(ymin-maxfilterborder)*initialMatrix.getScaleY());
+		m1.scale(1.0/initialMatrix.getScaleX(),1.0/initialMatrix.getScaleY());
+		manager->drawn(this,m,initialMatrix,m1,w,h);
 	}
 	if (pcachedBitmap)
 		*pcachedBitmap = cachedBitmap;
 	this->resetNeedsTextureRecalculation();
 	this->hasChanged=false;
-	MATRIX m1(1,1,0,0,(xmin-maxfilterborder)*initialMatrix.getScaleX(),(ymin-maxfilterborder)*initialMatrix.getScaleY());
-	m1.scale(1.0/initialMatrix.getScaleX(),1.0/initialMatrix.getScaleY());
 	return cachedBitmap->invalidateFromSource(target, initialMatrix,true,this->getParent(),m1,this);
 }
 
@@ -51,6 +51,7 @@ friend class Shape;
 friend class Bitmap;
 friend class CairoRenderer;
 friend class Graphics;
+friend class CachedSurfaceManager;
 friend std::ostream& operator<<(std::ostream& s, const DisplayObject& r);
 public:
 	enum HIT_TYPE { GENERIC_HIT, // point is over the object
@@ -615,7 +615,7 @@ ASFUNCTIONBODY_ATOM(Graphics,drawPath)
 }
 
 void Graphics::pathToTokens(_NR<Vector> commands, _NR<Vector> data,
-			    tiny_string winding, std::vector<uint64_t>& tokens)
+			    tiny_string winding, TokenBuffer& tokens)
 {
 	if (commands.isNull() || data.isNull())
 		return;
@@ -804,11 +804,17 @@ bool Graphics::destruct()
 void Graphics::refreshTokens()
 {
 	Locker l(drawMutex);
+	// a bitmap cached for the owner stays valid as long as nothing was drawn
+	bool changed = !owner->tokens.filltokens.sameTokens(tokens.filltokens) ||
+		!owner->tokens.stroketokens.sameTokens(tokens.stroketokens);
+	// the token buffers are shared, new tokens are appended without affecting the owner's copy
 	owner->tokens.filltokens = tokens.filltokens;
 	owner->tokens.stroketokens = tokens.stroketokens;
+	owner->tokens.meshes = tokens.meshes;
 	owner->tokens.canRenderToGL = tokens.canRenderToGL;
 	owner->tokens.boundsRect = tokens.boundsRect;
-	owner->owner->setNeedsTextureRecalculation(true);
+	if (changed || !owner->owner->computeCacheAsBitmap())
+		owner->owner->setNeedsTextureRecalculation(true);
 }
 
 bool Graphics::shouldRenderToGL()
@@ -840,7 +846,7 @@ ASFUNCTIONBODY_ATOM(Graphics,drawTriangles)
 	tiny_string culling;
 	ARG_UNPACK_ATOM (vertices) (indices, NullRef) (uvtData, NullRef) (culling, "none");
 
-	if (th->inFilling)
+	if (th->inFilling && !th->drawTrianglesToMesh(vertices, indices, uvtData, parseCulling(culling)))
 		drawTrianglesToTokens(vertices, indices, uvtData, culling, th->tokens.filltokens);
 	drawTrianglesToTokens(vertices, indices, uvtData, culling, th->tokens.stroketokens);
 	th->hasChanged = true;
@@ -848,10 +854,101 @@ ASFUNCTIONBODY_ATOM(Graphics,drawTriangles)
 		th->dorender(true);
 }
 
-void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, tiny_string culling, std::vector<uint64_t>& tokens)
+TRIANGLE_CULLING Graphics::parseCulling(const tiny_string& culling)
 {
-	if (culling != "none")
-		LOG(LOG_NOT_IMPLEMENTED, "Graphics.drawTriangles doesn't support culling");
+	if (culling == "none")
+		return CULLING_NONE;
+	if (culling == "positive")
+		return CULLING_POSITIVE;
+	if (culling == "negative")
+		return CULLING_NEGATIVE;
+	throwError<ArgumentError>(kInvalidEnumError, "culling");
+	return CULLING_NONE;
+}
+
+bool Graphics::drawTrianglesToMesh(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, TRIANGLE_CULLING culling)
+{
+	if (fillStyles.empty())
+		return false;
+	const FILLSTYLE& fill = fillStyles.back();
+	bool isBitmap = fill.FillStyleType == REPEATING_BITMAP ||
+			fill.FillStyleType == CLIPPED_BITMAP ||
+			fill.FillStyleType == NON_SMOOTHED_REPEATING_BITMAP ||
+			fill.FillStyleType == NON_SMOOTHED_CLIPPED_BITMAP;
+	// gradients and bitmaps without texture coordinates are still drawn as cairo paths
+	if (fill.FillStyleType != SOLID_FILL && !(isBitmap && !uvtData.isNull()))
+		return false;
+	if (vertices.isNull())
+		return true;
+
+	if ((indices.isNull() && (vertices->size() % 6 != 0)) ||
+	    (!indices.isNull() && (indices->size() % 3 != 0)))
+	{
+		throwError<ArgumentError>(kInvalidParamError);
+	}
+
+	_R<TriangleMesh> mesh = _MR(new TriangleMesh(fill));
+	uint32_t numvertices = vertices->size()/2;
+	vector<number_t> values(2*numvertices);
+	vertices->getNumbers(values.data(), 0, 2*numvertices);
+	mesh->positions.assign(values.begin(), values.end());
+	if (isBitmap)
+	{
+		uint32_t uvtElemSize=2;
+		if (uvtData->size() == 2*numvertices)
+			uvtElemSize = 2;
+		else if (uvtData->size() == 3*numvertices)
+			uvtElemSize = 3;
+		else
+			throwError<ArgumentError>(kInvalidParamError);
+		values.resize(uvtElemSize*numvertices);
+		uvtData->getNumbers(values.data(), 0, uvtElemSize*numvertices);
+		mesh->uvt.resize(3*numvertices);
+		for (uint32_t i = 0; i < numvertices; i++)
+		{
+			mesh->uvt[3*i] = values[i*uvtElemSize];
+			mesh->uvt[3*i+1] = values[i*uvtElemSize+1];
+			mesh->uvt[3*i+2] = uvtElemSize == 3 ? values[i*uvtElemSize+2] : 1;
+		}
+	}
+
+	uint32_t numindices = indices.isNull() ? numvertices : indices->size();
+	mesh->indices.reserve(numindices);
+	for (uint32_t i = 0; i+2 < numindices; i+=3)
+	{
+		uint32_t v[3];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			if (indices.isNull())
+				v[j] = i+j;
+			else
+			{
+				asAtom a = indices->at(i+j);
+				v[j] = asAtomHandler::toUInt(a);
+			}
+			if (v[j] >= numvertices)
+				throwError<RangeError>(kOutOfRangeError);
+		}
+		const vector<float>& p = mesh->positions;
+		if (!TriangleMesh::isVisible(culling, p[2*v[0]], p[2*v[0]+1], p[2*v[1]], p[2*v[1]+1], p[2*v[2]], p[2*v[2]+1]))
+			continue;
+		mesh->indices.insert(mesh->indices.end(), v, v+3);
+	}
+
+	// According to testing, drawTriangles first fills the current
+	// path and creates a new path, but keeps the source.
+	tokens.filltokens.emplace_back(GeomToken(FILL_KEEP_SOURCE).uval);
+	if (mesh->indices.empty())
+		return true;
+	tokens.filltokens.emplace_back(GeomToken(FILL_TRIANGLE_MESH).uval);
+	tokens.filltokens.emplace_back(GeomToken(*mesh.getPtr()).uval);
+	tokens.meshes.push_back(mesh);
+	return true;
+}
+
+void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, tiny_string culling, TokenBuffer& tokens)
+{
+	TRIANGLE_CULLING cullingMode = parseCulling(culling);
 
 	// Validate the parameters
 	if (vertices.isNull())
@@ -885,8 +982,7 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 		else if (uvtData->size()==3*numvertices)
 		{
 			has_uvt=true;
-			uvtElemSize=3; /* (u, v, t), t is ignored */
-			LOG(LOG_NOT_IMPLEMENTED, "Graphics.drawTriangles doesn't support t in uvtData parameter");
+			uvtElemSize=3; /* (u, v, t), t is only used for filling by TriangleMesh */
 		}
 		else
 		{
@@ -932,6 +1028,9 @@ void Graphics::drawTrianglesToTokens(_NR<Vector> vertices, _NR<Vector> indices,
 			}
 		}
 		
+		if (!TriangleMesh::isVisible(cullingMode, x[0], y[0], x[1], y[1], x[2], y[2]))
+			continue;
+
 		Vector2 a(x[0], y[0]);
 		Vector2 b(x[1], y[1]);
 		Vector2 c(x[2], y[2]);
@@ -1356,10 +1455,9 @@ ASFUNCTIONBODY_ATOM(Graphics,copyFrom)
 	if (source.isNull())
 		return;
 
-	th->tokens.filltokens.assign(source->tokens.filltokens.begin(),
-				 source->tokens.filltokens.end());
-	th->tokens.stroketokens.assign(source->tokens.stroketokens.begin(),
-				 source->tokens.stroketokens.end());
+	th->tokens.filltokens=source->tokens.filltokens;
+	th->tokens.stroketokens=source->tokens.stroketokens;
+	th->tokens.meshes=source->tokens.meshes;
 	th->tokens.canRenderToGL=source->tokens.canRenderToGL;
 	th->hasChanged = true;
 }
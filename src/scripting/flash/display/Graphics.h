@@ -43,6 +43,10 @@ private:
 	std::list<FILLSTYLE> fillStyles;
 	std::list<LINESTYLE2> lineStyles;
 	void checkAndSetScaling();
+	static TRIANGLE_CULLING parseCulling(const tiny_string& culling);
+	/* adds the triangles as a TriangleMesh filled with the current fill,
+	 * returns false if the fill can't be drawn by the mesh rasterizer */
+	bool drawTrianglesToMesh(_NR<Vector> vertices, _NR<Vector> indices, _NR<Vector> uvtData, TRIANGLE_CULLING culling);
 	static void solveVertexMapping(double x1, double y1,
 				       double x2, double y2,
 				       double x3, double y3,
@@ -86,12 +90,12 @@ public:
 	static void pathToTokens(_NR<Vector> commands,
 				 _NR<Vector> data,
 				 tiny_string windings,
-				 std::vector<uint64_t> &tokens);
+				 TokenBuffer&tokens);
 	static void drawTrianglesToTokens(_NR<Vector> vertices,
 					  _NR<Vector> indices,
 					  _NR<Vector> uvtData,
 					  tiny_string culling,
-					  std::vector<uint64_t> &tokens);
+					  TokenBuffer&tokens);
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_ATOM(lineBitmapStyle);
 	ASFUNCTION_ATOM(lineGradientStyle);
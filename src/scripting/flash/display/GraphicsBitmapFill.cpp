@@ -61,7 +61,7 @@ FILLSTYLE GraphicsBitmapFill::toFillStyle()
 	return Graphics::createBitmapFill(bitmapData, matrix, repeat, smooth);
 }
 
-void GraphicsBitmapFill::appendToTokens(std::vector<uint64_t>& tokens,Graphics* graphics)
+void GraphicsBitmapFill::appendToTokens(TokenBuffer& tokens,Graphics* graphics)
 {
 	FILLSTYLE style = toFillStyle();
 	FILLSTYLE& styleref = graphics->addFillStyle(style);
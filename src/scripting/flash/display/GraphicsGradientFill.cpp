@@ -88,7 +88,7 @@ FILLSTYLE GraphicsGradientFill::toFillStyle()
 		matrix, spreadMethod, interpolationMethod, focalPointRatio);
 }
 
-void GraphicsGradientFill::appendToTokens(std::vector<uint64_t>& tokens,Graphics* graphics)
+void GraphicsGradientFill::appendToTokens(TokenBuffer& tokens,Graphics* graphics)
 {
 	FILLSTYLE style = toFillStyle();
 	FILLSTYLE& styleref = graphics->addFillStyle(style);
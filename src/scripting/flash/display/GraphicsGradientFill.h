@@ -47,7 +47,7 @@ public:
 	ASPROPERTY_GETTER_SETTER(tiny_string, spreadMethod);
 	ASPROPERTY_GETTER_SETTER(tiny_string, type);
 	FILLSTYLE toFillStyle() override;
-	void appendToTokens(std::vector<uint64_t>& tokens,Graphics* graphics) override;
+	void appendToTokens(TokenBuffer& tokens,Graphics* graphics) override;
 };
 
 }
@@ -188,7 +188,7 @@ ASFUNCTIONBODY_ATOM(GraphicsPath, wideMoveTo)
 	th->data->append(y);
 }
 
-void GraphicsPath::appendToTokens(std::vector<uint64_t>& tokens,Graphics* graphics)
+void GraphicsPath::appendToTokens(TokenBuffer& tokens,Graphics* graphics)
 {
 	Graphics::pathToTokens(commands, data, winding, tokens);
 }
@@ -55,7 +55,7 @@ FILLSTYLE GraphicsSolidFill::toFillStyle()
 	return Graphics::createSolidFill(color, static_cast<uint8_t>(255*alpha));
 }
 
-void GraphicsSolidFill::appendToTokens(std::vector<uint64_t>& tokens, Graphics* graphics)
+void GraphicsSolidFill::appendToTokens(TokenBuffer& tokens, Graphics* graphics)
 {
 	FILLSTYLE style = toFillStyle();
 	FILLSTYLE& styleref = graphics->addFillStyle(style);
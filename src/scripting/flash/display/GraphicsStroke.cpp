@@ -88,7 +88,7 @@ void GraphicsStroke::validateFill(_NR<ASObject> oldValue)
 	}
 }
 
-void GraphicsStroke::appendToTokens(std::vector<uint64_t>& tokens, Graphics* graphics)
+void GraphicsStroke::appendToTokens(TokenBuffer& tokens, Graphics* graphics)
 {
 	LINESTYLE2 style(0xff);
 	style.Width = thickness;
@@ -41,8 +41,9 @@ TokenContainer::TokenContainer(DisplayObject* _o, const tokensVector& _tokens, f
 	owner(_o), scaling(_scaling)
 
 {
-	tokens.filltokens.assign(_tokens.filltokens.begin(),_tokens.filltokens.end());
-	tokens.stroketokens.assign(_tokens.stroketokens.begin(),_tokens.stroketokens.end());
+	tokens.filltokens=_tokens.filltokens;
+	tokens.stroketokens=_tokens.stroketokens;
+	tokens.meshes=_tokens.meshes;
 	tokens.canRenderToGL = _tokens.canRenderToGL;
 }
 
@@ -74,9 +75,9 @@ bool TokenContainer::renderImpl(RenderContext& ctxt) const
 			int tokentype = 1;
 			while (tokentype)
 			{
-				std::vector<uint64_t>::const_iterator it;
-				std::vector<uint64_t>::const_iterator itbegin;
-				std::vector<uint64_t>::const_iterator itend;
+				TokenBuffer::const_iterator it;
+				TokenBuffer::const_iterator itbegin;
+				TokenBuffer::const_iterator itend;
 				switch(tokentype)
 				{
 					case 1:
@@ -596,6 +597,13 @@ bool TokenContainer::boundsRectFromTokens(const tokensVector& tokens,float scali
 			case FILL_TRANSFORM_TEXTURE:
 				it+=6;
 				break;
+			case FILL_TRIANGLE_MESH:
+			{
+				GeomToken p1(*(++it),false);
+				p1.mesh->getBounds(xmin,xmax,ymin,ymax);
+				hasContent = true;
+				break;
+			}
 		}
 		it++;
 	}
@@ -644,6 +652,13 @@ bool TokenContainer::boundsRectFromTokens(const tokensVector& tokens,float scali
 			case FILL_TRANSFORM_TEXTURE:
 				it2+=6;
 				break;
+			case FILL_TRIANGLE_MESH:
+			{
+				GeomToken p1(*(++it2),false);
+				p1.mesh->getBounds(xmin,xmax,ymin,ymax);
+				hasContent = true;
+				break;
+			}
 		}
 		it2++;
 	}
@@ -667,7 +682,7 @@ bool TokenContainer::boundsRectFromTokens(const tokensVector& tokens,float scali
 }
 
 /* Find the size of the active texture (bitmap set by the latest SET_FILL). */
-void TokenContainer::getTextureSize(std::vector<uint64_t>& tokens, int *width, int *height)
+void TokenContainer::getTextureSize(TokenBuffer& tokens, int *width, int *height)
 {
 	*width=0;
 	*height=0;
@@ -695,6 +710,9 @@ void TokenContainer::getTextureSize(std::vector<uint64_t>& tokens, int *width, i
 			case FILL_TRANSFORM_TEXTURE:
 				i+=6;
 				break;
+			case FILL_TRIANGLE_MESH:
+				i++;
+				break;
 			case SET_FILL:
 			{
 				i++;
@@ -747,6 +765,9 @@ uint16_t TokenContainer::getCurrentLineWidth() const
 			case FILL_TRANSFORM_TEXTURE:
 				i+=6;
 				break;
+			case FILL_TRIANGLE_MESH:
+				i++;
+				break;
 			case SET_STROKE:
 			{
 				i++;
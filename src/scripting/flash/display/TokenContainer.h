@@ -55,7 +55,7 @@ public:
 					 const MATRIX& matrix = MATRIX(), const std::list<LINESTYLE2>& lineStyles = std::list<LINESTYLE2>(), const RECT &shapebounds= RECT());
 	static void FromDefineMorphShapeTagToShapeVector(DefineMorphShapeTag *tag,
 					 tokensVector& tokens, uint16_t ratio);
-	static void getTextureSize(std::vector<uint64_t>& tokens, int *width, int *height);
+	static void getTextureSize(TokenBuffer& tokens, int *width, int *height);
 	static bool boundsRectFromTokens(const tokensVector& tokens,float scaling, number_t& xmin, number_t& xmax, number_t& ymin, number_t& ymax);
 	uint16_t getCurrentLineWidth() const;
 	float scaling;
@@ -829,6 +829,7 @@ void Loader::setContent(_R<DisplayObject> o)
 		return;
 	{
 		Locker l(mutexDisplayList);
+		displayListChanged();
 		dynamicDisplayList.clear();
 	}
 
@@ -2434,6 +2435,7 @@ MovieClip* MovieClip::AVM1CloneSprite(asAtom target, uint32_t Depth,ASObject* in
 		toAdd->setupActions(*actions);
 	toAdd->tokens.filltokens = this->tokens.filltokens;
 	toAdd->tokens.stroketokens = this->tokens.stroketokens;
+	toAdd->tokens.meshes = this->tokens.meshes;
 	if(getParent()->hasLegacyChildAt(Depth))
 	{
 		getParent()->deleteLegacyChildAt(Depth,false);
@@ -2628,11 +2630,106 @@ void DisplayObjectContainer::sinit(Class_base* c)
 
 ASFUNCTIONBODY_GETTER_SETTER(DisplayObjectContainer, tabChildren)
 
-DisplayObjectContainer::DisplayObjectContainer(ASWorker* wrk, Class_base* c):InteractiveObject(wrk,c),mouseChildren(true),tabChildren(true)
+DisplayObjectContainer::DisplayObjectContainer(ASWorker* wrk, Class_base* c):InteractiveObject(wrk,c),mouseChildren(true),activeTraversals(nullptr),subtreeFlags(0),tabChildren(true)
 {
 	subtype=SUBTYPE_DISPLAYOBJECTCONTAINER;
 }
 
+DisplayObjectContainer::DisplayListTraversal::DisplayListTraversal(DisplayObjectContainer* c):container(c),hasSnapshot(false)
+{
+	Locker l(container->mutexDisplayList);
+	next=container->activeTraversals;
+	container->activeTraversals=this;
+}
+
+DisplayObjectContainer::DisplayListTraversal::~DisplayListTraversal()
+{
+	Locker l(container->mutexDisplayList);
+	DisplayListTraversal** t=&container->activeTraversals;
+	while (*t != this)
+		t=&(*t)->next;
+	*t=next;
+}
+
+DisplayObject* DisplayObjectContainer::DisplayListTraversal::getChild(size_t index)
+{
+	Locker l(container->mutexDisplayList);
+	const std::vector < _R<DisplayObject> >& list = hasSnapshot ? snapshot : container->dynamicDisplayList;
+	// the child is kept alive either by the display list or by the snapshot taken when the list is modified
+	return index < list.size() ? list[index].getPtr() : nullptr;
+}
+
+/* Calls f for every child in the display list.
+ * Elements of the dynamicDisplayList may be added/removed during the calls.
+ * As long as this doesn't happen, the display list is traversed directly. On the first modification,
+ * the unmodified list is copied and the traversal continues on the copy */
+template<class F>
+void DisplayObjectContainer::forEachChild(F f)
+{
+	DisplayListTraversal traversal(this);
+	size_t index=0;
+	while (DisplayObject* child = traversal.getChild(index++))
+		f(child);
+}
+
+void DisplayObjectContainer::displayListChanged()
+{
+	for (DisplayListTraversal* t=activeTraversals; t; t=t->next)
+	{
+		if (!t->hasSnapshot)
+		{
+			t->snapshot.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
+			t->hasSnapshot=true;
+		}
+	}
+	invalidateSubtreeFlags();
+}
+
+void DisplayObjectContainer::invalidateSubtreeFlags()
+{
+	// the flags of a container are only valid if the flags of all child containers are valid,
+	// so we can stop at the first ancestor that is already invalid
+	DisplayObjectContainer* c=this;
+	while (c && (c->subtreeFlags & SUBTREE_FLAGS_VALID))
+	{
+		c->subtreeFlags=0;
+		c=c->getParent();
+	}
+}
+
+void DisplayObjectContainer::updateSubtreeFlags()
+{
+	if (subtreeFlags & SUBTREE_FLAGS_VALID)
+		return;
+	Locker l(mutexDisplayList);
+	uint32_t flags=SUBTREE_FLAGS_VALID;
+	for (auto it=dynamicDisplayList.begin(); it != dynamicDisplayList.end(); it++)
+	{
+		DisplayObject* child = it->getPtr();
+		if (child->is<MovieClip>())
+			flags |= SUBTREE_HAS_TIMELINE;
+		if (!child->isConstructed())
+			flags |= SUBTREE_NEEDS_INIT;
+		if (child->is<DisplayObjectContainer>())
+		{
+			uint32_t childflags = child->as<DisplayObjectContainer>()->subtreeFlags;
+			if (!(childflags & SUBTREE_FLAGS_VALID))
+				return;
+			flags |= childflags;
+		}
+	}
+	subtreeFlags=flags;
+}
+
+/* Subtrees without any MovieClip don't do anything on advanceFrame/declareFrame/executeFrameScript,
+ * and don't have to be traversed by initFrame if all objects are constructed */
+bool DisplayObjectContainer::skipSubtree(bool forinit) const
+{
+	if (!(subtreeFlags & SUBTREE_FLAGS_VALID) || (subtreeFlags & SUBTREE_HAS_TIMELINE))
+		return false;
+	return !forinit || !(subtreeFlags & SUBTREE_NEEDS_INIT);
+}
+
 void DisplayObjectContainer::markAsChanged()
 {
 	for (auto it = dynamicDisplayList.begin(); it != dynamicDisplayList.end(); it++)
@@ -2868,6 +2965,7 @@ bool DisplayObjectContainer::destruct()
 		(*it)->removeAVM1Listeners();
 	}
 	dynamicDisplayList.clear();
+	subtreeFlags=0;
 	mouseChildren = true;
 	tabChildren = true;
 	legacyChildrenMarkedForDeletion.clear();
@@ -2886,6 +2984,7 @@ void DisplayObjectContainer::finalize()
 		(*it)->removeAVM1Listeners();
 	}
 	dynamicDisplayList.clear();
+	subtreeFlags=0;
 	legacyChildrenMarkedForDeletion.clear();
 	mapDepthToLegacyChild.clear();
 	mapLegacyChildToDepth.clear();
@@ -3144,6 +3243,7 @@ void DisplayObjectContainer::_addChildAt(_R<DisplayObject> child, unsigned int i
 	child->setParent(this);
 	{
 		Locker l(mutexDisplayList);
+		displayListChanged();
 		//We insert the object in the back of the list
 		if(index >= dynamicDisplayList.size())
 			dynamicDisplayList.push_back(child);
@@ -3188,6 +3288,7 @@ bool DisplayObjectContainer::_removeChild(DisplayObject* child,bool direct,bool
 			mapLegacyChildToDepth.erase(it2);
 		}
 
+		displayListChanged();
 		dynamicDisplayList.erase(it);
 	}
 	return true;
@@ -3196,6 +3297,7 @@ bool DisplayObjectContainer::_removeChild(DisplayObject* child,bool direct,bool
 void DisplayObjectContainer::_removeAllChildren()
 {
 	Locker l(mutexDisplayList);
+	displayListChanged();
 	auto it=dynamicDisplayList.begin();
 	while (it!=dynamicDisplayList.end())
 	{
@@ -3366,6 +3468,7 @@ ASFUNCTIONBODY_ATOM(DisplayObjectContainer,removeChildAt)
 		wrk->getSystemState()->addDisplayObjectToResetParentList(child);
 		//incRef before the reference is destroyed
 		child->incRef();
+		th->displayListChanged();
 		th->dynamicDisplayList.erase(it);
 	}
 	//As we return the child we don't decRef it
@@ -3382,6 +3485,7 @@ ASFUNCTIONBODY_ATOM(DisplayObjectContainer,removeChildren)
 		Locker l(th->mutexDisplayList);
 		if (endindex > th->dynamicDisplayList.size())
 			endindex = (uint32_t)th->dynamicDisplayList.size();
+		th->displayListChanged();
 		th->dynamicDisplayList.erase(th->dynamicDisplayList.begin()+beginindex,th->dynamicDisplayList.begin()+endindex);
 	}
 }
@@ -3403,6 +3507,7 @@ ASFUNCTIONBODY_ATOM(DisplayObjectContainer,_setChildIndex)
 
 	Locker l(th->mutexDisplayList);
 
+	th->displayListChanged();
 	child->incRef();
 	th->dynamicDisplayList.erase(th->dynamicDisplayList.begin()+curIndex); //remove from old position
 
@@ -3449,6 +3554,7 @@ ASFUNCTIONBODY_ATOM(DisplayObjectContainer,swapChildren)
 		if(it1==th->dynamicDisplayList.end() || it2==th->dynamicDisplayList.end())
 			throw Class<ArgumentError>::getInstanceS(wrk,"Argument is not child of this object", 2025);
 
+		th->displayListChanged();
 		std::iter_swap(it1, it2);
 	}
 }
@@ -3470,6 +3576,7 @@ ASFUNCTIONBODY_ATOM(DisplayObjectContainer,swapChildrenAt)
 
 	{
 		Locker l(th->mutexDisplayList);
+		th->displayListChanged();
 		std::iter_swap(th->dynamicDisplayList.begin() + index1, th->dynamicDisplayList.begin() + index2);
 	}
 }
@@ -3624,8 +3731,8 @@ Shape::Shape(ASWorker* wrk, Class_base* c, float scaling, DefineShapeTag* tag):
 
 void Shape::setupShape(DefineShapeTag* tag, float _scaling)
 {
-	tokens.filltokens.assign(tag->tokens->filltokens.begin(),tag->tokens->filltokens.end());
-	tokens.stroketokens.assign(tag->tokens->stroketokens.begin(),tag->tokens->stroketokens.end());
+	tokens.filltokens=tag->tokens->filltokens;
+	tokens.stroketokens=tag->tokens->stroketokens;
 	fromTag = tag;
 	cachedSurface.isChunkOwner=false;
 	cachedSurface.tex=&tag->chunk;
@@ -5798,16 +5905,8 @@ void JointStyle::sinit(Class_base* c)
 
 void DisplayObjectContainer::declareFrame()
 {
-	// elements of the dynamicDisplayList may be removed/added during declareFrame() calls,
-	// so we create a temporary list containing all elements
-	std::vector < _R<DisplayObject> > tmplist;
-	{
-		Locker l(mutexDisplayList);
-		tmplist.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
-	}
-	auto it=tmplist.begin();
-	for(;it!=tmplist.end();it++)
-		(*it)->declareFrame();
+	if (!skipSubtree(false))
+		forEachChild([](DisplayObject* child) { child->declareFrame(); });
 	DisplayObject::declareFrame();
 }
 
@@ -5819,33 +5918,19 @@ void DisplayObjectContainer::declareFrame()
 void DisplayObjectContainer::initFrame()
 {
 	/* init the frames and call constructors of our children first */
-
-	// elements of the dynamicDisplayList may be removed during initFrame() calls,
-	// so we create a temporary list containing all elements
-	std::vector < _R<DisplayObject> > tmplist;
+	if (!skipSubtree(true))
 	{
-		Locker l(mutexDisplayList);
-		tmplist.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
+		forEachChild([](DisplayObject* child) { child->initFrame(); });
+		updateSubtreeFlags();
 	}
-	auto it=tmplist.begin();
-	for(;it!=tmplist.end();it++)
-		(*it)->initFrame();
 	/* call our own constructor, if necassary */
 	DisplayObject::initFrame();
 }
 
 void DisplayObjectContainer::executeFrameScript()
 {
-	// elements of the dynamicDisplayList may be removed during executeFrameScript() calls,
-	// so we create a temporary list containing all elements
-	std::vector < _R<DisplayObject> > tmplist;
-	{
-		Locker l(mutexDisplayList);
-		tmplist.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
-	}
-	auto it=tmplist.begin();
-	for(;it!=tmplist.end();it++)
-		(*it)->executeFrameScript();
+	if (!skipSubtree(false))
+		forEachChild([](DisplayObject* child) { child->executeFrameScript(); });
 }
 
 void DisplayObjectContainer::AVM1HandleEventScriptsAfter()
@@ -6104,15 +6189,11 @@ void MovieClip::initFrame()
 	/* Now the new legacy display objects are there, so we can also init their
 	 * first frame (top-down) and call their constructors (bottom-up) */
 
-	// work on a copy because initframe may alter the displaylist
-	std::vector < _R<DisplayObject> > tmplist;
+	if (!skipSubtree(true))
 	{
-		Locker l(mutexDisplayList);
-		tmplist.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
+		forEachChild([](DisplayObject* child) { child->initFrame(); });
+		updateSubtreeFlags();
 	}
-	auto it=tmplist.begin();
-	for(;it!=tmplist.end();it++)
-		(*it)->initFrame();
 
 	/* Set last_FP to reflect the frame that we have initialized currently.
 	 * This must be set before the constructor of this MovieClip is run,
@@ -6178,16 +6259,8 @@ void MovieClip::checkRatio(uint32_t ratio, bool inskipping)
 /* This is run in vm's thread context */
 void DisplayObjectContainer::advanceFrame()
 {
-	// elements of the dynamicDisplayList may be removed during advanceFrame() calls,
-	// so we create a temporary list containing all elements
-	std::vector < _R<DisplayObject> > tmplist;
-	{
-		Locker l(mutexDisplayList);
-		tmplist.assign(dynamicDisplayList.begin(),dynamicDisplayList.end());
-	}
-	auto it=tmplist.begin();
-	for(;it!=tmplist.end();it++)
-		(*it)->advanceFrame();
+	if (!skipSubtree(false))
+		forEachChild([](DisplayObject* child) { child->advanceFrame(); });
 }
 
 /* Update state.last_FP. If enough frames
@@ -108,6 +108,26 @@ private:
 	unordered_map<DisplayObject*,int32_t> mapLegacyChildToDepth;
 	map<int32_t,_NR<DisplayObject>> namedRemovedLegacyChildren;
 	set<int32_t> legacyChildrenMarkedForDeletion;
+	// a running traversal of the display list in advanceFrame/declareFrame/initFrame/executeFrameScript.
+	// the display list is only copied if it is modified while the traversal is running
+	class DisplayListTraversal
+	{
+	friend class DisplayObjectContainer;
+	private:
+		DisplayObjectContainer* container;
+		DisplayListTraversal* next;
+		std::vector < _R<DisplayObject> > snapshot;
+		bool hasSnapshot;
+	public:
+		DisplayListTraversal(DisplayObjectContainer* c);
+		~DisplayListTraversal();
+		DisplayObject* getChild(size_t index);
+	};
+	DisplayListTraversal* activeTraversals;
+	enum SUBTREE_FLAGS { SUBTREE_FLAGS_VALID=0x1, SUBTREE_HAS_TIMELINE=0x2, SUBTREE_NEEDS_INIT=0x4 };
+	// cached information about all descendants, used to skip subtrees that have nothing to do in a frame
+	uint32_t subtreeFlags;
+	void invalidateSubtreeFlags();
 	bool _contains(_R<DisplayObject> child);
 	void getObjectsFromPoint(Point* point, Array* ar);
 protected:
@@ -127,6 +147,11 @@ protected:
 	virtual void resetToStart() {}
 	ASPROPERTY_GETTER_SETTER(bool, tabChildren);
 	void LegacyChildEraseDeletionMarked();
+	template<class F> void forEachChild(F f);
+	// has to be called with mutexDisplayList locked before dynamicDisplayList is modified
+	void displayListChanged();
+	void updateSubtreeFlags();
+	bool skipSubtree(bool forinit) const;
 public:
 	DisplayObject* findRemovedLegacyChild(uint32_t name);
 	void eraseRemovedLegacyChild(uint32_t name);
@@ -1684,18 +1684,18 @@ ASFUNCTIONBODY_ATOM(IndexBuffer3D,uploadFromByteArray)
 	ARG_UNPACK_ATOM(data)(byteArrayOffset)(startOffset)(count);
 	if (data.isNull())
 		throwError<TypeError>(kNullPointerError);
-	if (data->getLength() < byteArrayOffset+count*2)
+	if (data->getLength() < uint64_t(byteArrayOffset)+uint64_t(count)*2)
 		throwError<RangeError>(kParamRangeError);
 	th->context->rendermutex.lock();
 	if (th->data.size() < count+startOffset)
 		th->data.resize(count+startOffset);
 	uint32_t origpos = data->getPosition();
 	data->setPosition(byteArrayOffset);
-	for (uint32_t i = 0; i< count; i++)
+	if (!data->readShorts(th->data.data()+startOffset,count))
 	{
-		uint16_t d;
-		if (data->readShort(d))
-			th->data[startOffset+i] = d;
+		th->context->rendermutex.unlock();
+		data->setPosition(origpos);
+		throwError<RangeError>(kParamRangeError);
 	}
 	renderaction action;
 	action.action =RENDER_ACTION::RENDER_UPLOADINDEXBUFFER;
@@ -1821,21 +1821,18 @@ ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromByteArray)
 	ARG_UNPACK_ATOM(data)(byteArrayOffset)(startVertex)(numVertices);
 	if (data.isNull())
 		throwError<TypeError>(kNullPointerError);
-	if (data->getLength() < byteArrayOffset+numVertices*th->data32PerVertex*4)
+	if (data->getLength() < uint64_t(byteArrayOffset)+uint64_t(numVertices)*th->data32PerVertex*4)
 		throwError<RangeError>(kParamRangeError);
 	uint32_t origpos = data->getPosition();
 	data->setPosition(byteArrayOffset);
 	th->context->rendermutex.lock();
 	if (th->data.size() < (numVertices+startVertex)* th->data32PerVertex)
 		th->data.resize((numVertices+startVertex)* th->data32PerVertex);
-	for (uint32_t i = 0; i< numVertices* th->data32PerVertex; i++)
+	if (!data->readFloats(th->data.data()+startVertex*th->data32PerVertex,numVertices* th->data32PerVertex))
 	{
-		union {
-			float f;
-			uint32_t u;
-		} d;
-		if (data->readUnsignedInt(d.u))
-			th->data[startVertex*th->data32PerVertex+i] = d.f;
+		th->context->rendermutex.unlock();
+		data->setPosition(origpos);
+		throwError<RangeError>(kParamRangeError);
 	}
 	renderaction action;
 	action.action =RENDER_ACTION::RENDER_UPLOADVERTEXBUFFER;
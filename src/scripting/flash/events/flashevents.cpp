@@ -53,6 +53,20 @@ void listener::resetClosure()
 		asAtomHandler::as<IFunction>(f)->closure_this.reset();
 }
 
+listenerSnapshot::listenerSnapshot(const listenerSnapshot& r):listeners(r.listeners)
+{
+	for (auto it = listeners.begin(); it != listeners.end(); it++)
+		ASATOM_INCREF(it->f);
+}
+
+listenerSnapshot::~listenerSnapshot()
+{
+	for (auto it = listeners.begin(); it != listeners.end(); it++)
+	{
+		ASATOM_DECREF(it->f);
+	}
+}
+
 void IEventDispatcher::linkTraits(Class_base* c)
 {
 	lookupAndLink(c,STRING_ADDEVENTLISTENER,STRING_FLASH_EVENTS_IEVENTDISPATCHER);
@@ -62,10 +76,17 @@ void IEventDispatcher::linkTraits(Class_base* c)
 }
 
 Event::Event(ASWorker* wrk, Class_base* cb, const tiny_string& t, bool b, bool c, CLASS_SUBTYPE st):
-	ASObject(wrk,cb,T_OBJECT,st),bubbles(b),cancelable(c),defaultPrevented(false),propagationStopped(false),immediatePropagationStopped(false),queued(false),
+	ASObject(wrk,cb,T_OBJECT,st),typeID(UINT32_MAX),bubbles(b),cancelable(c),defaultPrevented(false),propagationStopped(false),immediatePropagationStopped(false),queued(false),
 	eventPhase(0),type(t),target(asAtomHandler::invalidAtom),currentTarget()
 {
 }
+
+uint32_t Event::getTypeID()
+{
+	if (typeID == UINT32_MAX)
+		typeID = getSystemState()->getUniqueStringId(type);
+	return typeID;
+}
 void Event::finalize()
 {
 	ASObject::finalize();
@@ -73,9 +94,39 @@ void Event::finalize()
 	target = asAtomHandler::invalidAtom;
 }
 
+bool Event::destruct()
+{
+	typeID = UINT32_MAX;
+	bubbles = false;
+	cancelable = false;
+	resetDispatchState();
+	type = "Event";
+	return ASObject::destruct();
+}
+
+void Event::resetDispatchState()
+{
+	defaultPrevented = false;
+	propagationStopped = false;
+	immediatePropagationStopped = false;
+	eventPhase = 0;
+	currentTarget.reset();
+	target = asAtomHandler::invalidAtom;
+}
+
+void Event::reinit(const tiny_string& t, bool b, bool c)
+{
+	resetDispatchState();
+	type = t;
+	typeID = UINT32_MAX;
+	bubbles = b;
+	cancelable = c;
+}
+
 void Event::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_SEALED);
+	c->isReusable = true;
 	c->setVariableAtomByQName("ACTIVATE",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"activate"),DECLARED_TRAIT);
 	c->setVariableAtomByQName("ADDED",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"added"),DECLARED_TRAIT);
 	c->setVariableAtomByQName("ADDED_TO_STAGE",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"addedToStage"),DECLARED_TRAIT);
@@ -159,6 +210,7 @@ ASFUNCTIONBODY_ATOM(Event,_constructor)
 
 	Event* th=asAtomHandler::as<Event>(obj);
 	ARG_UNPACK_ATOM(th->type)(th->bubbles, false)(th->cancelable, false);
+	th->typeID = UINT32_MAX;
 }
 
 ASFUNCTIONBODY_GETTER(Event,currentTarget)
@@ -286,6 +338,42 @@ MouseEvent::MouseEvent(ASWorker* wrk, Class_base* c, const tiny_string& t, numbe
 {
 }
 
+bool MouseEvent::destruct()
+{
+	modifiers = KMOD_NONE;
+	buttonDown = false;
+	delta = 1;
+	localX = 0;
+	localY = 0;
+	stageX = 0;
+	stageY = 0;
+	relatedObject.reset();
+	return Event::destruct();
+}
+
+void MouseEvent::updateMouseState(number_t lx, number_t ly, SDL_Keymod _modifiers, bool _buttonDown)
+{
+	resetDispatchState();
+	localX = lx;
+	localY = ly;
+	modifiers = _modifiers;
+	buttonDown = _buttonDown;
+}
+
+void MouseEvent::reinit(const tiny_string& t, number_t lx, number_t ly, bool b, SDL_Keymod _modifiers, bool _buttonDown,
+		       _NR<InteractiveObject> relObj, int32_t _delta)
+{
+	Event::reinit(t,b,false);
+	modifiers = _modifiers;
+	buttonDown = _buttonDown;
+	delta = _delta;
+	localX = lx;
+	localY = ly;
+	stageX = 0;
+	stageY = 0;
+	relatedObject = relObj;
+}
+
 Event* MouseEvent::cloneImpl() const
 {
 	return Class<MouseEvent>::getInstanceS(getInstanceWorker(),type,localX,localY,bubbles,(SDL_Keymod)modifiers,buttonDown,relatedObject,delta);
@@ -346,6 +434,7 @@ ASFUNCTIONBODY_ATOM(TimerEvent,updateAfterEvent)
 void MouseEvent::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, Event, _constructor, CLASS_SEALED);
+	c->isReusable = true;
 	c->setVariableAtomByQName("CLICK",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"click"),DECLARED_TRAIT);
 	c->setVariableAtomByQName("DOUBLE_CLICK",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"doubleClick"),DECLARED_TRAIT);
 	c->setVariableAtomByQName("MOUSE_DOWN",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"mouseDown"),DECLARED_TRAIT);
@@ -571,43 +660,35 @@ void IOErrorEvent::sinit(Class_base* c)
 	c->setVariableAtomByQName("STANDARD_OUTPUT_IO_ERROR",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"standardOutputIoError"),CONSTANT_TRAIT);
 }
 
-EventDispatcher::EventDispatcher(ASWorker* wrk, Class_base* c):ASObject(wrk,c),forcedTarget(asAtomHandler::invalidAtom)
+EventDispatcher::EventDispatcher(ASWorker* wrk, Class_base* c):ASObject(wrk,c),handlerTypeMask(0),forcedTarget(asAtomHandler::invalidAtom)
 {
 }
 
-void EventDispatcher::finalize()
+void EventDispatcher::clearHandlers()
 {
 	auto it=handlers.begin();
 	while(it!=handlers.end())
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
+		for (auto it2 = it->second->listeners.begin(); it2 != it->second->listeners.end(); it2++)
 		{
 			IFunction* f = asAtomHandler::as<IFunction>((*it2).f);
 			getSystemState()->unregisterListenerFunction(f);
-			f->decRef();
-			it2 = it->second.erase(it2);
 		}
+		// the listener functions are released when the last reference to the snapshot is gone
 		it = handlers.erase(it);
 	}
+	handlerTypeMask=0;
+}
+
+void EventDispatcher::finalize()
+{
+	clearHandlers();
 	ASObject::finalize();
 }
 bool EventDispatcher::destruct()
 {
 	forcedTarget = asAtomHandler::invalidAtom;
-	auto it=handlers.begin();
-	while(it!=handlers.end())
-	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
-		{
-			IFunction* f = asAtomHandler::as<IFunction>((*it2).f);
-			getSystemState()->unregisterListenerFunction(f);
-			f->decRef();
-			it2 = it->second.erase(it2);
-		}
-		it = handlers.erase(it);
-	}
+	clearHandlers();
 	return ASObject::destruct();
 }
 void EventDispatcher::prepareShutdown()
@@ -621,8 +702,8 @@ void EventDispatcher::prepareShutdown()
 	auto it=handlers.begin();
 	while(it!=handlers.end())
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
+		auto it2 = it->second->listeners.begin();
+		while (it2 != it->second->listeners.end())
 		{
 			ASObject* f = asAtomHandler::getObject((*it2).f);
 			if (f)
@@ -632,6 +713,22 @@ void EventDispatcher::prepareShutdown()
 		it++;
 	}
 }
+
+void EventDispatcher::updateHandlerTypeMask()
+{
+	uint64_t mask=0;
+	for (auto it=handlers.begin(); it!=handlers.end(); it++)
+		mask |= UINT64_C(1)<<(it->first%64);
+	handlerTypeMask=mask;
+}
+
+listenerSnapshot* EventDispatcher::getWritableHandlers(std::unordered_map<uint32_t,_R<listenerSnapshot>>::iterator h)
+{
+	// the snapshot is still used by a running dispatch, so we have to create a new one
+	if (h->second->getRefCount() > 1)
+		h->second = _MR(new listenerSnapshot(*h->second.getPtr()));
+	return h->second.getPtr();
+}
 void EventDispatcher::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_SEALED);
@@ -647,11 +744,11 @@ void EventDispatcher::sinit(Class_base* c)
 
 void EventDispatcher::dumpHandlers()
 {
-	std::map<tiny_string,list<listener> >::iterator it=handlers.begin();
+	auto it=handlers.begin();
 	for(;it!=handlers.end();++it)
 	{
-		for (auto it2 = it->second.begin();it2 != it->second.end(); it2++)
-			LOG(LOG_INFO, it->first<<":"<<asAtomHandler::toDebugString(it2->f));
+		for (auto it2 = it->second->listeners.begin();it2 != it->second->listeners.end(); it2++)
+			LOG(LOG_INFO, getSystemState()->getStringFromUniqueId(it->first)<<":"<<asAtomHandler::toDebugString(it2->f));
 	}
 }
 
@@ -673,34 +770,38 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 		LOG(LOG_NOT_IMPLEMENTED,"EventDispatcher::addEventListener parameter useWeakReference is ignored");
 
 	const tiny_string& eventName=asAtomHandler::toString(args[0],wrk);
+	BROADCAST_EVENT_TYPE broadcasttype;
 	if(wrk->isPrimordial // don't register frame listeners for background workers
-			&& th->is<DisplayObject>() && (eventName=="enterFrame"
-				|| eventName=="exitFrame"
-				|| eventName=="frameConstructed"
-				|| eventName=="render") )
+			&& th->is<DisplayObject>() && SystemState::getBroadcastEventType(eventName,broadcasttype))
 	{
-		th->getSystemState()->registerFrameListener(th->as<DisplayObject>());
+		th->getSystemState()->registerBroadcastListener(th->as<DisplayObject>(),broadcasttype);
 	}
 
+	uint32_t eventNameID = th->getSystemState()->getUniqueStringId(eventName);
 	{
 		Locker l(th->handlersMutex);
 		//Search if any listener is already registered for the event
-		list<listener>& listeners=th->handlers[eventName];
+		auto h = th->handlers.find(eventNameID);
+		if (h == th->handlers.end())
+			h = th->handlers.insert(make_pair(eventNameID,_MR(new listenerSnapshot()))).first;
 		const listener newListener(args[1], priority, useCapture, wrk);
 		//Ordered insertion
-		list<listener>::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
+		vector<listener>& listeners=h->second->listeners;
+		size_t insertionIndex=lower_bound(listeners.begin(),listeners.end(),newListener)-listeners.begin();
 		IFunction* newfunc = asAtomHandler::as<IFunction>(args[1]);
 		// check if a listener that matches type, use_capture and function is already registered
-		if (insertionPoint != listeners.end() && (*insertionPoint).use_capture == newListener.use_capture)
+		if (insertionIndex < listeners.size() && listeners[insertionIndex].use_capture == newListener.use_capture)
 		{
-			IFunction* insertPointFunc = asAtomHandler::as<IFunction>((*insertionPoint).f);
+			IFunction* insertPointFunc = asAtomHandler::as<IFunction>(listeners[insertionIndex].f);
 			if (insertPointFunc == newfunc || (insertPointFunc->clonedFrom && insertPointFunc->clonedFrom == newfunc->clonedFrom && insertPointFunc->closure_this==newfunc->closure_this))
 				return; // don't register the same listener twice
 		}
 		newfunc->incRef();
 		if (newfunc->clonedFrom)
 			th->getSystemState()->registerListenerFunction(newfunc);
-		listeners.insert(insertionPoint,newListener);
+		vector<listener>& writablelisteners=th->getWritableHandlers(h)->listeners;
+		writablelisteners.insert(writablelisteners.begin()+insertionIndex,newListener);
+		th->handlerTypeMask |= UINT64_C(1)<<(eventNameID%64);
 	}
 	th->eventListenerAdded(eventName);
 }
@@ -727,9 +828,10 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 	if(argslen>=3)
 		useCapture=asAtomHandler::Boolean_concrete(args[2]);
 
+	uint32_t eventNameID = th->getSystemState()->getUniqueStringId(eventName);
 	{
 		Locker l(th->handlersMutex);
-		map<tiny_string, list<listener> >::iterator h=th->handlers.find(eventName);
+		auto h=th->handlers.find(eventNameID);
 		if(h==th->handlers.end())
 		{
 			LOG(LOG_CALLS,"Event not found");
@@ -737,28 +839,31 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 		}
 
 		const listener ls(args[1],0,useCapture,wrk);
-		std::list<listener>::iterator it=find(h->second.begin(),h->second.end(),ls);
-		if(it!=h->second.end())
+		vector<listener>& listeners=h->second->listeners;
+		auto it=find(listeners.begin(),listeners.end(),ls);
+		if(it!=listeners.end())
 		{
 			ASObject* listenerfunc = asAtomHandler::getObject(it->f);
 			if (listenerfunc && listenerfunc->is<IFunction>() && listenerfunc->as<IFunction>()->clonedFrom)
 				th->getSystemState()->unregisterListenerFunction(listenerfunc->as<IFunction>());
-			ASATOM_DECREF(it->f);
-			h->second.erase(it);
+			size_t index = it-listeners.begin();
+			vector<listener>& writablelisteners=th->getWritableHandlers(h)->listeners;
+			ASATOM_DECREF(writablelisteners[index].f);
+			writablelisteners.erase(writablelisteners.begin()+index);
 		}
-		if(h->second.empty()) //Remove the entry from the map
+		if(h->second->listeners.empty()) //Remove the entry from the map
+		{
 			th->handlers.erase(h);
+			th->updateHandlerTypeMask();
+		}
 	}
 
-	// Only unregister the enterFrame listener _after_ the handlers have been erased.
-	if(th->is<DisplayObject>() && (eventName=="enterFrame"
-					|| eventName=="exitFrame"
-					|| eventName=="frameConstructed")
-				&& (!th->hasEventListener("enterFrame")
-					&& !th->hasEventListener("exitFrame")
-					&& !th->hasEventListener("frameConstructed")) )
+	// Only unregister the broadcast listener _after_ the handlers have been erased.
+	BROADCAST_EVENT_TYPE broadcasttype;
+	if(th->is<DisplayObject>() && SystemState::getBroadcastEventType(eventName,broadcasttype)
+				&& !th->hasEventListener(eventNameID))
 	{
-		th->getSystemState()->unregisterFrameListener(th->as<DisplayObject>());
+		th->getSystemState()->unregisterBroadcastListener(th->as<DisplayObject>(),broadcasttype);
 	}
 }
 
@@ -821,36 +926,29 @@ void EventDispatcher::handleEvent(_R<Event> e)
 {
 	check();
 	e->check();
+	uint32_t typeID = e->getTypeID();
+	if (!(handlerTypeMask & (UINT64_C(1)<<(typeID%64))))
+		return;
 	Locker l(handlersMutex);
-	map<tiny_string, list<listener> >::iterator h=handlers.find(e->type);
+	auto h=handlers.find(typeID);
 	if(h==handlers.end())
 		return;
 
-	LOG(LOG_CALLS,"Handling event " << h->first<<" "<<e->getInstanceWorker());
+	LOG(LOG_CALLS,"Handling event " << e->type<<" "<<e->getInstanceWorker());
 
-	//Create a temporary copy of the listeners, as the list can be modified during the calls
-	vector<listener> tmpListener(h->second.begin(),h->second.end());
-	l.release();
-	// listeners may be removed during the call to a listener, so we have to incref them before the call
+	// the list can be modified during the calls, so we keep a reference to the current snapshot
+	// any modification will create a new snapshot, so the listeners stay alive until we are finished
 	// TODO how to handle listeners that are removed during the call to a listener, should they really be executed anyway?
-	for(unsigned int i=0;i<tmpListener.size();i++)
-	{
-		//tmpListener is now also owned by the vector
-		ASATOM_INCREF(tmpListener[i].f);
-	}
+	_R<listenerSnapshot> snapshot = h->second;
+	l.release();
+	vector<listener>& tmpListener = snapshot->listeners;
 	for(unsigned int i=0;i<tmpListener.size();i++)
 	{
 		if( (e->eventPhase == EventPhase::BUBBLING_PHASE && tmpListener[i].use_capture)
 		||  (e->eventPhase == EventPhase::CAPTURING_PHASE && !tmpListener[i].use_capture))
-		{
-			ASATOM_DECREF(tmpListener[i].f);
 			continue;
-		}
 		if (tmpListener[i].worker != e->getInstanceWorker()) // only handle listeners that are available in the current worker
-		{
-			ASATOM_DECREF(tmpListener[i].f);
 			continue;
-		}
 		if (e->immediatePropagationStopped)
 			break;
 		asAtom arg0= asAtomHandler::fromObject(e.getPtr());
@@ -859,8 +957,6 @@ void EventDispatcher::handleEvent(_R<Event> e)
 		asAtom ret=asAtomHandler::invalidAtom;
 		asAtomHandler::callFunction(tmpListener[i].f,tmpListener[i].worker,ret,v,&arg0,1,false);
 		ASATOM_DECREF(ret);
-		//And now no more, f can also be deleted
-		ASATOM_DECREF(tmpListener[i].f);
 		afterExecution(e);
 	}
 	e->check();
@@ -868,8 +964,15 @@ void EventDispatcher::handleEvent(_R<Event> e)
 
 bool EventDispatcher::hasEventListener(const tiny_string& eventName)
 {
+	return hasEventListener(getSystemState()->getUniqueStringId(eventName));
+}
+
+bool EventDispatcher::hasEventListener(uint32_t eventNameID)
+{
+	if (!(handlerTypeMask & (UINT64_C(1)<<(eventNameID%64))))
+		return false;
 	Locker l(handlersMutex);
-	if(handlers.find(eventName)==handlers.end())
+	if(handlers.find(eventNameID)==handlers.end())
 		return false;
 	else
 		return true;
@@ -964,9 +1067,30 @@ KeyboardEvent::KeyboardEvent(ASWorker* wrk, Class_base* c, tiny_string _type, ui
 {
 }
 
+bool KeyboardEvent::destruct()
+{
+	modifiers = KMOD_NONE;
+	charCode = 0;
+	keyCode = 0;
+	keyLocation = 0;
+	sdlkeycode = SDLK_UNKNOWN;
+	return Event::destruct();
+}
+
+void KeyboardEvent::reinit(const tiny_string& _type, uint32_t _charcode, uint32_t _keycode, SDL_Keymod _modifiers, SDL_Keycode _sdlkeycode)
+{
+	Event::reinit(_type,false,false);
+	modifiers = _modifiers;
+	charCode = _charcode;
+	keyCode = _keycode;
+	keyLocation = 0;
+	sdlkeycode = _sdlkeycode;
+}
+
 void KeyboardEvent::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, Event, _constructor, CLASS_SEALED);
+	c->isReusable = true;
 	REGISTER_GETTER_SETTER_RESULTTYPE(c, altKey,Boolean);
 	REGISTER_GETTER_SETTER_RESULTTYPE(c, charCode,UInteger);
 	REGISTER_GETTER_SETTER_RESULTTYPE(c, commandKey,Boolean);
@@ -46,9 +46,16 @@ class ByteArray;
 
 class Event: public ASObject
 {
+private:
+	uint32_t typeID;
 public:
 	Event(ASWorker* wrk, Class_base* cb, const tiny_string& t = "Event", bool b=false, bool c=false, CLASS_SUBTYPE st=SUBTYPE_EVENT);
 	void finalize() override;
+	bool destruct() override;
+	// resets the state changed during dispatching, so the event can be dispatched again
+	void resetDispatchState();
+	// sets the data of a recycled event like the constructor does
+	void reinit(const tiny_string& t, bool b, bool c);
 	static void sinit(Class_base*);
 	static void buildTraits(ASObject* o);
 	virtual void setTarget(asAtom t) {target = t; }
@@ -72,6 +79,11 @@ public:
 	ASPROPERTY_GETTER(_NR<ASObject>,currentTarget);
 	ASFUNCTION_ATOM(stopPropagation);
 	ASFUNCTION_ATOM(stopImmediatePropagation);
+	/*
+	 * returns the unique string id of type
+	 * the id is computed on first use, so type must not be changed after the event was dispatched
+	 */
+	uint32_t getTypeID();
 private:
 	/*
 	 * To be implemented by each derived class to allow redispatching
@@ -117,6 +129,8 @@ private:
 	SDL_Keycode sdlkeycode;
 public:
 	KeyboardEvent(ASWorker* wrk, Class_base* c, tiny_string _type="", uint32_t _charcode=0, uint32_t _keycode=0, SDL_Keymod modifiers=KMOD_NONE, SDL_Keycode _sdlkeycode=SDLK_UNKNOWN);
+	bool destruct() override;
+	void reinit(const tiny_string& _type, uint32_t _charcode, uint32_t _keycode, SDL_Keymod _modifiers, SDL_Keycode _sdlkeycode);
 	static void sinit(Class_base*);
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_GETTER_SETTER(altKey);
@@ -253,8 +267,13 @@ public:
 	MouseEvent(ASWorker* wrk, Class_base* c, const tiny_string& t, number_t lx, number_t ly,
 		   bool b=true, SDL_Keymod _modifiers=KMOD_NONE,bool _buttonDown = false,
 		   _NR<InteractiveObject> relObj = NullRef, int32_t delta=1);
+	bool destruct() override;
 	static void sinit(Class_base*);
 	void setTarget(asAtom t) override;
+	// sets new mouse data for an event that is not dispatched yet or that is recycled after dispatching
+	void updateMouseState(number_t lx, number_t ly, SDL_Keymod _modifiers, bool _buttonDown);
+	void reinit(const tiny_string& t, number_t lx, number_t ly, bool b, SDL_Keymod _modifiers, bool _buttonDown,
+		    _NR<InteractiveObject> relObj, int32_t _delta);
 	EVENT_TYPE getEventType() const override { return MOUSE_EVENT;}
 	ASFUNCTION_ATOM(_constructor);
 	ASPROPERTY_GETTER_SETTER(bool,buttonDown);
@@ -292,6 +311,7 @@ public:
 class listener
 {
 friend class EventDispatcher;
+friend class listenerSnapshot;
 private:
 	asAtom f=asAtomHandler::invalidAtom;
 	int32_t priority;
@@ -312,6 +332,20 @@ public:
 	void resetClosure();
 };
 
+/*
+ * All listeners registered for one event type, sorted by priority.
+ * The snapshot holds a reference to every listener function.
+ * It is never modified while it is shared, so dispatching can iterate over it without copying
+ */
+class listenerSnapshot: public RefCountable
+{
+public:
+	std::vector<listener> listeners;
+	listenerSnapshot() {}
+	listenerSnapshot(const listenerSnapshot& r);
+	~listenerSnapshot();
+};
+
 class IEventDispatcher
 {
 public:
@@ -322,7 +356,14 @@ class EventDispatcher: public ASObject, public IEventDispatcher
 {
 private:
 	Mutex handlersMutex;
-	std::map<tiny_string,std::list<listener> > handlers;
+	// listeners keyed by the unique string id of the event type
+	std::unordered_map<uint32_t,_R<listenerSnapshot>> handlers;
+	// one bit for every (event type id % 64) with registered listeners, allows to skip dispatching without locking
+	ACQUIRE_RELEASE_VARIABLE(uint64_t,handlerTypeMask);
+	void updateHandlerTypeMask();
+	void clearHandlers();
+	// returns a snapshot that is not shared with a running dispatch and may be modified
+	listenerSnapshot* getWritableHandlers(std::unordered_map<uint32_t,_R<listenerSnapshot>>::iterator h);
 	/*
 	 * This will be used when a target is passed to EventDispatcher constructor
 	 */
@@ -342,6 +383,7 @@ public:
 	void handleEvent(_R<Event> e);
 	void dumpHandlers();
 	bool hasEventListener(const tiny_string& eventName);
+	bool hasEventListener(uint32_t eventNameID);
 	virtual void defaultEventBehavior(_R<Event> e) {}
 	virtual void afterExecution(_R<Event> e) {}
 	ASFUNCTION_ATOM(_constructor);
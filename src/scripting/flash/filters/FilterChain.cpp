@@ -0,0 +1,270 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/flash/filters/FilterChain.h"
+#include "scripting/flash/filters/flashfilters.h"
+#include "scripting/flash/display/BitmapContainer.h"
+#include "scripting/flash/display/flashdisplay.h"
+#include "scripting/flash/geom/flashgeom.h"
+#include "scripting/toplevel/Array.h"
+#include "backends/pixelops.h"
+
+using namespace lightspark;
+using namespace std;
+
+namespace
+{
+
+bool isEmptyRegion(const RECT& r)
+{
+	return r.Xmin >= r.Xmax || r.Ymin >= r.Ymax;
+}
+
+}
+
+FilterChain::FilterChain(SystemState* s):sys(s)
+{
+}
+
+FilterChain::~FilterChain()
+{
+	for (auto it = buffers.begin(); it != buffers.end(); ++it)
+		delete *it;
+}
+
+vector<uint8_t>* FilterChain::getBuffer(uint32_t size)
+{
+	Locker l(mutex);
+	// the smallest buffer that is large enough, otherwise the largest one is grown
+	auto found = buffers.end();
+	for (auto it = buffers.begin(); it != buffers.end(); ++it)
+	{
+		if (found == buffers.end())
+			found = it;
+		else if ((*it)->capacity() >= size)
+		{
+			if ((*found)->capacity() < size || (*it)->capacity() < (*found)->capacity())
+				found = it;
+		}
+		else if ((*found)->capacity() < size && (*it)->capacity() > (*found)->capacity())
+			found = it;
+	}
+	vector<uint8_t>* buf;
+	if (found == buffers.end())
+		buf = new vector<uint8_t>();
+	else
+	{
+		buf = *found;
+		buffers.erase(found);
+	}
+	buf->resize(size);
+	return buf;
+}
+
+void FilterChain::releaseBuffer(vector<uint8_t>* buf)
+{
+	Locker l(mutex);
+	buffers.push_back(buf);
+	if (buffers.size() > FILTERCHAIN_MAX_BUFFERS)
+	{
+		// the smallest buffer is the least useful one
+		auto smallest = buffers.begin();
+		for (auto it = buffers.begin(); it != buffers.end(); ++it)
+		{
+			if ((*it)->capacity() < (*smallest)->capacity())
+				smallest = it;
+		}
+		delete *smallest;
+		buffers.erase(smallest);
+	}
+}
+
+RECT FilterChain::getContentRegion(BitmapContainer* target)
+{
+	int32_t width = target->getWidth();
+	int32_t height = target->getHeight();
+	RECT region(width,0,height,0);
+	Mutex regionMutex;
+	PixelOps::forEachRow(sys,height,width,[&](uint32_t first, uint32_t last)
+	{
+		RECT r(width,0,height,0);
+		for (uint32_t y = first; y < last; y++)
+		{
+			uint32_t x0,x1;
+			if (!PixelOps::findColor(target->getPixelRow(y),width,0xff000000,0,false,x0,x1))
+				continue;
+			r.Xmin = min(r.Xmin,int(x0));
+			r.Xmax = max(r.Xmax,int(x1)+1);
+			r.Ymin = min(r.Ymin,int(y));
+			r.Ymax = int(y)+1;
+		}
+		Locker l(regionMutex);
+		region.Xmin = min(region.Xmin,r.Xmin);
+		region.Xmax = max(region.Xmax,r.Xmax);
+		region.Ymin = min(region.Ymin,r.Ymin);
+		region.Ymax = max(region.Ymax,r.Ymax);
+	});
+	return region;
+}
+
+bool FilterChain::getFilterRegion(BitmapContainer* target, BitmapFilter* f, const RECT& region, RECT& roi, number_t scalex, number_t scaley)
+{
+	roi = region;
+	if (!f->getChangedRegion(roi,scalex,scaley))
+		return false;
+	roi.Xmin = max(roi.Xmin,0);
+	roi.Xmax = min(roi.Xmax,int(target->getWidth()));
+	roi.Ymin = max(roi.Ymin,0);
+	roi.Ymax = min(roi.Ymax,int(target->getHeight()));
+	return true;
+}
+
+void FilterChain::applyFilter(BitmapContainer* target, BitmapFilter* f, RECT& region, number_t scalex, number_t scaley)
+{
+	RECT roi;
+	if (!getFilterRegion(target,f,region,roi,scalex,scaley))
+	{
+		RECT bounds(0,target->getWidth(),0,target->getHeight());
+		f->applyFilter(target,nullptr,bounds,0,0,scalex,scaley);
+		region = bounds;
+		return;
+	}
+	// the filter can't change anything if all pixels are transparent
+	if (isEmptyRegion(region) || isEmptyRegion(roi))
+		return;
+	uint32_t width = roi.Xmax-roi.Xmin;
+	uint32_t height = roi.Ymax-roi.Ymin;
+	bool alphaOnly = f->usesSourceAlphaOnly();
+	vector<uint8_t>* buf = getBuffer(width*height*(alphaOnly ? 1 : 4));
+	BitmapFilter::getSourceData(target,roi,&(*buf)[0],alphaOnly);
+	f->applyFilterData(target,&(*buf)[0],width,height,roi.Xmin,roi.Ymin,scalex,scaley);
+	releaseBuffer(buf);
+	region = roi;
+}
+
+bool FilterChain::applyPixelFilters(BitmapContainer* target, const vector<number_t>& matrices, ColorTransform* ct, BitmapFilter* next, RECT& region, number_t scalex, number_t scaley)
+{
+	// transparent pixels stay transparent unless a matrix or the color transform adds to their alpha
+	bool keepsTransparent = true;
+	for (uint32_t i = 0; i < matrices.size(); i+=20)
+	{
+		uint8_t transparent[4] = { 0, 0, 0, 0 };
+		ColorMatrixFilter::applyMatrix(transparent,1,&matrices[i]);
+		keepsTransparent &= (transparent[0] | transparent[1] | transparent[2] | transparent[3]) == 0;
+	}
+	if (ct)
+	{
+		uint8_t transparent[4] = { 0, 0, 0, 0 };
+		ct->applyTransformation(transparent,4);
+		keepsTransparent &= (transparent[0] | transparent[1] | transparent[2] | transparent[3]) == 0;
+	}
+	if (!keepsTransparent)
+		region = RECT(0,target->getWidth(),0,target->getHeight());
+	RECT roi;
+	if (isEmptyRegion(region))
+	{
+		// next can't change anything either if it is restricted to a region
+		return next && getFilterRegion(target,next,region,roi,scalex,scaley);
+	}
+
+	// the alpha channel of the region next is applied to is collected while the rows are transformed
+	vector<uint8_t>* alpha = nullptr;
+	uint32_t alphaWidth = 0;
+	if (next && getFilterRegion(target,next,region,roi,scalex,scaley))
+	{
+		alphaWidth = roi.Xmax-roi.Xmin;
+		alpha = getBuffer(alphaWidth*(roi.Ymax-roi.Ymin));
+		// roi contains region, all pixels outside of it are transparent
+		memset(&(*alpha)[0],0,alpha->size());
+	}
+	uint32_t width = region.Xmax-region.Xmin;
+	PixelOps::forEachRow(sys,region.Ymax-region.Ymin,width,[&](uint32_t first, uint32_t last)
+	{
+		for (uint32_t y = region.Ymin+first; y < region.Ymin+last; y++)
+		{
+			uint8_t* row = (uint8_t*)target->getPixelRow(y,region.Xmin);
+			for (uint32_t i = 0; i < matrices.size(); i+=20)
+				ColorMatrixFilter::applyMatrix(row,width,&matrices[i]);
+			if (ct)
+				ct->applyTransformation(row,width*4);
+			if (alpha)
+			{
+				uint8_t* dst = &(*alpha)[(y-roi.Ymin)*alphaWidth+region.Xmin-roi.Xmin];
+				for (uint32_t x = 0; x < width; x++)
+					dst[x] = row[x*4+3];
+			}
+		}
+	});
+	if (!alpha)
+		return false;
+	next->applyFilterData(target,&(*alpha)[0],alphaWidth,roi.Ymax-roi.Ymin,roi.Xmin,roi.Ymin,scalex,scaley);
+	releaseBuffer(alpha);
+	region = roi;
+	return true;
+}
+
+void FilterChain::apply(BitmapContainer* target, Array* filters, ColorTransform* ct, number_t scalex, number_t scaley)
+{
+	if (target->isEmpty())
+		return;
+	vector<BitmapFilter*> stages;
+	if (filters)
+	{
+		for (uint32_t i = 0; i < filters->size(); i++)
+		{
+			asAtom f = asAtomHandler::invalidAtom;
+			filters->at_nocheck(f,i);
+			if (asAtomHandler::is<BitmapFilter>(f))
+				stages.push_back(asAtomHandler::as<BitmapFilter>(f));
+		}
+	}
+	if (stages.empty() && !ct)
+		return;
+	RECT region = getContentRegion(target);
+	uint32_t i = 0;
+	while (i < stages.size())
+	{
+		if (!stages[i]->is<ColorMatrixFilter>())
+		{
+			applyFilter(target,stages[i],region,scalex,scaley);
+			i++;
+			continue;
+		}
+		vector<number_t> matrices;
+		for (; i < stages.size() && stages[i]->is<ColorMatrixFilter>(); i++)
+		{
+			number_t m[20];
+			if (static_cast<ColorMatrixFilter*>(stages[i])->getMatrix(m))
+				matrices.insert(matrices.end(),m,m+20);
+			else
+				LOG(LOG_ERROR,"invalid matrix for ColorMatrixFilter");
+		}
+		ColorTransform* pixelct = nullptr;
+		if (i == stages.size())
+		{
+			pixelct = ct;
+			ct = nullptr;
+		}
+		BitmapFilter* next = i < stages.size() && stages[i]->usesSourceAlphaOnly() ? stages[i] : nullptr;
+		if (applyPixelFilters(target,matrices,pixelct,next,region,scalex,scaley))
+			i++;
+	}
+	if (ct)
+		applyPixelFilters(target,vector<number_t>(),ct,nullptr,region,scalex,scaley);
+}
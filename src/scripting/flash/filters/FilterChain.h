@@ -0,0 +1,72 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_FLASH_FILTERS_FILTERCHAIN_H
+#define SCRIPTING_FLASH_FILTERS_FILTERCHAIN_H 1
+
+#include "compat.h"
+#include "swftypes.h"
+#include "threading.h"
+#include <vector>
+
+// number of scratch buffers kept for the next filters
+#define FILTERCHAIN_MAX_BUFFERS 4
+
+namespace lightspark
+{
+
+class Array;
+class BitmapContainer;
+class BitmapFilter;
+class ColorTransform;
+class SystemState;
+
+/*
+ * Applies the filters of a DisplayObject to its cached bitmap.
+ * - every filter is only applied to the region where it can change pixels, starting with
+ *   the pixels that are not transparent and growing by the blur and offset of each filter
+ * - consecutive ColorMatrixFilters, and the ColorTransform if they are the last filters, are
+ *   applied to every row in one pass. If the next filter only needs the alpha channel it is
+ *   extracted in the same pass
+ * - the copies of the pixels each filter works on are taken from a pool of scratch buffers
+ */
+class FilterChain
+{
+private:
+	SystemState* sys;
+	Mutex mutex;
+	std::vector<std::vector<uint8_t>*> buffers;
+	std::vector<uint8_t>* getBuffer(uint32_t size);
+	void releaseBuffer(std::vector<uint8_t>* buf);
+	// returns the smallest rectangle containing all pixels of target that are not transparent
+	RECT getContentRegion(BitmapContainer* target);
+	// sets roi to the part of target filter f changes, returns false if f has to be applied to all of target
+	bool getFilterRegion(BitmapContainer* target, BitmapFilter* f, const RECT& region, RECT& roi, number_t scalex, number_t scaley);
+	void applyFilter(BitmapContainer* target, BitmapFilter* f, RECT& region, number_t scalex, number_t scaley);
+	// returns true if next was applied together with the matrices and the color transform
+	bool applyPixelFilters(BitmapContainer* target, const std::vector<number_t>& matrices, ColorTransform* ct, BitmapFilter* next, RECT& region, number_t scalex, number_t scaley);
+public:
+	FilterChain(SystemState* s);
+	~FilterChain();
+	// applies the BitmapFilters in filters and then ct to target, both may be null
+	void apply(BitmapContainer* target, Array* filters, ColorTransform* ct, number_t scalex, number_t scaley);
+};
+
+}
+#endif /* SCRIPTING_FLASH_FILTERS_FILTERCHAIN_H */
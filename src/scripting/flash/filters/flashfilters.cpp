@@ -22,6 +22,7 @@
 #include "scripting/argconv.h"
 #include "scripting/flash/display/BitmapData.h"
 #include "scripting/flash/geom/flashgeom.h"
+#include "backends/pixelops.h"
 
 using namespace std;
 using namespace lightspark;
@@ -33,6 +34,18 @@ void BitmapFilter::sinit(Class_base* c)
 }
 
 void BitmapFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos,number_t scalex,number_t scaley)
+{
+	if (sourceRect.Xmax <= sourceRect.Xmin || sourceRect.Ymax <= sourceRect.Ymin)
+		return;
+	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
+	uint32_t height = sourceRect.Ymax-sourceRect.Ymin;
+	bool alphaOnly = usesSourceAlphaOnly();
+	vector<uint8_t> data(width*height*(alphaOnly ? 1 : 4));
+	getSourceData(source ? source : target,sourceRect,&data[0],alphaOnly);
+	applyFilterData(target,&data[0],width,height,xpos*scalex,ypos*scaley,scalex,scaley);
+}
+
+void BitmapFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
 {
 	LOG(LOG_ERROR,"applyFilter for "<<this->toDebugString());
 }
@@ -66,275 +79,236 @@ int SHG_TABLE[] =
 	17, 16, 17, 17, 16, 17, 15, 16, 17, 14, 17, 16, 15, 17, 16, 17, 13, 17, 16, 17, 17, 16, 17, 14, 17, 16, 17, 16, 17, 16, 17, 9
 };
 
-void BitmapFilter::applyBlur(uint8_t* data, uint32_t width, uint32_t height, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley)
-{
-	blurx*=scalex;
-	blury*=scaley;
-	int radiusX = int(round(blurx)) >> 1;
-	int radiusY = int(round(blury)) >> 1;
-	if (radiusX >= int(sizeof(MUL_TABLE)/sizeof(int)))
-		radiusX = sizeof(MUL_TABLE)/sizeof(int)-1;
-	if (radiusY >= int(sizeof(MUL_TABLE)/sizeof(int)))
-		radiusY = sizeof(MUL_TABLE)/sizeof(int)-1;
-	if (radiusX<=0 || radiusY <= 0)
-		return;
-
-	int iterations = quality;
+namespace
+{
+/*
+ * One pass of the blur over a line of count pixels with N bytes each, step is the distance of
+ * two pixels in bytes. The stack of the horizontal pass starts with one more copy of the first
+ * pixel than the one of the vertical pass. The vertical pass clears the color of transparent pixels
+ * and clamps the colors in the last iteration
+ */
+template<uint32_t N>
+void blurLine(uint8_t* px, int count, int step, int radius, int initial, int ms, int ss, bool vertical, bool lastPass, uint8_t* stack)
+{
+	const int div = radius+radius+1;
+	const int last = count-1;
+	int sum[N];
+	for (uint32_t c = 0; c < N; c++)
+		sum[c] = (radius+1)*px[c];
+	int si = 0;
+	for (int i = 0; i < initial; i++)
+	{
+		for (uint32_t c = 0; c < N; c++)
+			stack[si*N+c] = px[c];
+		if (++si == div)
+			si = 0;
+	}
+	for (int i = 1; i <= radius; i++)
+	{
+		const uint8_t* p = px+(i < last ? i : last)*step;
+		for (uint32_t c = 0; c < N; c++)
+		{
+			stack[si*N+c] = p[c];
+			sum[c] += p[c];
+		}
+		if (++si == div)
+			si = 0;
+	}
+	si = 0;
+	for (int x = 0; x < count; x++)
+	{
+		uint8_t* out = px+x*step;
+		if (vertical)
+		{
+			uint32_t pa = uint32_t(sum[N-1] * ms) >> ss;
+			out[N-1] = pa;
+			if (lastPass)
+				pa = out[N-1];
+			for (uint32_t c = 0; c < N-1; c++)
+			{
+				uint32_t v = pa > 0 ? uint32_t(sum[c] * ms) >> ss : 0;
+				out[c] = lastPass && v > 255 ? 255 : v;
+			}
+		}
+		else
+		{
+			for (uint32_t c = 0; c < N; c++)
+				out[c] = uint32_t(sum[c] * ms) >> ss;
+		}
+		int p = x + radius + 1;
+		const uint8_t* in = px+(p < last ? p : last)*step;
+		for (uint32_t c = 0; c < N; c++)
+		{
+			sum[c] -= stack[si*N+c];
+			stack[si*N+c] = in[c];
+			sum[c] += in[c];
+		}
+		if (++si == div)
+			si = 0;
+	}
+}
 
-	uint8_t* px = data;
-	int x, y, i, p, yp, yi, yw;
-	int r, g, b, a, pr, pg, pb, pa;
+void blurLines(uint8_t* px, uint32_t channels, int count, int step, int radius, int initial, int ms, int ss, bool vertical, bool lastPass, uint8_t* stack)
+{
+	if (channels == 1)
+		blurLine<1>(px,count,step,radius,initial,ms,ss,vertical,lastPass,stack);
+	else
+		blurLine<4>(px,count,step,radius,initial,ms,ss,vertical,lastPass,stack);
+}
 
-	int divx = (radiusX + radiusX + 1);
-	int divy = (radiusY + radiusY + 1);
-	int w = width;
-	int h = height;
+int blurRadius(number_t blur, number_t scale)
+{
+	int radius = int(round(blur*scale)) >> 1;
+	if (radius >= int(sizeof(MUL_TABLE)/sizeof(int)))
+		radius = sizeof(MUL_TABLE)/sizeof(int)-1;
+	return radius;
+}
 
-	int w1 = w - 1;
-	int h1 = h - 1;
-	int rxp1 = radiusX + 1;
-	int ryp1 = radiusY + 1;
+}
 
-	std::vector<RGBA> ssx;
-	ssx.resize(divx);
-	std::vector<RGBA> ssy;
-	ssy.resize(divy);
+void BitmapFilter::applyBlur(SystemState* sys, uint8_t* data, uint32_t width, uint32_t height, uint32_t channels, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley)
+{
+	int radiusX = blurRadius(blurx,scalex);
+	int radiusY = blurRadius(blury,scaley);
+	if (radiusX<=0 || radiusY <= 0)
+		return;
 
 	int mtx = MUL_TABLE[radiusX];
 	int stx = SHG_TABLE[radiusX];
 	int mty = MUL_TABLE[radiusY];
 	int sty = SHG_TABLE[radiusY];
 
-	while (iterations > 0)
+	for (int iterations = quality; iterations > 0; iterations--)
 	{
-		iterations--;
-		yw = yi = 0;
-		int ms = mtx;
-		int ss = stx;
-		y = h;
-		do
+		// rows and columns are blurred independently of each other, so both passes are split across threads
+		PixelOps::forEachRow(sys,height,width,[&](uint32_t first, uint32_t last)
 		{
-			r = rxp1 * (pr = px[yi]);
-			g = rxp1 * (pg = px[yi + 1]);
-			b = rxp1 * (pb = px[yi + 2]);
-			a = rxp1 * (pa = px[yi + 3]);
-			auto sx = ssx.begin();
-			i = rxp1;
-			do
-			{
-				(*sx).Red = pr;
-				(*sx).Green = pg;
-				(*sx).Blue = pb;
-				(*sx).Alpha = pa;
-				sx++;
-				if (sx == ssx.end())
-					sx = ssx.begin();
-			}
-			while (--i > -1);
-			
-			for (i = 1; i < rxp1; i++)
-			{
-				p = yi + ((w1 < i ? w1 : i) << 2);
-				r += ((*sx).Red = px[p]);
-				g += ((*sx).Green = px[p + 1]);
-				b += ((*sx).Blue = px[p + 2]);
-				a += ((*sx).Alpha = px[p + 3]);
-				sx++;
-				if (sx == ssx.end())
-					sx = ssx.begin();
-			}
-			
-			auto si = ssx.begin();
-			for (x = 0; x < w; x++)
-			{
-				px[yi++] = uint32_t(r * ms) >> ss;
-				px[yi++] = uint32_t(g * ms) >> ss;
-				px[yi++] = uint32_t(b * ms) >> ss;
-				px[yi++] = uint32_t(a * ms) >> ss;
-				p = x + radiusX + 1;
-				p = (yw + (p < w1 ? p : w1)) << 2;
-				r -= (*si).Red;
-				r += ((*si).Red = px[p]);
-				g -= (*si).Green;
-				g += ((*si).Green = px[p + 1]);
-				b -= (*si).Blue;
-				b += ((*si).Blue = px[p + 2]);
-				a -= (*si).Alpha;
-				a += ((*si).Alpha = px[p + 3]);
-				si++;
-				if (si == ssx.end())
-					si = ssx.begin();
-			}
-			yw += w;
+			vector<uint8_t> stack((radiusX+radiusX+1)*channels);
+			for (uint32_t y = first; y < last; y++)
+				blurLines(data+y*width*channels,channels,width,channels,radiusX,radiusX+2,mtx,stx,false,false,&stack[0]);
+		});
+		PixelOps::forEachRow(sys,width,height,[&](uint32_t first, uint32_t last)
+		{
+			vector<uint8_t> stack((radiusY+radiusY+1)*channels);
+			for (uint32_t x = first; x < last; x++)
+				blurLines(data+x*channels,channels,height,width*channels,radiusY,radiusY+1,mty,sty,true,iterations == 1,&stack[0]);
+		});
+	}
+}
+
+void BitmapFilter::expandRegionByBlur(RECT& region, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley)
+{
+	int radiusX = blurRadius(blurx,scalex);
+	int radiusY = blurRadius(blury,scaley);
+	if (radiusX<=0 || radiusY <= 0 || quality <= 0)
+		return;
+	// every iteration spreads the pixels by the radius, one more pixel keeps the border of the region transparent
+	region.Xmin -= radiusX*quality+1;
+	region.Xmax += radiusX*quality+1;
+	region.Ymin -= radiusY*quality+1;
+	region.Ymax += radiusY*quality+1;
+}
+
+void BitmapFilter::expandRegionByOffset(RECT& region, int32_t dx, int32_t dy)
+{
+	if (dx < 0)
+		region.Xmin += dx;
+	else
+		region.Xmax += dx;
+	if (dy < 0)
+		region.Ymin += dy;
+	else
+		region.Ymax += dy;
+}
+
+void BitmapFilter::getSourceData(BitmapContainer* source, const RECT& sourceRect, uint8_t* data, bool alphaOnly)
+{
+	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
+	for (int32_t y = sourceRect.Ymin; y < sourceRect.Ymax; y++)
+	{
+		const uint32_t* row = source->getPixelRow(y,sourceRect.Xmin);
+		if (alphaOnly)
+		{
+			for (uint32_t x = 0; x < width; x++)
+				data[x] = row[x]>>24;
+			data += width;
 		}
-		while (--y > 0);
-		
-		ms = mty;
-		ss = sty;
-		for (x = 0; x < w; x++)
+		else
 		{
-			yi = x << 2;
-			r = ryp1 * (pr = px[yi]);
-			g = ryp1 * (pg = px[yi + 1]);
-			b = ryp1 * (pb = px[yi + 2]);
-			a = ryp1 * (pa = px[yi + 3]);
-			auto sy = ssy.begin();
-			for (i = 0; i< ryp1; i++)
-			{
-				(*sy).Red = pr;
-				(*sy).Green = pg;
-				(*sy).Blue = pb;
-				(*sy).Alpha = pa;
-				sy++;
-				if (sy == ssy.end())
-					sy = ssy.begin();
-			}
-			yp = w;
-			for (i = 1; i < (radiusY + 1); i++)
-			{
-				yi = (yp + x) << 2;
-				r += ((*sy).Red = px[yi]);
-				g += ((*sy).Green = px[yi + 1]);
-				b += ((*sy).Blue = px[yi + 2]);
-				a += ((*sy).Alpha = px[yi + 3]);
-				sy++;
-				if (sy == ssy.end())
-					sy = ssy.begin();
-				if (i < h1)
-				{
-					yp += w;
-				}
-			}
-			yi = x;
-			auto si = ssy.begin();
-			
-			if (iterations > 0)
+			memcpy(data,row,width*4);
+			data += width*4;
+		}
+	}
+}
+
+void BitmapFilter::copyToTarget(BitmapContainer* target, const uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos)
+{
+	int32_t x0 = max(0,-xpos);
+	int32_t x1 = min(int32_t(width),int32_t(target->getWidth())-xpos);
+	int32_t y0 = max(0,-ypos);
+	int32_t y1 = min(int32_t(height),int32_t(target->getHeight())-ypos);
+	for (int32_t y = y0; y < y1 && x0 < x1; y++)
+		memcpy(target->getPixelRow(ypos+y,xpos+x0),data+(y*width+x0)*4,(x1-x0)*4);
+}
+
+void BitmapFilter::applyDropShadowFilter(SystemState* sys, BitmapContainer* target, const uint8_t* alphadata, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t strength, number_t alpha, uint32_t color, bool inner, bool knockout)
+{
+	// only the part of the shadow inside of the target is drawn
+	int32_t x0 = max(0,-xpos);
+	int32_t x1 = min(int32_t(width),int32_t(target->getWidth())-xpos);
+	int32_t y0 = max(0,-ypos);
+	int32_t y1 = min(int32_t(height),int32_t(target->getHeight())-ypos);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	PixelOps::forEachRow(sys,y1-y0,x1-x0,[&](uint32_t first, uint32_t last)
+	{
+		for (int32_t y = y0+first; y < int32_t(y0+last); y++)
+		{
+			const uint8_t* src = alphadata+y*width;
+			uint8_t* row = (uint8_t*)target->getPixelRow(ypos+y);
+			for (int32_t x = x0; x < x1; x++)
 			{
-				for (y = 0; y<h; y++)
+				uint8_t* dst = row+(xpos+x)*4;
+				number_t glowalpha = (inner ? 0xff - src[x] : src[x]);
+				number_t srcalpha = max(0.0,min(1.0,glowalpha*alpha*strength/255.0));
+				number_t dstalpha = number_t(dst[3])/255.0;
+				if (inner)
 				{
-					p = yi << 2;
-					pa = uint32_t(a * ms) >> ss;
-					px[p + 3] = pa;
-					if (pa > 0)
+					if (knockout)
 					{
-						px[p] = (uint32_t(r * ms) >> ss);
-						px[p + 1] = (uint32_t(g * ms) >> ss);
-						px[p + 2] = (uint32_t(b * ms) >> ss);
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha));
 					}
 					else
 					{
-						px[p] = px[p + 1] = px[p + 2] = 0;
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha+number_t(dst[0])*(1.0-srcalpha)));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha+number_t(dst[1])*(1.0-srcalpha)));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha+number_t(dst[2])*(1.0-srcalpha)));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha+number_t(dst[3])*(1.0-srcalpha)));
 					}
-					p = y + ryp1;
-					p = (x + ((p < h1 ? p : h1) * w)) << 2;
-					r -= (*si).Red;
-					r += ((*si).Red = px[p]);
-					g -= (*si).Green;
-					g += ((*si).Green = px[p + 1]);
-					b -= (*si).Blue;
-					b += ((*si).Blue = px[p + 2]);
-					a -= (*si).Alpha;
-					a += ((*si).Alpha = px[p + 3]);
-					si++;
-					if (si == ssy.end())
-						si = ssy.begin();
-					yi += w;
 				}
-			}
-			else
-			{
-				for (y = 0; y < h; y++)
+				else
 				{
-					p = yi << 2;
-					px[p + 3] = pa = uint32_t(a * ms) >> ss;
-					if (pa > 0)
+					if (knockout)
 					{
-						pr = (uint32_t(r * ms) >> ss);
-						pg = (uint32_t(g * ms) >> ss);
-						pb = (uint32_t(b * ms) >> ss);
-						px[p] = pr > 255 ? 255 : pr;
-						px[p + 1] = pg > 255 ? 255 : pg;
-						px[p + 2] = pb > 255 ? 255 : pb;
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)));
 					}
 					else
 					{
-						px[p] = px[p + 1] = px[p + 2] = 0;
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[0])));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[1])));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[2])));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)+number_t(dst[3])));
 					}
-					p = y + ryp1;
-					p = (x + ((p < h1 ? p : h1) * w)) << 2;
-					r -= (*si).Red - ((*si).Red = px[p]);
-					g -= (*si).Green - ((*si).Green = px[p + 1]);
-					b -= (*si).Blue - ((*si).Blue = px[p + 2]);
-					a -= (*si).Alpha - ((*si).Alpha = px[p + 3]);
-					si++;
-					if (si == ssy.end())
-						si = ssy.begin();
-					yi += w;
 				}
 			}
 		}
-	}
-}
-void BitmapFilter::applyDropShadowFilter(BitmapContainer* target, uint8_t* tmpdata, const RECT& sourceRect, int xpos, int ypos, number_t strength, number_t alpha, uint32_t color, bool inner, bool knockout,number_t scalex,number_t scaley)
-{
-	xpos *= scalex;
-	ypos *= scaley;
-	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
-	uint32_t height = sourceRect.Ymax-sourceRect.Ymin;
-	uint32_t size = width*height;
-
-	uint8_t* data = target->getData();
-	int32_t startpos = ypos*target->getWidth();
-	int32_t targetsize = target->getWidth()*target->getHeight()*4;
-	for (uint32_t i = 0; i < size*4; i+=4)
-	{
-		if (i && i%(width*4)==0)
-			startpos+=target->getWidth();
-		if (startpos < 0)
-			continue;
-		int32_t targetpos = (xpos+startpos)*4+i%(width*4);
-		if (targetpos < 0)
-			continue;
-		if (targetpos+3 >= targetsize)
-			break;
-		number_t glowalpha = (inner ? 0xff - tmpdata[i+3] : tmpdata[i+3]);
-		number_t srcalpha = max(0.0,min(1.0,glowalpha*alpha*strength/255.0));
-		number_t dstalpha = number_t(data[targetpos+3])/255.0;
-		if (inner)
-		{
-			if (knockout)
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha));
-			}
-			else
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha+number_t(data[targetpos  ])*(1.0-srcalpha)));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha+number_t(data[targetpos+1])*(1.0-srcalpha)));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha+number_t(data[targetpos+2])*(1.0-srcalpha)));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha+number_t(data[targetpos+3])*(1.0-srcalpha)));
-			}
-		}
-		else
-		{
-			if (knockout)
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)));
-			}
-			else
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos  ])));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+1])));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+2])));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+3])));
-			}
-		}
-	}
+	});
 }
 void BitmapFilter::fillGradientColors(number_t* gradientalphas, uint32_t* gradientcolors,Array* ratios,Array* alphas,Array* colors)
 {
@@ -372,64 +346,66 @@ void BitmapFilter::fillGradientColors(number_t* gradientalphas, uint32_t* gradie
 		gradientcolors[i] = color;
 	}
 }
-void BitmapFilter::applyGradientFilter(BitmapContainer* target, uint8_t* tmpdata, const RECT& sourceRect, int xpos, int ypos, number_t strength, number_t* alphas, uint32_t* colors, bool inner, bool knockout,number_t scalex,number_t scaley)
+void BitmapFilter::applyGradientFilter(SystemState* sys, BitmapContainer* target, const uint8_t* alphadata, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t strength, number_t* alphas, uint32_t* colors, bool inner, bool knockout)
 {
-	xpos *= scalex;
-	ypos *= scaley;
-	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
-	uint32_t height = sourceRect.Ymax-sourceRect.Ymin;
-	uint32_t size = width*height;
-
-	uint8_t* data = target->getData();
-	uint32_t startpos = ypos*target->getWidth();
-	uint32_t targetsize = target->getWidth()*target->getHeight()*4;
-	for (uint32_t i = 0; i < size*4; i+=4)
+	// only the part of the shadow inside of the target is drawn
+	int32_t x0 = max(0,-xpos);
+	int32_t x1 = min(int32_t(width),int32_t(target->getWidth())-xpos);
+	int32_t y0 = max(0,-ypos);
+	int32_t y1 = min(int32_t(height),int32_t(target->getHeight())-ypos);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	PixelOps::forEachRow(sys,y1-y0,x1-x0,[&](uint32_t first, uint32_t last)
 	{
-		if (i && i%(width*4)==0)
-			startpos+=target->getWidth();
-		uint32_t targetpos = (xpos+startpos)*4+i%(width*4);
-		if (targetpos+3 >= targetsize)
-			break;
-		number_t glowalpha = (inner ? 0xff - tmpdata[i+3] : tmpdata[i+3]);
-		number_t alpha = alphas[uint32_t(glowalpha)];
-		number_t srcalpha = max(0.0,min(1.0,glowalpha*alpha*strength/255.0));
-		number_t dstalpha = number_t(data[targetpos+3])/255.0;
-		uint32_t color = colors[uint32_t(glowalpha)];
-		if (inner)
-		{
-			if (knockout)
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha));
-			}
-			else
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha+number_t(data[targetpos  ])*(1.0-srcalpha)));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha+number_t(data[targetpos+1])*(1.0-srcalpha)));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha+number_t(data[targetpos+2])*(1.0-srcalpha)));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha+number_t(data[targetpos+3])*(1.0-srcalpha)));
-			}
-		}
-		else
+		for (int32_t y = y0+first; y < int32_t(y0+last); y++)
 		{
-			if (knockout)
-			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)));
-			}
-			else
+			const uint8_t* src = alphadata+y*width;
+			uint8_t* row = (uint8_t*)target->getPixelRow(ypos+y);
+			for (int32_t x = x0; x < x1; x++)
 			{
-				data[targetpos  ] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos  ])));
-				data[targetpos+1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+1])));
-				data[targetpos+2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+2])));
-				data[targetpos+3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)+number_t(data[targetpos+3])));
+				uint8_t* dst = row+(xpos+x)*4;
+				number_t glowalpha = (inner ? 0xff - src[x] : src[x]);
+				number_t alpha = alphas[uint32_t(glowalpha)];
+				number_t srcalpha = max(0.0,min(1.0,glowalpha*alpha*strength/255.0));
+				number_t dstalpha = number_t(dst[3])/255.0;
+				uint32_t color = colors[uint32_t(glowalpha)];
+				if (inner)
+				{
+					if (knockout)
+					{
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha));
+					}
+					else
+					{
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*dstalpha+number_t(dst[0])*(1.0-srcalpha)));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*dstalpha+number_t(dst[1])*(1.0-srcalpha)));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*dstalpha+number_t(dst[2])*(1.0-srcalpha)));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*dstalpha+number_t(dst[3])*(1.0-srcalpha)));
+					}
+				}
+				else
+				{
+					if (knockout)
+					{
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)));
+					}
+					else
+					{
+						dst[0] = min(uint32_t(0xff),uint32_t(number_t((color    )&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[0])));
+						dst[1] = min(uint32_t(0xff),uint32_t(number_t((color>> 8)&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[1])));
+						dst[2] = min(uint32_t(0xff),uint32_t(number_t((color>>16)&0xff)*srcalpha*(1.0-dstalpha)+number_t(dst[2])));
+						dst[3] = min(uint32_t(0xff),uint32_t(number_t(0xff            )*srcalpha*(1.0-dstalpha)+number_t(dst[3])));
+					}
+				}
 			}
 		}
-	}
+	});
 }
 
 ASFUNCTIONBODY_ATOM(BitmapFilter,clone)
@@ -497,17 +473,15 @@ BitmapFilter* GlowFilter::cloneImpl() const
 	cloned->strength = strength;
 	return cloned;
 }
-void GlowFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos,number_t scalex,number_t scaley)
+bool GlowFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
 {
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
-	applyDropShadowFilter(target, tmpdata, sourceRect, xpos, ypos, strength, alpha, color, inner, knockout,scalex,scaley);
-	delete[] tmpdata;
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	return true;
+}
+void GlowFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
+{
+	applyBlur(getSystemState(),data,width,height,1,blurX,blurY,quality,scalex,scaley);
+	applyDropShadowFilter(getSystemState(),target,data,width,height,xpos,ypos,strength,alpha,color,inner,knockout);
 }
 
 DropShadowFilter::DropShadowFilter(ASWorker* wrk,Class_base* c):
@@ -522,21 +496,23 @@ DropShadowFilter::DropShadowFilter(ASWorker* wrk,Class_base* c,const DROPSHADOWF
 	knockout(filter.Knockout), quality(filter.Passes), strength(filter.Strength)
 {
 }
-void DropShadowFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool DropShadowFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
+{
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	expandRegionByOffset(region,cos(angle)*distance*scalex,sin(angle)*distance*scaley);
+	// an inner shadow is taken from the pixels on the opposite side of the offset
+	if (inner)
+		expandRegionByOffset(region,-cos(angle)*distance*scalex,-sin(angle)*distance*scaley);
+	return true;
+}
+void DropShadowFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
 {
-	xpos += cos(angle) * distance;
-	ypos +=	sin(angle) * distance;
+	xpos += int32_t(cos(angle) * distance * scalex);
+	ypos += int32_t(sin(angle) * distance * scaley);
 	if (hideObject)
 		LOG(LOG_NOT_IMPLEMENTED,"DropShadowFilter.hideObject");
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
-	applyDropShadowFilter(target, tmpdata, sourceRect, xpos, ypos, strength, alpha, color, inner, knockout,scalex,scaley);
-	delete[] tmpdata;
+	applyBlur(getSystemState(),data,width,height,1,blurX,blurY,quality,scalex,scaley);
+	applyDropShadowFilter(getSystemState(),target,data,width,height,xpos,ypos,strength,alpha,color,inner,knockout);
 }
 
 
@@ -652,20 +628,18 @@ void GradientGlowFilter::sinit(Class_base* c)
 	REGISTER_GETTER_SETTER(c, knockout);
 }
 
-void GradientGlowFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool GradientGlowFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
+{
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	return true;
+}
+void GradientGlowFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
 {
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-
 	number_t gradientalphas[256];
 	uint32_t gradientcolors[256];
 	fillGradientColors(gradientalphas,gradientcolors,this->ratios.getPtr(), this->alphas.getPtr(), this->colors.getPtr());
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
-	applyGradientFilter(target, tmpdata, sourceRect, xpos, ypos, strength, gradientalphas, gradientcolors, type=="inner", knockout,scalex,scaley);
-	delete[] tmpdata;
+	applyBlur(getSystemState(),data,width,height,1,blurX,blurY,quality,scalex,scaley);
+	applyGradientFilter(getSystemState(),target,data,width,height,xpos,ypos,strength,gradientalphas,gradientcolors,type=="inner",knockout);
 }
 
 void GradientGlowFilter::prepareShutdown()
@@ -765,22 +739,23 @@ ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(BevelFilter,shadowColor)
 ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(BevelFilter,strength)
 ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(BevelFilter,type)
 
-void BevelFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool BevelFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
+{
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	// the highlight and the shadow are offset in opposite directions, so the region also contains the
+	// pixels an inner bevel is taken from
+	expandRegionByOffset(region,cos(angle+M_PI)*distance*scalex,sin(angle+M_PI)*distance*scaley);
+	expandRegionByOffset(region,cos(angle)*distance*scalex,sin(angle)*distance*scaley);
+	return true;
+}
+void BevelFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
 {
 	if (type=="full")
 		LOG(LOG_NOT_IMPLEMENTED,"BevelFilter type 'full'");
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
+	applyBlur(getSystemState(),data,width,height,1,blurX,blurY,quality,scalex,scaley);
 	// TODO I've not found any useful documentation how BevelFilter should be implemented, so we just apply two dropShadowFilters with different angles and colors on the blurred data
-	applyDropShadowFilter(target, tmpdata, sourceRect, xpos+cos(angle+M_PI) * distance, ypos+sin(angle+M_PI) * distance, strength, highlightAlpha, highlightColor, type=="inner", knockout,scalex,scaley);
-	applyDropShadowFilter(target, tmpdata, sourceRect, xpos+cos(angle     ) * distance, ypos+sin(angle     ) * distance, strength, shadowAlpha   , shadowColor   , type=="inner", knockout,scalex,scaley);
-	delete[] tmpdata;
-
+	applyDropShadowFilter(getSystemState(),target,data,width,height,xpos+int32_t(cos(angle+M_PI) * distance * scalex),ypos+int32_t(sin(angle+M_PI) * distance * scaley),strength,highlightAlpha,highlightColor,type=="inner",knockout);
+	applyDropShadowFilter(getSystemState(),target,data,width,height,xpos+int32_t(cos(angle     ) * distance * scalex),ypos+int32_t(sin(angle     ) * distance * scaley),strength,shadowAlpha   ,shadowColor   ,type=="inner",knockout);
 }
 
 ASFUNCTIONBODY_ATOM(BevelFilter,_constructor)
@@ -827,51 +802,57 @@ void ColorMatrixFilter::sinit(Class_base* c)
 	REGISTER_GETTER_SETTER(c, matrix);
 }
 
-void ColorMatrixFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool ColorMatrixFilter::getMatrix(number_t* m)
 {
-	xpos *= scalex;
-	ypos *= scaley;
-	assert_and_throw(matrix->size() >= 20);
-	number_t m[20];
+	if (matrix.isNull() || matrix->size() < 20)
+		return false;
 	for (int i=0; i < 20; i++)
 	{
 		m[i] = asAtomHandler::toNumber(matrix->at(i));
 	}
-	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
-	uint32_t height = sourceRect.Ymax-sourceRect.Ymin;
-	uint32_t size = width*height;
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-	
-	uint8_t* data = target->getData();
-	uint32_t startpos = ypos*target->getWidth();
-	uint32_t targetsize = target->getWidth()*target->getHeight()*4;
-	for (uint32_t i = 0; i < size*4; i+=4)
-	{
-		if (i && i%(width*4)==0)
-			startpos+=target->getWidth();
-		uint32_t targetpos = (xpos+startpos)*4+i%(width*4);
-		if (targetpos+3 >= targetsize)
-			break;
+	return true;
+}
 
-		number_t srcA = number_t(tmpdata[i+3]);
-		number_t srcR = number_t(tmpdata[i+2])*srcA/255.0;
-		number_t srcG = number_t(tmpdata[i+1])*srcA/255.0;
-		number_t srcB = number_t(tmpdata[i  ])*srcA/255.0;
+void ColorMatrixFilter::applyMatrix(uint8_t* data, uint32_t count, const number_t* m)
+{
+	for (uint32_t i = 0; i < count*4; i+=4)
+	{
+		number_t srcA = number_t(data[i+3]);
+		number_t srcR = number_t(data[i+2])*srcA/255.0;
+		number_t srcG = number_t(data[i+1])*srcA/255.0;
+		number_t srcB = number_t(data[i  ])*srcA/255.0;
 		number_t redResult   = (m[0 ]*srcR) + (m[1 ]*srcG) + (m[2 ]*srcB) + (m[3 ]*srcA) + m[4 ];
 		number_t greenResult = (m[5 ]*srcR) + (m[6 ]*srcG) + (m[7 ]*srcB) + (m[8 ]*srcA) + m[9 ];
 		number_t blueResult  = (m[10]*srcR) + (m[11]*srcG) + (m[12]*srcB) + (m[13]*srcA) + m[14];
 		number_t alphaResult = (m[15]*srcR) + (m[16]*srcG) + (m[17]*srcB) + (m[18]*srcA) + m[19];
 
-		data[targetpos  ] = (max(int32_t(0),min(int32_t(0xff),int32_t(blueResult *alphaResult/255.0))));
-		data[targetpos+1] = (max(int32_t(0),min(int32_t(0xff),int32_t(greenResult*alphaResult/255.0))));
-		data[targetpos+2] = (max(int32_t(0),min(int32_t(0xff),int32_t(redResult  *alphaResult/255.0))));
-		data[targetpos+3] = (max(int32_t(0),min(int32_t(0xff),int32_t(alphaResult))));
+		data[i  ] = (max(int32_t(0),min(int32_t(0xff),int32_t(blueResult *alphaResult/255.0))));
+		data[i+1] = (max(int32_t(0),min(int32_t(0xff),int32_t(greenResult*alphaResult/255.0))));
+		data[i+2] = (max(int32_t(0),min(int32_t(0xff),int32_t(redResult  *alphaResult/255.0))));
+		data[i+3] = (max(int32_t(0),min(int32_t(0xff),int32_t(alphaResult))));
 	}
-	delete[] tmpdata;
+}
+
+bool ColorMatrixFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
+{
+	// the region only stays the same if transparent pixels are not changed
+	number_t m[20];
+	if (!getMatrix(m))
+		return false;
+	uint8_t transparent[4] = { 0, 0, 0, 0 };
+	applyMatrix(transparent,1,m);
+	return (transparent[0] | transparent[1] | transparent[2] | transparent[3]) == 0;
+}
+
+void ColorMatrixFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
+{
+	number_t m[20];
+	assert_and_throw(getMatrix(m));
+	PixelOps::forEachRow(getSystemState(),height,width,[&](uint32_t first, uint32_t last)
+	{
+		applyMatrix(data+first*width*4,(last-first)*width,m);
+	});
+	copyToTarget(target,data,width,height,xpos,ypos);
 }
 
 ASFUNCTIONBODY_GETTER_SETTER(ColorMatrixFilter, matrix)
@@ -928,23 +909,15 @@ ASFUNCTIONBODY_ATOM(BlurFilter,_constructor)
 	BlurFilter *th = asAtomHandler::as<BlurFilter>(obj);
 	ARG_UNPACK_ATOM(th->blurX,4.0)(th->blurY,4.0)(th->quality,1);
 }
-void BlurFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool BlurFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
 {
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
-
-	uint32_t width = sourceRect.Xmax-sourceRect.Xmin;
-	uint32_t height = sourceRect.Ymax-sourceRect.Ymin;
-	uint8_t* data = target->getData();
-	for (uint32_t i = 0; i < height; i++)
-	{
-		memcpy(data+((ypos+i)*width+xpos)*4, tmpdata+i*width*4,width*4);
-	}
-	delete[] tmpdata;
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	return true;
+}
+void BlurFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
+{
+	applyBlur(getSystemState(),data,width,height,4,blurX,blurY,quality,scalex,scaley);
+	copyToTarget(target,data,width,height,xpos,ypos);
 }
 BitmapFilter* BlurFilter::cloneImpl() const
 {
@@ -1355,24 +1328,24 @@ ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(GradientBevelFilter,ratios)
 ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(GradientBevelFilter,strength)
 ASFUNCTIONBODY_GETTER_SETTER_NOT_IMPLEMENTED(GradientBevelFilter,type)
 
-void GradientBevelFilter::applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley)
+bool GradientBevelFilter::getChangedRegion(RECT& region, number_t scalex, number_t scaley)
+{
+	expandRegionByBlur(region,blurX,blurY,quality,scalex,scaley);
+	expandRegionByOffset(region,cos(angle+M_PI)*distance*scalex,sin(angle+M_PI)*distance*scaley);
+	expandRegionByOffset(region,cos(angle)*distance*scalex,sin(angle)*distance*scaley);
+	return true;
+}
+void GradientBevelFilter::applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley)
 {
 	if (type=="full")
 		LOG(LOG_NOT_IMPLEMENTED,"GradientBevelFilter type 'full'");
-	uint8_t* tmpdata = nullptr;
-	if (source)
-		tmpdata = source->getRectangleData(sourceRect);
-	else
-		tmpdata = target->getRectangleData(sourceRect);
-
 	number_t gradientalphas[256];
 	uint32_t gradientcolors[256];
 	fillGradientColors(gradientalphas,gradientcolors,this->ratios.getPtr(), this->alphas.getPtr(), this->colors.getPtr());
-	applyBlur(tmpdata,sourceRect.Xmax-sourceRect.Xmin,sourceRect.Ymax-sourceRect.Ymin,blurX,blurY,quality,scalex,scaley);
+	applyBlur(getSystemState(),data,width,height,1,blurX,blurY,quality,scalex,scaley);
 	// TODO I've not found any useful documentation how BevelFilter should be implemented, so we just apply two dropShadowFilters with different angles
-	applyGradientFilter(target, tmpdata, sourceRect, xpos+cos(angle+M_PI) * distance, ypos+sin(angle+M_PI) * distance, strength, gradientalphas, gradientcolors, type=="inner", knockout,scalex,scaley);
-	applyGradientFilter(target, tmpdata, sourceRect, xpos+cos(angle     ) * distance, ypos+sin(angle     ) * distance, strength, gradientalphas, gradientcolors, type=="inner", knockout,scalex,scaley);
-	delete[] tmpdata;
+	applyGradientFilter(getSystemState(),target,data,width,height,xpos+int32_t(cos(angle+M_PI) * distance * scalex),ypos+int32_t(sin(angle+M_PI) * distance * scaley),strength,gradientalphas,gradientcolors,type=="inner",knockout);
+	applyGradientFilter(getSystemState(),target,data,width,height,xpos+int32_t(cos(angle     ) * distance * scalex),ypos+int32_t(sin(angle     ) * distance * scaley),strength,gradientalphas,gradientcolors,type=="inner",knockout);
 }
 
 void GradientBevelFilter::prepareShutdown()
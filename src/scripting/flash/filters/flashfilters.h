@@ -28,19 +28,43 @@ namespace lightspark
 
 class BitmapFilter: public ASObject
 {
+friend class FilterChain;
 private:
 	virtual BitmapFilter* cloneImpl() const;
 protected:
-	static void applyBlur(uint8_t* data, uint32_t width, uint32_t height, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley);
-	static void applyDropShadowFilter(BitmapContainer* target, uint8_t* tmpdata, const RECT& sourceRect, int xpos, int ypos, number_t strength, number_t alpha, uint32_t color, bool inner, bool knockout, number_t scalex, number_t scaley);
+	// blurs width*height pixels of channels (1 or 4) bytes each, the last byte of a pixel is its alpha
+	static void applyBlur(SystemState* sys, uint8_t* data, uint32_t width, uint32_t height, uint32_t channels, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley);
+	// expands region by the number of pixels applyBlur may spread the pixels
+	static void expandRegionByBlur(RECT& region, number_t blurx, number_t blury, int quality, number_t scalex, number_t scaley);
+	static void expandRegionByOffset(RECT& region, int32_t dx, int32_t dy);
+	// copies the pixels of sourceRect, or only their alpha channel, to data. sourceRect has to be inside of source
+	static void getSourceData(BitmapContainer* source, const RECT& sourceRect, uint8_t* data, bool alphaOnly);
+	static void copyToTarget(BitmapContainer* target, const uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos);
+	// alphadata contains the blurred alpha channel of width*height pixels, xpos and ypos is the position of the shadow in pixels
+	static void applyDropShadowFilter(SystemState* sys, BitmapContainer* target, const uint8_t* alphadata, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t strength, number_t alpha, uint32_t color, bool inner, bool knockout);
 	static void fillGradientColors(number_t* gradientalphas, uint32_t* gradientcolors, Array* ratios, Array* alphas, Array* colors);
-	static void applyGradientFilter(BitmapContainer* target, uint8_t* tmpdata, const RECT& sourceRect, int xpos, int ypos, number_t strength, number_t* alphas, uint32_t* colors, bool inner, bool knockout, number_t scalex, number_t scaley);
+	static void applyGradientFilter(SystemState* sys, BitmapContainer* target, const uint8_t* alphadata, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t strength, number_t* alphas, uint32_t* colors, bool inner, bool knockout);
 public:
 	BitmapFilter(ASWorker* wrk,Class_base* c, CLASS_SUBTYPE st=SUBTYPE_BITMAPFILTER):ASObject(wrk,c,T_OBJECT,st){}
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(clone);
+	// the default implementation copies sourceRect and calls applyFilterData
 	virtual void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley);
 	virtual uint32_t getMaxFilterBorder() const { return 0; }
+	/*
+	 * Used by FilterChain to restrict the filter to the pixels it can change.
+	 * region contains all pixels of the bitmap that are not transparent, it is expanded by the
+	 * pixels the filter may make non-transparent. Returns false if the filter may change pixels
+	 * anywhere, it is applied to the whole bitmap by applyFilter then
+	 */
+	virtual bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) { return false; }
+	// filters that only read the alpha channel of the source get one byte per pixel in applyFilterData
+	virtual bool usesSourceAlphaOnly() const { return false; }
+	/*
+	 * applies the filter to data, a copy of width*height pixels of the source, and writes the result
+	 * to target at xpos,ypos (in pixels). data may be modified by the filter
+	 */
+	virtual void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley);
 };
 
 class GlowFilter: public BitmapFilter
@@ -60,7 +84,9 @@ public:
 	GlowFilter(ASWorker* wrk,Class_base* c,const GLOWFILTER& filter);
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(_constructor);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	bool usesSourceAlphaOnly() const override { return true; }
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 };
 
@@ -84,7 +110,9 @@ public:
 	DropShadowFilter(ASWorker* wrk,Class_base* c,const DROPSHADOWFILTER& filter);
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(_constructor);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	bool usesSourceAlphaOnly() const override { return true; }
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 };
 
@@ -108,7 +136,9 @@ public:
 	ASPROPERTY_GETTER_SETTER(int32_t,quality);
 	ASPROPERTY_GETTER_SETTER(tiny_string,type);
 	ASPROPERTY_GETTER_SETTER(bool,knockout);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	bool usesSourceAlphaOnly() const override { return true; }
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 	void prepareShutdown() override;
 };
@@ -134,7 +164,9 @@ public:
 	ASPROPERTY_GETTER_SETTER(uint32_t,shadowColor);
 	ASPROPERTY_GETTER_SETTER(number_t,strength);
 	ASPROPERTY_GETTER_SETTER(tiny_string,type);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	bool usesSourceAlphaOnly() const override { return true; }
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 };
 class ColorMatrixFilter: public BitmapFilter
@@ -147,7 +179,12 @@ public:
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(_constructor);
 	ASPROPERTY_GETTER_SETTER(_NR<Array>, matrix);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	// fills m with the 20 values of the matrix, returns false if the matrix is missing or too short
+	bool getMatrix(number_t* m);
+	// transforms count pixels of data in place
+	static void applyMatrix(uint8_t* data, uint32_t count, const number_t* m);
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	void prepareShutdown() override;
 };
 class BlurFilter: public BitmapFilter
@@ -162,7 +199,8 @@ public:
 	ASPROPERTY_GETTER_SETTER(number_t, blurX);
 	ASPROPERTY_GETTER_SETTER(number_t, blurY);
 	ASPROPERTY_GETTER_SETTER(int, quality);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 };
 class ConvolutionFilter: public BitmapFilter
@@ -226,7 +264,9 @@ public:
 	ASPROPERTY_GETTER_SETTER(_NR<Array>, ratios);
 	ASPROPERTY_GETTER_SETTER(number_t, strength);
 	ASPROPERTY_GETTER_SETTER(tiny_string, type);
-	void applyFilter(BitmapContainer* target, BitmapContainer* source, const RECT& sourceRect, int xpos, int ypos, number_t scalex, number_t scaley) override;
+	bool getChangedRegion(RECT& region, number_t scalex, number_t scaley) override;
+	bool usesSourceAlphaOnly() const override { return true; }
+	void applyFilterData(BitmapContainer* target, uint8_t* data, uint32_t width, uint32_t height, int32_t xpos, int32_t ypos, number_t scalex, number_t scaley) override;
 	uint32_t getMaxFilterBorder() const override { return ceil(max(blurX,blurY)); }
 	void prepareShutdown() override;
 };
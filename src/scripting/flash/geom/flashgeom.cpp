@@ -24,6 +24,9 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/toplevel/Vector.h"
 #include "scripting/flash/display/BitmapContainer.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace lightspark;
 using namespace std;
@@ -1864,130 +1867,78 @@ ASFUNCTIONBODY_ATOM(Vector3D,copyFrom)
 }
 
 
+void Matrix3D::multiply(number_t* out, const number_t* a, const number_t* b)
+{
+	// every row of the result is the sum of the rows of b weighted by the row of a
+#ifdef __SSE2__
+	__m128d res[8];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		__m128d f = _mm_set1_pd(a[4*i]);
+		__m128d lo = _mm_mul_pd(f,_mm_loadu_pd(b));
+		__m128d hi = _mm_mul_pd(f,_mm_loadu_pd(b+2));
+		for (uint32_t k = 1; k < 4; k++)
+		{
+			f = _mm_set1_pd(a[4*i+k]);
+			lo = _mm_add_pd(lo,_mm_mul_pd(f,_mm_loadu_pd(b+4*k)));
+			hi = _mm_add_pd(hi,_mm_mul_pd(f,_mm_loadu_pd(b+4*k+2)));
+		}
+		res[2*i] = lo;
+		res[2*i+1] = hi;
+	}
+	for (uint32_t i = 0; i < 8; i++)
+		_mm_storeu_pd(out+2*i,res[i]);
+#else
+	number_t res[16];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		for (uint32_t j = 0; j < 4; j++)
+			res[4*i+j] = a[4*i] * b[j] + a[4*i+1] * b[4+j] + a[4*i+2] * b[8+j] + a[4*i+3] * b[12+j];
+	}
+	memcpy(out,res,sizeof(res));
+#endif
+}
+
+void Matrix3D::transformPoints(const number_t* m, const number_t* in, number_t* out, uint32_t count)
+{
+#ifdef __SSE2__
+	const __m128d m0 = _mm_loadu_pd(m);
+	const __m128d m1 = _mm_loadu_pd(m+2);
+	const __m128d m4 = _mm_loadu_pd(m+4);
+	const __m128d m5 = _mm_loadu_pd(m+6);
+	const __m128d m8 = _mm_loadu_pd(m+8);
+	const __m128d m9 = _mm_loadu_pd(m+10);
+	const __m128d m12 = _mm_loadu_pd(m+12);
+	const __m128d m13 = _mm_loadu_pd(m+14);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		__m128d x = _mm_set1_pd(in[3*i]);
+		__m128d y = _mm_set1_pd(in[3*i+1]);
+		__m128d z = _mm_set1_pd(in[3*i+2]);
+		__m128d xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x,m0),_mm_mul_pd(y,m4)),_mm_mul_pd(z,m8)),m12);
+		__m128d zw = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x,m1),_mm_mul_pd(y,m5)),_mm_mul_pd(z,m9)),m13);
+		_mm_storeu_pd(out+4*i,xy);
+		_mm_storeu_pd(out+4*i+2,zw);
+	}
+#else
+	for (uint32_t i = 0; i < count; i++)
+	{
+		number_t x = in[3*i];
+		number_t y = in[3*i+1];
+		number_t z = in[3*i+2];
+		for (uint32_t j = 0; j < 4; j++)
+			out[4*i+j] = x * m[j] + y * m[4+j] + z * m[8+j] + m[12+j];
+	}
+#endif
+}
+
 void Matrix3D::append(number_t *otherdata)
 {
-	number_t m111 = data[0];
-	number_t m121 = data[4];
-	number_t m131 = data[8];
-	number_t m141 = data[12];
-
-	number_t m112 = data[1];
-	number_t m122 = data[5];
-	number_t m132 = data[9];
-	number_t m142 = data[13];
-
-	number_t m113 = data[2];
-	number_t m123 = data[6];
-	number_t m133 = data[10];
-	number_t m143 = data[14];
-
-	number_t m114 = data[3];
-	number_t m124 = data[7];
-	number_t m134 = data[11];
-	number_t m144 = data[15];
-
-	number_t m211 = otherdata[0];
-	number_t m221 = otherdata[4];
-	number_t m231 = otherdata[8];
-	number_t m241 = otherdata[12];
-
-	number_t m212 = otherdata[1];
-	number_t m222 = otherdata[5];
-	number_t m232 = otherdata[9];
-	number_t m242 = otherdata[13];
-
-	number_t m213 = otherdata[2];
-	number_t m223 = otherdata[6];
-	number_t m233 = otherdata[10];
-	number_t m243 = otherdata[14];
-
-	number_t m214 = otherdata[3];
-	number_t m224 = otherdata[7];
-	number_t m234 = otherdata[11];
-	number_t m244 = otherdata[15];
-
-	data[0] = m111 * m211 + m112 * m221 + m113 * m231 + m114 * m241;
-	data[1] = m111 * m212 + m112 * m222 + m113 * m232 + m114 * m242;
-	data[2] = m111 * m213 + m112 * m223 + m113 * m233 + m114 * m243;
-	data[3] = m111 * m214 + m112 * m224 + m113 * m234 + m114 * m244;
-
-	data[4] = m121 * m211 + m122 * m221 + m123 * m231 + m124 * m241;
-	data[5] = m121 * m212 + m122 * m222 + m123 * m232 + m124 * m242;
-	data[6] = m121 * m213 + m122 * m223 + m123 * m233 + m124 * m243;
-	data[7] = m121 * m214 + m122 * m224 + m123 * m234 + m124 * m244;
-
-	data[8] = m131 * m211 + m132 * m221 + m133 * m231 + m134 * m241;
-	data[9] = m131 * m212 + m132 * m222 + m133 * m232 + m134 * m242;
-	data[10] = m131 * m213 + m132 * m223 + m133 * m233 + m134 * m243;
-	data[11] = m131 * m214 + m132 * m224 + m133 * m234 + m134 * m244;
-
-	data[12] = m141 * m211 + m142 * m221 + m143 * m231 + m144 * m241;
-	data[13] = m141 * m212 + m142 * m222 + m143 * m232 + m144 * m242;
-	data[14] = m141 * m213 + m142 * m223 + m143 * m233 + m144 * m243;
-	data[15] = m141 * m214 + m142 * m224 + m143 * m234 + m144 * m244;
+	multiply(data,data,otherdata);
 }
 void Matrix3D::prepend(number_t *otherdata)
 {
-	number_t m111 = otherdata[0];
-	number_t m121 = otherdata[4];
-	number_t m131 = otherdata[8];
-	number_t m141 = otherdata[12];
-
-	number_t m112 = otherdata[1];
-	number_t m122 = otherdata[5];
-	number_t m132 = otherdata[9];
-	number_t m142 = otherdata[13];
-
-	number_t m113 = otherdata[2];
-	number_t m123 = otherdata[6];
-	number_t m133 = otherdata[10];
-	number_t m143 = otherdata[14];
-
-	number_t m114 = otherdata[3];
-	number_t m124 = otherdata[7];
-	number_t m134 = otherdata[11];
-	number_t m144 = otherdata[15];
-
-
-	number_t m211 = data[0];
-	number_t m221 = data[4];
-	number_t m231 = data[8];
-	number_t m241 = data[12];
-
-	number_t m212 = data[1];
-	number_t m222 = data[5];
-	number_t m232 = data[9];
-	number_t m242 = data[13];
-
-	number_t m213 = data[2];
-	number_t m223 = data[6];
-	number_t m233 = data[10];
-	number_t m243 = data[14];
-
-	number_t m214 = data[3];
-	number_t m224 = data[7];
-	number_t m234 = data[11];
-	number_t m244 = data[15];
-
-	data[0] = m111 * m211 + m112 * m221 + m113 * m231 + m114 * m241;
-	data[1] = m111 * m212 + m112 * m222 + m113 * m232 + m114 * m242;
-	data[2] = m111 * m213 + m112 * m223 + m113 * m233 + m114 * m243;
-	data[3] = m111 * m214 + m112 * m224 + m113 * m234 + m114 * m244;
-	
-	data[4] = m121 * m211 + m122 * m221 + m123 * m231 + m124 * m241;
-	data[5] = m121 * m212 + m122 * m222 + m123 * m232 + m124 * m242;
-	data[6] = m121 * m213 + m122 * m223 + m123 * m233 + m124 * m243;
-	data[7] = m121 * m214 + m122 * m224 + m123 * m234 + m124 * m244;
-	
-	data[8] = m131 * m211 + m132 * m221 + m133 * m231 + m134 * m241;
-	data[9] = m131 * m212 + m132 * m222 + m133 * m232 + m134 * m242;
-	data[10] = m131 * m213 + m132 * m223 + m133 * m233 + m134 * m243;
-	data[11] = m131 * m214 + m132 * m224 + m133 * m234 + m134 * m244;
-	
-	data[12] = m141 * m211 + m142 * m221 + m143 * m231 + m144 * m241;
-	data[13] = m141 * m212 + m142 * m222 + m143 * m232 + m144 * m242;
-	data[14] = m141 * m213 + m142 * m223 + m143 * m233 + m144 * m243;
-	data[15] = m141 * m214 + m142 * m224 + m143 * m234 + m144 * m244;
+	multiply(data,otherdata,data);
 }
 number_t Matrix3D::getDeterminant()
 {
@@ -2052,6 +2003,7 @@ void Matrix3D::sinit(Class_base* c)
 	c->setDeclaredMethodByQName("position","",Class<IFunction>::getFunction(c->getSystemState(),_set_position),SETTER_METHOD,true);
 	c->setDeclaredMethodByQName("position","",Class<IFunction>::getFunction(c->getSystemState(),_get_position,0,Class<Vector3D>::getRef(c->getSystemState()).getPtr()),GETTER_METHOD,true);
 	c->setDeclaredMethodByQName("transformVector","",Class<IFunction>::getFunction(c->getSystemState(),transformVector,2,Class<Vector3D>::getRef(c->getSystemState()).getPtr()),NORMAL_METHOD,true);
+	c->setDeclaredMethodByQName("transformVectors","",Class<IFunction>::getFunction(c->getSystemState(),transformVectors),NORMAL_METHOD,true);
 }
 
 bool Matrix3D::destruct()
@@ -2618,16 +2570,42 @@ ASFUNCTIONBODY_ATOM(Matrix3D,transformVector)
 	ARG_UNPACK_ATOM(v);
 	if (v.isNull())
 		throwError<ArgumentError>(kInvalidArgumentError,"v");
-	number_t x = v->x;
-	number_t y = v->y;
-	number_t z = v->z;
+	number_t in[3] = { v->x, v->y, v->z };
+	number_t out[4];
+	transformPoints(th->data,in,out,1);
 	Vector3D* res = Class<Vector3D>::getInstanceS(wrk);
-	res->x = (x * th->data[0] + y * th->data[4] + z * th->data[8] + th->data[12]);
-	res->y = (x * th->data[1] + y * th->data[5] + z * th->data[9] + th->data[13]);
-	res->z = (x * th->data[2] + y * th->data[6] + z * th->data[10] + th->data[14]);
-	res->w = (x * th->data[3] + y * th->data[7] + z * th->data[11] + th->data[15]);
+	res->x = out[0];
+	res->y = out[1];
+	res->z = out[2];
+	res->w = out[3];
 	ret = asAtomHandler::fromObject(res);
 }
+ASFUNCTIONBODY_ATOM(Matrix3D,transformVectors)
+{
+	Matrix3D * th=asAtomHandler::as<Matrix3D>(obj);
+	_NR<Vector> vin;
+	_NR<Vector> vout;
+	ARG_UNPACK_ATOM(vin)(vout);
+	if (vin.isNull())
+		throwError<TypeError>(kNullPointerError,"vin");
+	if (vout.isNull())
+		throwError<TypeError>(kNullPointerError,"vout");
+	uint32_t count = vin->size()/3;
+	if (count == 0)
+		return;
+	// the coordinates are converted once, so the whole array is transformed in one pass
+	vector<number_t> in(count*3);
+	vector<number_t> out(count*4);
+	vin->getNumbers(&in[0],0,count*3);
+	transformPoints(th->data,&in[0],&out[0],count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		in[3*i] = out[4*i];
+		in[3*i+1] = out[4*i+1];
+		in[3*i+2] = out[4*i+2];
+	}
+	vout->setNumbers(&in[0],0,count*3);
+}
 
 void PerspectiveProjection::sinit(Class_base* c)
 {
@@ -2656,3 +2634,70 @@ ASFUNCTIONBODY_ATOM(PerspectiveProjection,_constructor)
 	th->projectionCenter = _MR(Class<Point>::getInstanceSNoArgs(wrk));
 	LOG(LOG_NOT_IMPLEMENTED,"PerspectiveProjection is not implemented");
 }
+
+void Utils3D::sinit(Class_base* c)
+{
+	CLASS_SETUP(c, ASObject, _constructorNotInstantiatable, CLASS_FINAL | CLASS_SEALED);
+	c->setDeclaredMethodByQName("projectVector","",Class<IFunction>::getFunction(c->getSystemState(),projectVector,2,Class<Vector3D>::getRef(c->getSystemState()).getPtr()),NORMAL_METHOD,false);
+	c->setDeclaredMethodByQName("projectVectors","",Class<IFunction>::getFunction(c->getSystemState(),projectVectors),NORMAL_METHOD,false);
+}
+
+ASFUNCTIONBODY_ATOM(Utils3D,projectVector)
+{
+	_NR<Matrix3D> m;
+	_NR<Vector3D> v;
+	ARG_UNPACK_ATOM(m)(v);
+	if (m.isNull())
+		throwError<TypeError>(kNullPointerError,"m");
+	if (v.isNull())
+		throwError<TypeError>(kNullPointerError,"v");
+	number_t in[3] = { v->x, v->y, v->z };
+	number_t out[4];
+	Matrix3D::transformPoints(m->data,in,out,1);
+	Vector3D* res = Class<Vector3D>::getInstanceS(wrk);
+	res->x = out[0]/out[3];
+	res->y = out[1]/out[3];
+	res->z = out[2]/out[3];
+	res->w = out[3];
+	ret = asAtomHandler::fromObject(res);
+}
+
+ASFUNCTIONBODY_ATOM(Utils3D,projectVectors)
+{
+	_NR<Matrix3D> m;
+	_NR<Vector> verts;
+	_NR<Vector> projectedVerts;
+	_NR<Vector> uvts;
+	ARG_UNPACK_ATOM(m)(verts)(projectedVerts)(uvts);
+	if (m.isNull())
+		throwError<TypeError>(kNullPointerError,"m");
+	if (verts.isNull())
+		throwError<TypeError>(kNullPointerError,"verts");
+	if (projectedVerts.isNull())
+		throwError<TypeError>(kNullPointerError,"projectedVerts");
+	if (uvts.isNull())
+		throwError<TypeError>(kNullPointerError,"uvts");
+	uint32_t count = verts->size()/3;
+	if (count == 0)
+		return;
+	vector<number_t> in(count*3);
+	vector<number_t> out(count*4);
+	verts->getNumbers(&in[0],0,count*3);
+	Matrix3D::transformPoints(m->data,in.data(),out.data(),count);
+	// projectedVerts gets x/w and y/w of every vertex, the t value in uvts is set to 1/w
+	vector<number_t> projected(count*2);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		projected[2*i] = out[4*i]/out[4*i+3];
+		projected[2*i+1] = out[4*i+1]/out[4*i+3];
+	}
+	projectedVerts->setNumbers(&projected[0],0,count*2);
+	uint32_t uvtCount = min(count,uvts->size()/3);
+	if (uvtCount)
+	{
+		uvts->getNumbers(&in[0],0,uvtCount*3);
+		for (uint32_t i = 0; i < uvtCount; i++)
+			in[3*i+2] = 1/out[4*i+3];
+		uvts->setNumbers(&in[0],0,uvtCount*3);
+	}
+}
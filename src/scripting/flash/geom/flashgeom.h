@@ -279,6 +279,7 @@ public:
 
 class Matrix3D: public ASObject
 {
+friend class Utils3D;
 private:
 	number_t data[4*4];
 	void append(number_t* otherdata);
@@ -314,6 +315,11 @@ public:
 	ASFUNCTION_ATOM(_get_position);
 	ASFUNCTION_ATOM(_set_position);
 	ASFUNCTION_ATOM(transformVector);
+	ASFUNCTION_ATOM(transformVectors);
+	// out = a*b, with the matrices in the layout of data. out may be the same as a or b
+	static void multiply(number_t* out, const number_t* a, const number_t* b);
+	// transforms count points of 3 coordinates from in to points of 4 coordinates (x,y,z,w) in out
+	static void transformPoints(const number_t* m, const number_t* in, number_t* out, uint32_t count);
 	void getRowAsFloat(uint32_t rownum,float* rowdata);
 	void getColumnAsFloat(uint32_t rownum,float* rowdata);
 	void getRawDataAsFloat(float* rowdata);
@@ -330,5 +336,14 @@ public:
 	ASPROPERTY_GETTER_SETTER(_NR<Point>, projectionCenter);
 };
 
+class Utils3D: public ASObject
+{
+public:
+	Utils3D(ASWorker* wrk,Class_base* c):ASObject(wrk,c){}
+	static void sinit(Class_base* c);
+	ASFUNCTION_ATOM(projectVector);
+	ASFUNCTION_ATOM(projectVectors);
+};
+
 }
 #endif /* SCRIPTING_FLASH_FLASHGEOM_H */
@@ -34,6 +34,7 @@
 #include "platforms/engineutils.h"
 
 #include <istream>
+#include <zlib.h>
 
 using namespace lightspark;
 
@@ -883,7 +884,7 @@ extern uint32_t asClassCount;
 
 ASWorker::ASWorker(SystemState* s):
 	EventDispatcher(this,nullptr),parser(nullptr),
-	giveAppPrivileges(false),started(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(true),state("running")
+	giveAppPrivileges(false),started(false),inflatestream(nullptr),fromPrimordial(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(true),state("running"),profilerStack(nullptr)
 {
 	subtype = SUBTYPE_WORKER;
 	setSystemState(s);
@@ -897,7 +898,7 @@ ASWorker::ASWorker(SystemState* s):
 
 ASWorker::ASWorker(Class_base* c):
 	EventDispatcher(c->getSystemState()->worker,c),parser(nullptr),
-	giveAppPrivileges(false),started(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
+	giveAppPrivileges(false),started(false),inflatestream(nullptr),fromPrimordial(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new"),profilerStack(nullptr)
 {
 	subtype = SUBTYPE_WORKER;
 	// TODO: it seems that AIR applications have a higher default value for max_recursion
@@ -909,7 +910,7 @@ ASWorker::ASWorker(Class_base* c):
 }
 ASWorker::ASWorker(ASWorker* wrk, Class_base* c):
 	EventDispatcher(wrk,c),parser(nullptr),
-	giveAppPrivileges(false),started(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new")
+	giveAppPrivileges(false),started(false),inflatestream(nullptr),fromPrimordial(false),freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new"),profilerStack(nullptr)
 {
 	subtype = SUBTYPE_WORKER;
 	// TODO: it seems that AIR applications have a higher default value for max_recursion
@@ -949,6 +950,13 @@ void ASWorker::finalize()
 	delete[] stacktrace;
 	loader.reset();
 	swf.reset();
+	workerSWF.reset();
+	if (inflatestream)
+	{
+		inflateEnd(inflatestream);
+		delete inflatestream;
+		inflatestream=nullptr;
+	}
 	delete[] freelist;
 	EventDispatcher::finalize();
 }
@@ -974,6 +982,24 @@ void ASWorker::prepareShutdown()
 	parsemutex.unlock();
 }
 
+z_stream_s* ASWorker::getInflateStream(bool raw)
+{
+	int windowbits = raw ? -15 : 15;
+	if (!inflatestream)
+	{
+		inflatestream = new z_stream;
+		memset(inflatestream,0,sizeof(z_stream));
+		if (inflateInit2(inflatestream,windowbits)!=Z_OK)
+		{
+			delete inflatestream;
+			inflatestream=nullptr;
+		}
+	}
+	else if (inflateReset2(inflatestream,windowbits)!=Z_OK)
+		return nullptr;
+	return inflatestream;
+}
+
 Prototype* ASWorker::getClassPrototype(const Class_base* cls)
 {
 	auto it = protoypeMap.find(cls);
@@ -1010,7 +1036,10 @@ void ASWorker::execute()
 {
 	setTLSWorker(this);
 
-	streambuf *sbuf = new bytes_buf(swf->bytes,swf->getLength());
+	// workers created from the same file share the uncompressed file
+	if (workerSWF.isNull())
+		workerSWF = getSystemState()->workerDomain->getWorkerSWF(swf->bytes,swf->getLength(),fromPrimordial);
+	streambuf *sbuf = new bytes_buf(workerSWF->data.data(),workerSWF->data.size());
 	istream s(sbuf);
 	parsemutex.lock();
 	parser = new ParseThread(s,_MR(Class<ApplicationDomain>::getInstanceS(this,_MR(getSystemState()->systemDomain))),getSystemState()->mainClip->securityDomain,loader.getPtr(),"");
@@ -1116,6 +1145,18 @@ uint32_t ASWorker::getDefaultXMLNamespaceID() const
 	return currentCallContext ? currentCallContext->defaultNamespaceUri : (uint32_t)BUILTIN_STRINGS::EMPTY;
 }
 
+void ASWorker::profilerEnterMethod(method_info* mi, asAtom o, uint32_t f)
+{
+	if (getSystemState()->samplingProfiler)
+		getSystemState()->samplingProfiler->enterMethod(this,mi,o,f);
+}
+
+void ASWorker::profilerLeaveMethod()
+{
+	if (getSystemState()->samplingProfiler)
+		getSystemState()->samplingProfiler->leaveMethod(this);
+}
+
 void ASWorker::dumpStacktrace()
 {
 	tiny_string strace;
@@ -1199,7 +1240,7 @@ ASFUNCTIONBODY_ATOM(ASWorker,start)
 	ASWorker* th = asAtomHandler::as<ASWorker>(obj);
 	if (th->started)
 		throwError<ASError>(kWorkerAlreadyStarted);
-	if (!th->swf.isNull())
+	if (!th->swf.isNull() || !th->workerSWF.isNull())
 	{
 		th->started = true;
 		wrk->getSystemState()->addJob(th);
@@ -1240,6 +1281,101 @@ void WorkerDomain::finalize()
 {
 	workerlist.reset();
 	workerSharedObject.reset();
+	Locker l(swfcachemutex);
+	swfcache.clear();
+}
+
+bool WorkerDomain::uncompressSWF(const uint8_t* bytes, uint32_t len, std::vector<uint8_t>& data)
+{
+	if (len < 8 || (bytes[0] != 'C' && bytes[0] != 'Z') || bytes[1] != 'W' || bytes[2] != 'S')
+		return false;
+	// the length in the header includes the 8 uncompressed bytes of the header
+	uint32_t filelength = bytes[4] | (bytes[5]<<8) | (bytes[6]<<16) | (uint32_t(bytes[7])<<24);
+	if (filelength < 8)
+		return false;
+	bytes_buf buf(bytes,len);
+	istream in(&buf);
+	char header[8];
+	in.read(header,8);
+	uncompressing_filter* filter = nullptr;
+	try
+	{
+		if (bytes[0] == 'C')
+			filter = new zlib_filter(&buf);
+		else
+			filter = new liblzma_filter(&buf);
+		istream uncompressed(filter);
+		uncompressed.exceptions(istream::badbit);
+		// the length in the header can't be trusted, so the buffer is only grown while data is uncompressed
+		data.assign(bytes,bytes+8);
+		data[0] = 'F';
+		data.reserve(min(uint64_t(filelength),uint64_t(len)*4));
+		while (data.size() < filelength)
+		{
+			size_t oldsize = data.size();
+			size_t step = min(size_t(filelength)-oldsize,max(oldsize,size_t(64*1024)));
+			data.resize(oldsize+step);
+			uncompressed.read((char*)data.data()+oldsize,step);
+			data.resize(oldsize+uncompressed.gcount());
+			if (size_t(uncompressed.gcount()) < step)
+				break;
+		}
+	}
+	catch(LightsparkException& e)
+	{
+		LOG(LOG_ERROR,"uncompressing worker swf failed:"<<e.cause);
+		delete filter;
+		return false;
+	}
+	catch(std::exception& e)
+	{
+		LOG(LOG_ERROR,"uncompressing worker swf failed:"<<e.what());
+		delete filter;
+		return false;
+	}
+	delete filter;
+	return true;
+}
+
+_R<WorkerSWF> WorkerDomain::getWorkerSWF(const uint8_t* bytes, uint32_t len, bool primordial)
+{
+	// a cryptographic digest is used, so a file can't be crafted to match another cached file
+	gchar* d = g_compute_checksum_for_data(G_CHECKSUM_SHA256,bytes,len);
+	std::string digest(d);
+	g_free(d);
+	// the lock is kept while uncompressing, so workers started at the same time wait for the first one
+	Locker l(swfcachemutex);
+	for (auto it = swfcache.begin(); it != swfcache.end(); ++it)
+	{
+		if ((*it)->digest == digest)
+		{
+			_R<WorkerSWF> res = *it;
+			swfcache.erase(it);
+			swfcache.push_back(res);
+			if (primordial)
+				res->primordial = true;
+			return res;
+		}
+	}
+	_R<WorkerSWF> res = _MR(new WorkerSWF(digest));
+	if (!uncompressSWF(bytes,len,res->data))
+		res->data.assign(bytes,bytes+len);
+	res->primordial = primordial;
+	swfcache.push_back(res);
+	if (swfcache.size() > WORKER_SWF_CACHE_SIZE)
+		swfcache.pop_front();
+	return res;
+}
+
+_NR<WorkerSWF> WorkerDomain::getPrimordialSWF()
+{
+	Locker l(swfcachemutex);
+	for (auto it = swfcache.begin(); it != swfcache.end(); ++it)
+	{
+		if ((*it)->primordial)
+			return *it;
+	}
+	return NullRef;
 }
 
 void WorkerDomain::sinit(Class_base* c)
@@ -1280,7 +1416,14 @@ ASFUNCTIONBODY_ATOM(WorkerDomain,createWorker)
 ASFUNCTIONBODY_ATOM(WorkerDomain,createWorkerFromPrimordial)
 {
 	ASWorker* wk = Class<ASWorker>::getInstanceS(wrk->getSystemState()->worker);
-	
+	wk->fromPrimordial = true;
+	// the file doesn't have to be read again if a worker was already started from it
+	wk->workerSWF = wrk->getSystemState()->workerDomain->getPrimordialSWF();
+	if (!wk->workerSWF.isNull())
+	{
+		ret = asAtomHandler::fromObject(wk);
+		return;
+	}
 	
 	ByteArray* ba = Class<ByteArray>::getInstanceS(wk);
 	FileStreamCache* sc = (FileStreamCache*)wrk->getSystemState()->getEngineData()->createFileStreamCache(wrk->getSystemState());
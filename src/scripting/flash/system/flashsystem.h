@@ -26,8 +26,11 @@
 #include "scripting/flash/utils/ByteArray.h"
 #include "scripting/toplevel/Error.h"
 #include "scripting/flash/events/flashevents.h"
+#include "backends/profiler.h"
 
 #define MIN_DOMAIN_MEMORY_LIMIT 1024
+struct z_stream_s;
+
 namespace lightspark
 {
 
@@ -300,6 +303,28 @@ public:
 class WorkerDomain;
 class ParseThread;
 class Prototype;
+
+// number of uncompressed SWF files kept for starting more workers
+#define WORKER_SWF_CACHE_SIZE 4
+
+/*
+ * The uncompressed SWF file a worker is started from.
+ * It is shared by all workers created from the same file, so the file is only uncompressed once
+ * and only one copy of it is kept, no matter how many workers are parsing it.
+ * Only the file is shared: the ABC contexts, method bodies and dictionary tags parsed from it
+ * reference objects of the worker parsing them, so every worker still builds its own.
+ */
+class WorkerSWF: public RefCountable
+{
+public:
+	// SHA-256 of the file the workers were created from
+	std::string digest;
+	std::vector<uint8_t> data;
+	// true if this is the file of the primordial worker
+	bool primordial;
+	WorkerSWF(const std::string& d):digest(d),primordial(false){}
+};
+
 class ASWorker: public EventDispatcher, public IThreadJob
 {
 friend class WorkerDomain;
@@ -316,6 +341,10 @@ private:
 	typedef std::pair<_NR<EventDispatcher>,_R<Event>> eventType;
 	std::deque<eventType> events_queue;
 	map<const Class_base*,_R<Prototype>> protoypeMap;
+	z_stream_s* inflatestream;
+	_NR<WorkerSWF> workerSWF;
+	// true if the worker was created by createWorkerFromPrimordial
+	bool fromPrimordial;
 public:
 	asfreelist* freelist;
 	asfreelist freelist_syntheticfunction;
@@ -325,6 +354,8 @@ public:
 	void finalize() override;
 	void prepareShutdown() override;
 	Prototype* getClassPrototype(const Class_base* cls);
+	// returns the inflate stream of this worker, reset for raw or zlib data, or nullptr if zlib initialization failed
+	z_stream_s* getInflateStream(bool raw);
 	static void sinit(Class_base*);
 
 	//  TODO merge stacktrace handling with ABCVm
@@ -346,10 +377,14 @@ public:
 	}
 	FORCE_INLINE void decStack(call_context* saved_cc)
 	{
+		if(USUALLY_FALSE(SamplingProfiler::active.load(std::memory_order_relaxed)))
+			profilerLeaveMethod();
 		currentCallContext = saved_cc;
 		--cur_recursion; //decrement current recursion depth
 	}
 	void throwStackOverflow();
+	void profilerEnterMethod(method_info* mi, asAtom o, uint32_t f);
+	void profilerLeaveMethod();
 	ASFUNCTION_ATOM(_getCurrent);
 	ASFUNCTION_ATOM(getSharedProperty);
 	ASFUNCTION_ATOM(isSupported);
@@ -369,6 +404,8 @@ public:
 	tiny_string getDefaultXMLNamespace() const;
 	uint32_t getDefaultXMLNamespaceID() const;
 	void dumpStacktrace();
+	// the call stack recorded by the SamplingProfiler, created on first use
+	ProfilerStack* profilerStack;
 };
 class WorkerDomain: public ASObject
 {
@@ -378,8 +415,17 @@ private:
 	Mutex workersharedobjectmutex;
 	_NR<Vector> workerlist;
 	_NR<ASObject> workerSharedObject;
+	Mutex swfcachemutex;
+	// least recently used first
+	std::list<_R<WorkerSWF>> swfcache;
+	static bool uncompressSWF(const uint8_t* bytes, uint32_t len, std::vector<uint8_t>& data);
 public:
 	WorkerDomain(ASWorker* wrk, Class_base* c);
+	/* returns the uncompressed SWF file in bytes, it is only uncompressed if no other worker was
+	 * started from the same file yet. If primordial is true the file is also used by the next
+	 * workers created from the primordial worker, as long as it is still cached */
+	_R<WorkerSWF> getWorkerSWF(const uint8_t* bytes, uint32_t len, bool primordial);
+	_NR<WorkerSWF> getPrimordialSWF();
 	void finalize() override;
 	static void sinit(Class_base*);
 	ASFUNCTION_ATOM(_constructor);
@@ -42,11 +42,63 @@ void MessageChannel::sinit(Class_base* c)
 
 void MessageChannel::finalize()
 {
+	Locker l(messagequeuemutex);
 	while (!messagequeue.empty())
+	{
+		delete[] messagequeue.front().bytes;
 		messagequeue.pop();
+	}
+	messagequeuecond.broadcast();
 }
 ASFUNCTIONBODY_GETTER(MessageChannel, state)
 
+bool MessageChannel::isShareable(ASObject* o)
+{
+	return o->is<ASWorker>()
+			|| o->is<MessageChannel>()
+			|| (o->is<ByteArray>() && o->as<ByteArray>()->shareable)
+			|| o->is<ASMutex>()
+			|| o->is<ASCondition>();
+}
+
+void MessageChannel::unpackMessage(asAtom& ret, ASWorker* wrk, ChannelMessage& msg)
+{
+	switch (msg.kind)
+	{
+		case ChannelMessage::SHARED:
+			msg.obj->incRef();
+			ret = asAtomHandler::fromObjectNoPrimitive(msg.obj.getPtr());
+			break;
+		case ChannelMessage::AMF:
+			ret = msg.obj->as<ByteArray>()->readObject();
+			break;
+		case ChannelMessage::BYTES:
+		{
+			ByteArray* b = Class<ByteArray>::getInstanceSNoArgs(wrk);
+			if (msg.bytes)
+				b->acquireBuffer(msg.bytes,msg.length);
+			msg.bytes=nullptr;
+			ret = asAtomHandler::fromObjectNoPrimitive(b);
+			break;
+		}
+		case ChannelMessage::BOOLEAN:
+			ret = asAtomHandler::fromBool(msg.number != 0);
+			break;
+		case ChannelMessage::INTEGER:
+			ret = asAtomHandler::fromInt(int32_t(msg.number));
+			break;
+		case ChannelMessage::UINTEGER:
+			ret = asAtomHandler::fromUInt(uint32_t(msg.number));
+			break;
+		case ChannelMessage::NUMBER:
+			ret = asAtomHandler::fromNumber(wrk,msg.number,false);
+			break;
+		case ChannelMessage::STRING:
+			ret = asAtomHandler::fromObject(abstract_s(wrk,tiny_string(msg.str)));
+			break;
+	}
+}
+
 ASFUNCTIONBODY_ATOM(MessageChannel,messageAvailable)
 {
 	MessageChannel* th=asAtomHandler::as<MessageChannel>(obj);
@@ -77,76 +129,131 @@ ASFUNCTIONBODY_ATOM(MessageChannel,_toString)
 ASFUNCTIONBODY_ATOM(MessageChannel,close)
 {
 	MessageChannel* th=asAtomHandler::as<MessageChannel>(obj);
+	Locker l(th->messagequeuemutex);
 	if (th->state == "open")
 		th->state="closing";
+	// wake up blocked senders and receivers
+	th->messagequeuecond.broadcast();
 }
 ASFUNCTIONBODY_ATOM(MessageChannel,receive)
 {
 	MessageChannel* th=asAtomHandler::as<MessageChannel>(obj);
 	bool blockUntilReceived;
 	ARG_UNPACK_ATOM(blockUntilReceived,false);
-	Locker l(th->messagequeuemutex);
-	if (th->messagequeue.empty())
+	ChannelMessage msg(ChannelMessage::SHARED);
 	{
+		Locker l(th->messagequeuemutex);
 		if (blockUntilReceived)
 		{
-			while (th->messagequeue.empty() && th->state=="open")
-			{
-				l.release();
-				compat_msleep(100);
-				l.acquire();
-			}
+			// the timeout makes sure termination of the worker is noticed
+			while (th->messagequeue.empty() && th->state=="open" && !wrk->threadAborting)
+				th->messagequeuecond.wait_until(th->messagequeuemutex,100);
 		}
 		if (th->messagequeue.empty())
 		{
 			ret = asAtomHandler::nullAtom;
 			return;
 		}
+		msg = th->messagequeue.front();
+		th->messagequeue.pop();
+		// a sender may be waiting for room in the queue
+		th->messagequeuecond.broadcast();
 	}
-	
-	_NR<ASObject> msg = th->messagequeue.front();
-	th->messagequeue.pop();
-	if (msg->is<ASWorker>()
-			|| msg->is<MessageChannel>()
-			|| (msg->is<ByteArray>() && msg->as<ByteArray>()->shareable)
-			|| msg->is<ASMutex>()
-			|| msg->is<ASCondition>()
-			)
-		ret = asAtomHandler::fromObjectNoPrimitive(msg.getPtr());
-	else
-	{
-		ret = msg->as<ByteArray>()->readObject();
-	}
+	unpackMessage(ret,wrk,msg);
 }
 ASFUNCTIONBODY_ATOM(MessageChannel,send)
 {
 	MessageChannel* th=asAtomHandler::as<MessageChannel>(obj);
 	if (th->state!= "open")
 		throw Class<IOError>::getInstanceS(wrk,"MessageChannel closed");
-	_NR<ASObject> msg;
+	asAtom msg=asAtomHandler::invalidAtom;
 	int queueLimit;
 	ARG_UNPACK_ATOM(msg)(queueLimit,-1);
-	if (msg.isNull())
+	if (asAtomHandler::isNull(msg) || asAtomHandler::isUndefined(msg))
 		return;
-	if (queueLimit != -1)
-		LOG(LOG_NOT_IMPLEMENTED,"MessageChannel.send ignores parameter queueLimit");
-	Locker l(th->messagequeuemutex);
-	if (msg->is<ASWorker>()
-			|| msg->is<MessageChannel>()
-			|| (msg->is<ByteArray>() && msg->as<ByteArray>()->shareable)
-			|| msg->is<ASMutex>()
-			|| msg->is<ASCondition>()
-			)
+
+	ChannelMessage m(ChannelMessage::AMF);
+	if (asAtomHandler::isInteger(msg))
+	{
+		m.kind = ChannelMessage::INTEGER;
+		m.number = asAtomHandler::toInt(msg);
+	}
+	else if (asAtomHandler::isUInteger(msg))
 	{
-		msg->objfreelist=nullptr; // message will be used in another thread, make it not reusable
-		th->messagequeue.push(msg);
+		m.kind = ChannelMessage::UINTEGER;
+		m.number = asAtomHandler::toUInt(msg);
+	}
+	else if (asAtomHandler::isNumber(msg))
+	{
+		m.kind = ChannelMessage::NUMBER;
+		m.number = asAtomHandler::toNumber(msg);
+	}
+	else if (asAtomHandler::isBool(msg))
+	{
+		m.kind = ChannelMessage::BOOLEAN;
+		m.number = asAtomHandler::Boolean_concrete(msg) ? 1 : 0;
+	}
+	else if (asAtomHandler::isString(msg))
+	{
+		// copied, the string may be owned by the sender
+		tiny_string s = asAtomHandler::toString(msg,wrk);
+		m.kind = ChannelMessage::STRING;
+		m.str = std::string(s.raw_buf(),s.numBytes());
 	}
 	else
 	{
-		ByteArray* b = Class<ByteArray>::getInstanceSNoArgs(th->receiver.getPtr());
-		b->writeObject(msg.getPtr(),th->receiver.getPtr());
-		b->setPosition(0);
-		th->messagequeue.push(_MR(b));
+		ASObject* o = asAtomHandler::toObject(msg,wrk);
+		if (isShareable(o))
+		{
+			o->incRef();
+			o->objfreelist=nullptr; // message will be used in another thread, make it not reusable
+			m.kind = ChannelMessage::SHARED;
+			m.obj = _MR(o);
+		}
+		else if (o->is<ByteArray>())
+		{
+			ByteArray* b = o->as<ByteArray>();
+			m.kind = ChannelMessage::BYTES;
+			// the sender keeps its ByteArray, the copy is taken over by the ByteArray of the receiver
+			if (b->getLength())
+			{
+				m.length = b->getLength();
+				m.bytes = new uint8_t[m.length];
+				memcpy(m.bytes,b->getBufferNoCheck(),m.length);
+			}
+		}
+		else
+		{
+			ByteArray* b = Class<ByteArray>::getInstanceSNoArgs(th->receiver.getPtr());
+			b->writeObject(o,th->receiver.getPtr());
+			b->setPosition(0);
+			m.obj = _MR(b);
+		}
+	}
+
+	{
+		Locker l(th->messagequeuemutex);
+		if (queueLimit > 0 && th->messagequeue.size() >= uint32_t(queueLimit))
+		{
+			if (wrk == th->receiver.getPtr())
+			{
+				// waiting for ourselves to receive would never end
+				LOG(LOG_ERROR,"MessageChannel.send: queue limit reached, message dropped");
+				delete[] m.bytes;
+				return;
+			}
+			// block until the receiver has made room for the message
+			while (th->messagequeue.size() >= uint32_t(queueLimit) && th->state=="open"
+				   && !wrk->threadAborting && (th->receiver.isNull() || !th->receiver->threadAborting))
+				th->messagequeuecond.wait_until(th->messagequeuemutex,100);
+			if (th->messagequeue.size() >= uint32_t(queueLimit))
+			{
+				delete[] m.bytes;
+				return;
+			}
+		}
+		th->messagequeue.push(m);
+		th->messagequeuecond.broadcast();
 	}
 	th->incRef();
 	getVm(wrk->getSystemState())->addEvent(_MR(th),_MR(Class<Event>::getInstanceS(th->receiver.getPtr(),"channelMessage")));
@@ -26,11 +26,35 @@
 namespace lightspark
 {
 
+/*
+ * A message as it is stored in the queue of a MessageChannel. Objects that can be shared between
+ * workers are queued as they are, primitive values and the contents of ByteArrays are copied
+ * without AMF serialization, everything else is serialized into a ByteArray of the receiver
+ */
+struct ChannelMessage
+{
+	enum KIND { SHARED, AMF, BYTES, BOOLEAN, INTEGER, UINTEGER, NUMBER, STRING };
+	KIND kind;
+	// the shared object or the ByteArray containing the serialized message
+	_NR<ASObject> obj;
+	// contents of the ByteArray, allocated with new[] and owned by the queue
+	uint8_t* bytes;
+	uint32_t length;
+	number_t number;
+	std::string str;
+	ChannelMessage(KIND k):kind(k),bytes(nullptr),length(0),number(0){}
+};
+
 class MessageChannel: public EventDispatcher
 {
 private:
 	Mutex messagequeuemutex;
-	std::queue<_R<ASObject>> messagequeue;
+	// signalled whenever a message is added or removed and when the channel is closed
+	Cond messagequeuecond;
+	std::queue<ChannelMessage> messagequeue;
+	static bool isShareable(ASObject* o);
+	// converts the message to the value passed to the receiver
+	static void unpackMessage(asAtom& ret, ASWorker* wrk, ChannelMessage& msg);
 public:
 	MessageChannel(ASWorker* wrk,Class_base* c):EventDispatcher(wrk,c),state("open")
 	{
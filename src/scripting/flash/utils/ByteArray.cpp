@@ -31,6 +31,7 @@
 #include <sstream>
 #include <zlib.h>
 #include <glib.h>
+#include <SDL2/SDL.h>
 
 using namespace std;
 using namespace lightspark;
@@ -347,7 +348,8 @@ ASFUNCTIONBODY_ATOM(ByteArray,readBytes)
 	}
 	
 	uint8_t* buf=out->getBuffer(length+offset,true);
-	memcpy(buf+offset,th->bytes+th->position,length);
+	// source and destination may be the same ByteArray
+	memmove(buf+offset,th->bytes+th->position,length);
 	th->position+=length;
 	th->unlock();
 }
@@ -441,6 +443,92 @@ bool ByteArray::readBytes(uint32_t offset, uint32_t length,uint8_t* ret)
 	return true;
 }
 
+// the bulk conversions copy the raw bytes first and swap them in a separate loop, so the compiler can vectorize the loop
+static inline bool needsByteSwap(bool littleEndian)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+	return !littleEndian;
+#else
+	return littleEndian;
+#endif
+}
+static inline void swapBytes(uint16_t* values, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = GUINT16_SWAP_LE_BE(values[i]);
+}
+static inline void swapBytes(uint32_t* values, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = GUINT32_SWAP_LE_BE(values[i]);
+}
+static inline void swapBytes(float* values, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t v;
+		memcpy(&v,values+i,4);
+		v = GUINT32_SWAP_LE_BE(v);
+		memcpy(values+i,&v,4);
+	}
+}
+
+bool ByteArray::readShorts(uint16_t* ret, uint32_t count)
+{
+	if (position > len || count > (len-position)/2)
+		return false;
+	memcpy(ret,bytes+position,count*2);
+	position+=count*2;
+	if (needsByteSwap(littleEndian))
+		swapBytes(ret,count);
+	return true;
+}
+
+bool ByteArray::readUnsignedInts(uint32_t* ret, uint32_t count)
+{
+	if (position > len || count > (len-position)/4)
+		return false;
+	memcpy(ret,bytes+position,count*4);
+	position+=count*4;
+	if (needsByteSwap(littleEndian))
+		swapBytes(ret,count);
+	return true;
+}
+
+bool ByteArray::readFloats(float* ret, uint32_t count)
+{
+	static_assert(sizeof(float)==sizeof(uint32_t),"unexpected size of float");
+	if (position > len || count > (len-position)/4)
+		return false;
+	memcpy(ret,bytes+position,count*4);
+	position+=count*4;
+	if (needsByteSwap(littleEndian))
+		swapBytes(ret,count);
+	return true;
+}
+
+void ByteArray::writeUnsignedInts(const uint32_t* values, uint32_t count)
+{
+	if (count == 0)
+		return;
+	if ((uint64_t)position+(uint64_t)count*4 > BA_MAX_SIZE)
+		throwError<ASError>(kOutOfMemoryError);
+	getBuffer(position+count*4,true);
+	uint32_t* dst = (uint32_t*)(bytes+position);
+	memcpy(dst,values,count*4);
+	position+=count*4;
+	if (needsByteSwap(littleEndian))
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t v;
+			memcpy(&v,dst+i,4);
+			v = GUINT32_SWAP_LE_BE(v);
+			memcpy(dst+i,&v,4);
+		}
+	}
+}
+
 asAtom ByteArray::readObject()
 {
 	asAtom ret = asAtomHandler::nullAtom;
@@ -626,10 +714,11 @@ ASFUNCTIONBODY_ATOM(ByteArray,writeBytes)
 	//If the length is 0 the whole buffer must be copied
 	if(length == 0)
 		length=(out->getLength()-offset);
-	uint8_t* buf=out->getBuffer(offset+length,false);
 	th->lock();
 	th->getBuffer(th->position+length,true);
-	memcpy(th->bytes+th->position,buf+offset,length);
+	// get the source buffer after resizing, as the source may be the same ByteArray
+	uint8_t* buf=out->getBuffer(offset+length,false);
+	memmove(th->bytes+th->position,buf+offset,length);
 	th->position+=length;
 	th->unlock();
 }
@@ -1385,18 +1474,141 @@ void ByteArray::removeFrontBytes(int count)
 
 
 
+// arrays larger than this are deflated in parallel chunks on the ThreadPool
+#define PARALLEL_DEFLATE_THRESHOLD (1024*1024)
+#define PARALLEL_DEFLATE_CHUNK_SIZE (256*1024)
+#define DEFLATE_DICTIONARY_SIZE (32*1024)
+
+namespace
+{
+/*
+ * Compresses a contiguous run of chunks of the input as a raw deflate stream,
+ * primed with the preceding 32KB of input as dictionary. All but the last run
+ * end with a sync flush, so the outputs can simply be concatenated.
+ */
+class DeflateChunkJob: public IThreadJob
+{
+public:
+	const uint8_t* in;
+	uint32_t inlen;
+	const uint8_t* dict;
+	uint32_t dictlen;
+	bool last;
+	uint8_t* out;
+	uint32_t outlen;
+	uLong adler;
+	bool success;
+	Semaphore* done;
+	DeflateChunkJob():in(nullptr),inlen(0),dict(nullptr),dictlen(0),last(false),out(nullptr),outlen(0),adler(0),success(false),done(nullptr) {}
+	~DeflateChunkJob()
+	{
+		delete[] out;
+	}
+	void execute() override
+	{
+		adler = adler32(adler32(0,Z_NULL,0),in,inlen);
+		z_stream strm;
+		memset(&strm,0,sizeof(z_stream));
+		if(deflateInit2(&strm,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)!=Z_OK)
+			return;
+		if(dictlen && deflateSetDictionary(&strm,dict,dictlen)!=Z_OK)
+		{
+			deflateEnd(&strm);
+			return;
+		}
+		// the sync flush marker needs some bytes in addition to deflateBound
+		uint32_t buflen=deflateBound(&strm,inlen)+16;
+		out = new uint8_t[buflen];
+		strm.next_in=(Bytef*)in;
+		strm.avail_in=inlen;
+		strm.next_out=out;
+		strm.avail_out=buflen;
+		int status=deflate(&strm,last ? Z_FINISH : Z_SYNC_FLUSH);
+		if(last)
+			success = status==Z_STREAM_END;
+		else
+			success = status==Z_OK && strm.avail_in==0 && strm.avail_out>0;
+		outlen=buflen-strm.avail_out;
+		deflateEnd(&strm);
+	}
+	void jobFence() override
+	{
+		done->signal();
+	}
+};
+}
+
+bool ByteArray::compress_zlib_parallel()
+{
+	uint32_t chunkcount=(len+PARALLEL_DEFLATE_CHUNK_SIZE-1)/PARALLEL_DEFLATE_CHUNK_SIZE;
+	// one job per cpu, each one deflating a contiguous run of chunks
+	uint32_t jobcount=min(uint32_t(SDL_GetCPUCount()),min(8u,chunkcount));
+	if(jobcount<2)
+		return false;
+	uint32_t chunksPerJob=(chunkcount+jobcount-1)/jobcount;
+	jobcount=(chunkcount+chunksPerJob-1)/chunksPerJob;
+	vector<DeflateChunkJob> jobs(jobcount);
+	Semaphore done(0);
+	for(uint32_t i=0;i<jobcount;i++)
+	{
+		DeflateChunkJob& j=jobs[i];
+		uint32_t offset=i*chunksPerJob*PARALLEL_DEFLATE_CHUNK_SIZE;
+		j.in=bytes+offset;
+		j.inlen=min(chunksPerJob*PARALLEL_DEFLATE_CHUNK_SIZE,len-offset);
+		j.dictlen=min(uint32_t(DEFLATE_DICTIONARY_SIZE),offset);
+		j.dict=bytes+offset-j.dictlen;
+		j.last=i==jobcount-1;
+		j.done=&done;
+		getSystemState()->addJob(&j);
+	}
+	// the jobs only read from our buffer, so we have to wait for all of them before doing anything else
+	for(uint32_t i=0;i<jobcount;i++)
+		done.wait();
+
+	// zlib header for default compression and 32K window, followed by the deflate chunks and the adler32 checksum
+	uint32_t buflen=2+4;
+	uLong adler=adler32(0,Z_NULL,0);
+	for(auto it=jobs.begin();it!=jobs.end();++it)
+	{
+		// the ThreadPool may have been stopped before the job was executed
+		if(!it->success)
+			return false;
+		buflen+=it->outlen;
+		adler=adler32_combine(adler,it->adler,it->inlen);
+	}
+	uint8_t* compressed=new uint8_t[buflen];
+	uint8_t* p=compressed;
+	*p++=0x78;
+	*p++=0x9c;
+	for(auto it=jobs.begin();it!=jobs.end();++it)
+	{
+		memcpy(p,it->out,it->outlen);
+		p+=it->outlen;
+	}
+	*p++=(adler>>24)&0xff;
+	*p++=(adler>>16)&0xff;
+	*p++=(adler>>8)&0xff;
+	*p++=adler&0xff;
+	acquireBuffer(compressed, buflen);
+	position=buflen;
+	return true;
+}
+
 void ByteArray::compress_zlib()
 {
 	if(len==0)
 		return;
 
+	if(len>=PARALLEL_DEFLATE_THRESHOLD && compress_zlib_parallel())
+		return;
+
 	unsigned long buflen=compressBound(len);
-	uint8_t *compressed=(uint8_t*) malloc(buflen);
+	uint8_t *compressed=new uint8_t[buflen];
 	assert_and_throw(compressed);
 
 	if(compress(compressed, &buflen, bytes, len)!=Z_OK)
 	{
-		free(compressed);
+		delete[] compressed;
 		throw RunTimeException("zlib compress failed");
 	}
 
@@ -1406,53 +1618,97 @@ void ByteArray::compress_zlib()
 
 void ByteArray::uncompress_zlib(bool raw)
 {
-	z_stream strm;
+	z_stream localstrm;
 	int status;
 
 	if(len==0)
 		return;
 
-	strm.zalloc=Z_NULL;
-	strm.zfree=Z_NULL;
-	strm.opaque=Z_NULL;
-	strm.avail_in=len;
-	strm.next_in=bytes;
-	strm.total_out=0;
-	status=inflateInit2(&strm,raw ? -15 : 15);
-	if(status==Z_VERSION_ERROR)
-		throw Class<IOError>::getInstanceS(getInstanceWorker(),"not valid compressed data");
-	else if(status!=Z_OK)
-		throw RunTimeException("zlib uncompress failed");
-
-	vector<uint8_t> buf(3*len);
+	// reuse the inflate state of the current worker to avoid allocating the zlib window on every call
+	ASWorker* wrk = getWorker();
+	z_stream* strm = wrk ? wrk->getInflateStream(raw) : nullptr;
+	if (!strm)
+	{
+		strm=&localstrm;
+		strm->zalloc=Z_NULL;
+		strm->zfree=Z_NULL;
+		strm->opaque=Z_NULL;
+		status=inflateInit2(strm,raw ? -15 : 15);
+		if(status==Z_VERSION_ERROR)
+			throw Class<IOError>::getInstanceS(getInstanceWorker(),"not valid compressed data");
+		else if(status!=Z_OK)
+			throw RunTimeException("zlib uncompress failed");
+	}
+	strm->avail_in=len;
+	strm->next_in=bytes;
+
+	// inflate directly into the new buffer, growing it when necessary
+	uint32_t buflen=max(min(uint64_t(len)*3,uint64_t(BA_MAX_SIZE)),uint64_t(4096));
+	uint32_t outlen=0;
+	uint8_t* buf=new uint8_t[buflen];
 	do
 	{
-		strm.next_out=&buf[strm.total_out];
-		strm.avail_out=buf.size()-strm.total_out;
-		status=inflate(&strm, Z_NO_FLUSH);
+		strm->next_out=buf+outlen;
+		strm->avail_out=buflen-outlen;
+		status=inflate(strm, Z_NO_FLUSH);
+		outlen=buflen-strm->avail_out;
 
 		if(status!=Z_OK && status!=Z_STREAM_END)
 		{
-			inflateEnd(&strm);
+			delete[] buf;
+			if(strm==&localstrm)
+				inflateEnd(strm);
 			throw Class<IOError>::getInstanceS(getInstanceWorker(),"not valid compressed data");
 		}
 
-		if(strm.avail_out==0)
-			buf.resize(buf.size()+len);
+		if(strm->avail_out==0 && status!=Z_STREAM_END)
+		{
+			if(buflen>=BA_MAX_SIZE)
+			{
+				delete[] buf;
+				if(strm==&localstrm)
+					inflateEnd(strm);
+				throwError<ASError>(kOutOfMemoryError);
+			}
+			uint32_t newlen=min(uint64_t(buflen)+max(len,buflen/2),uint64_t(BA_MAX_SIZE));
+			uint8_t* buf2=new uint8_t[newlen];
+			memcpy(buf2,buf,outlen);
+			delete[] buf;
+			buf=buf2;
+			buflen=newlen;
+		}
 	} while(status!=Z_STREAM_END);
 
-	inflateEnd(&strm);
+	if(strm==&localstrm)
+		inflateEnd(strm);
 
-	len=strm.total_out;
+	// the estimated size may be much larger than the uncompressed data
+	if(outlen<buflen)
+	{
+		uint8_t* buf2=nullptr;
+		if(outlen)
+		{
+			buf2=new uint8_t[outlen];
+			memcpy(buf2,buf,outlen);
+		}
+		delete[] buf;
+		buf=buf2;
+		buflen=outlen;
+	}
+
+	if(bytes)
+	{
+#ifdef MEMORY_USAGE_PROFILING
+		getClass()->memoryAccount->removeBytes(real_len);
+#endif
+		delete[] bytes;
+	}
+	bytes=buf;
+	len=outlen;
+	real_len=buflen;
 #ifdef MEMORY_USAGE_PROFILING
-	getClass()->memoryAccount->addBytes(len-real_len);
+	getClass()->memoryAccount->addBytes(real_len);
 #endif
-	real_len = len;
-	uint8_t* bytes2 = new uint8_t[len];
-	assert_and_throw(bytes2);
-	delete[] bytes;
-	bytes = bytes2;
-	memcpy(bytes, &buf[0], len);
 	position=0;
 }
 
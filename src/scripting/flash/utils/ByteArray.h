@@ -44,6 +44,8 @@ protected:
 	uint32_t real_len;
 	uint32_t len;
 	void compress_zlib();
+	// deflates large arrays in parallel on the ThreadPool, returns false if the serial path has to be used
+	bool compress_zlib_parallel();
 	void uncompress_zlib(bool raw);
 	Mutex mutex;
 	uint8_t* getBufferIntern(unsigned int size, bool enableResize);
@@ -78,6 +80,17 @@ public:
 	bool readUTF(tiny_string& ret);
 	bool readUTFBytes(uint32_t length,tiny_string& ret);
 	bool readBytes(uint32_t offset, uint32_t length, uint8_t* ret);
+	/**
+	 * bulk reads of count values starting at the current position, converted from the endianness of the ByteArray.
+	 * position is advanced by the number of bytes read. returns false without reading anything if not enough bytes are available
+	 */
+	bool readShorts(uint16_t* ret, uint32_t count);
+	bool readUnsignedInts(uint32_t* ret, uint32_t count);
+	bool readFloats(float* ret, uint32_t count);
+	/**
+	 * bulk writes of count values at the current position, converted to the endianness of the ByteArray.
+	 */
+	void writeUnsignedInts(const uint32_t* values, uint32_t count);
 	inline bool readFloat(float& ret, uint32_t pos)
 	{
 		if(len < pos+4)
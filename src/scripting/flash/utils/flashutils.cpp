@@ -197,6 +197,79 @@ ASFUNCTIONBODY_ATOM(lightspark,describeType)
 	ret = asAtomHandler::fromObject(asAtomHandler::toObject(args[0],wrk)->describeType(wrk));
 }
 
+namespace
+{
+
+void setJSONProperty(ASObject* o, const char* name, asAtom v, ASWorker* wrk)
+{
+	multiname m(nullptr);
+	m.name_type=multiname::NAME_STRING;
+	m.isAttribute = false;
+	m.name_s_id=wrk->getSystemState()->getUniqueStringId(name);
+	o->setVariableByMultiname(m,v,ASObject::CONST_ALLOWED,nullptr,wrk);
+}
+
+asAtom stringOrNull(uint32_t id)
+{
+	return id == BUILTIN_STRINGS::EMPTY ? asAtomHandler::nullAtom : asAtomHandler::fromStringID(id);
+}
+
+// converts a member of the description of a class to the format of describeTypeJSON
+ASObject* describeMemberJSON(const ClassReflectionMember& member, bool includeMetadata, ASWorker* wrk)
+{
+	ASObject* res = Class<ASObject>::getInstanceS(wrk);
+	setJSONProperty(res,"name",asAtomHandler::fromStringID(member.name),wrk);
+	if (member.kind == ClassReflectionMember::METHOD)
+	{
+		setJSONProperty(res,"returnType",asAtomHandler::fromStringID(member.type),wrk);
+		Array* params = Class<Array>::getInstanceS(wrk);
+		for (auto it = member.parameters.begin(); it != member.parameters.end(); ++it)
+		{
+			ASObject* param = Class<ASObject>::getInstanceS(wrk);
+			setJSONProperty(param,"type",asAtomHandler::fromStringID(it->first),wrk);
+			setJSONProperty(param,"optional",asAtomHandler::fromBool(it->second),wrk);
+			params->push(asAtomHandler::fromObject(param));
+		}
+		setJSONProperty(res,"parameters",asAtomHandler::fromObject(params),wrk);
+	}
+	else
+	{
+		setJSONProperty(res,"type",asAtomHandler::fromStringID(member.type),wrk);
+		if (member.kind == ClassReflectionMember::ACCESSOR)
+			setJSONProperty(res,"access",asAtomHandler::fromStringID(member.access),wrk);
+		else
+			setJSONProperty(res,"access",asAtomHandler::fromString(wrk->getSystemState(),member.kind == ClassReflectionMember::CONSTANT ? "readonly" : "readwrite"),wrk);
+	}
+	if (member.kind != ClassReflectionMember::VARIABLE && member.kind != ClassReflectionMember::CONSTANT)
+		setJSONProperty(res,"declaredBy",stringOrNull(member.declaredBy),wrk);
+	setJSONProperty(res,"uri",stringOrNull(member.uri),wrk);
+	if (!includeMetadata)
+	{
+		setJSONProperty(res,"metadata",asAtomHandler::nullAtom,wrk);
+		return res;
+	}
+	Array* metadata = Class<Array>::getInstanceS(wrk);
+	for (auto it = member.metadata.begin(); it != member.metadata.end(); ++it)
+	{
+		ASObject* md = Class<ASObject>::getInstanceS(wrk);
+		setJSONProperty(md,"name",asAtomHandler::fromStringID(it->name),wrk);
+		Array* args = Class<Array>::getInstanceS(wrk);
+		for (auto arg = it->args.begin(); arg != it->args.end(); ++arg)
+		{
+			ASObject* a = Class<ASObject>::getInstanceS(wrk);
+			setJSONProperty(a,"key",asAtomHandler::fromStringID(arg->first),wrk);
+			setJSONProperty(a,"value",asAtomHandler::fromStringID(arg->second),wrk);
+			args->push(asAtomHandler::fromObject(a));
+		}
+		setJSONProperty(md,"value",asAtomHandler::fromObject(args),wrk);
+		metadata->push(asAtomHandler::fromObject(md));
+	}
+	setJSONProperty(res,"metadata",asAtomHandler::fromObject(metadata),wrk);
+	return res;
+}
+
+}
+
 ASFUNCTIONBODY_ATOM(lightspark,describeTypeJSON)
 {
 	_NR<ASObject> o;
@@ -241,7 +314,7 @@ ASFUNCTIONBODY_ATOM(lightspark,describeTypeJSON)
 		{
 			if (INCLUDE_METADATA)
 			{
-				LOG(LOG_NOT_IMPLEMENTED,"describeTypeJSON flag INCLUDE_METADATA");
+				LOG(LOG_NOT_IMPLEMENTED,"describeTypeJSON flag INCLUDE_METADATA for the class");
 			}
 			if (INCLUDE_BASES)
 			{
@@ -264,9 +337,38 @@ ASFUNCTIONBODY_ATOM(lightspark,describeTypeJSON)
 			{
 				LOG(LOG_NOT_IMPLEMENTED,"describeTypeJSON flag INCLUDE_CONSTRUCTOR");
 			}
-			if (INCLUDE_ACCESSORS || INCLUDE_METHODS || INCLUDE_VARIABLES)
+			if ((INCLUDE_ACCESSORS || INCLUDE_METHODS || INCLUDE_VARIABLES) && o->is<Class_base>())
+			{
+				LOG(LOG_NOT_IMPLEMENTED,"describeTypeJSON flag INCLUDE_ACCESSORS || INCLUDE_METHODS || INCLUDE_VARIABLES for classes");
+			}
+			else if (INCLUDE_ACCESSORS || INCLUDE_METHODS || INCLUDE_VARIABLES)
 			{
-				LOG(LOG_NOT_IMPLEMENTED,"describeTypeJSON flag INCLUDE_ACCESSORS || INCLUDE_METHODS || INCLUDE_VARIABLES");
+				// the members are taken from the description of the class, it is generated once if necessary
+				const std::vector<ClassReflectionMember>* members = cls->getReflection();
+				if (!members)
+				{
+					o->describeType(wrk)->decRef();
+					members = cls->getReflection();
+				}
+				Array* variables = INCLUDE_VARIABLES ? Class<Array>::getInstanceS(wrk) : nullptr;
+				Array* accessors = INCLUDE_ACCESSORS ? Class<Array>::getInstanceS(wrk) : nullptr;
+				Array* methods = INCLUDE_METHODS ? Class<Array>::getInstanceS(wrk) : nullptr;
+				if (members)
+				{
+					for (auto it = members->begin(); it != members->end(); ++it)
+					{
+						Array* list = it->kind == ClassReflectionMember::METHOD ? methods :
+							it->kind == ClassReflectionMember::ACCESSOR ? accessors : variables;
+						if (list)
+							list->push(asAtomHandler::fromObject(describeMemberJSON(*it,INCLUDE_METADATA,wrk)));
+					}
+				}
+				if (variables)
+					setJSONProperty(traits,"variables",asAtomHandler::fromObject(variables),wrk);
+				if (accessors)
+					setJSONProperty(traits,"accessors",asAtomHandler::fromObject(accessors),wrk);
+				if (methods)
+					setJSONProperty(traits,"methods",asAtomHandler::fromObject(methods),wrk);
 			}
 		}
 		m.name_s_id=wrk->getSystemState()->getUniqueStringId("traits");
@@ -280,7 +382,7 @@ ASFUNCTIONBODY_ATOM(lightspark,describeTypeJSON)
 
 ASFUNCTIONBODY_ATOM(lightspark,getTimer)
 {
-	uint64_t res=compat_msectiming() - wrk->getSystemState()->startTime;
+	uint64_t res=wrk->getSystemState()->getElapsedTime();
 	asAtomHandler::setInt(ret,wrk,(int32_t)res);
 }
 
@@ -64,6 +64,7 @@ ASFUNCTIONBODY_ATOM(ASString,_constructor)
 		th->hasId = false;
 		th->stringId = UINT32_MAX;
 		th->datafilled = true;
+		th->charpositions.clear();
 	}
 }
 
@@ -85,6 +86,27 @@ ASFUNCTIONBODY_ATOM(ASString,_getLength)
 	}
 }
 
+void ASString::buildCharPositions()
+{
+	charpositions.reserve(data.numChars()+1);
+	for (auto it = data.begin(); it != data.end(); it++)
+		charpositions.push_back(it.ptr()-data.raw_buf());
+	charpositions.push_back(data.numBytes());
+}
+
+uint32_t ASString::getCharPosition(uint32_t bytepos)
+{
+	if (bytepos >= data.numBytes())
+		return data.numChars();
+	if (data.isSinglebyte())
+		return bytepos;
+	if (charpositions.empty())
+		buildCharPositions();
+	// the character starting at or containing bytepos
+	auto it = upper_bound(charpositions.begin(),charpositions.end(),bytepos)-1;
+	return it-charpositions.begin();
+}
+
 void ASString::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_FINAL | CLASS_SEALED);
@@ -404,20 +426,19 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
-		unsigned int start=0;
-		unsigned int len = data.numChars();
+		// search on bytes, so every match doesn't have to be converted to a character index
+		uint32_t start=0;
+		uint32_t len = data.numBytes();
 		do
 		{
-			int match=data.find(del,start);
-			if(del.empty())
-				match++;
-			if(match==-1)
+			uint32_t match=data.find_bytes(del,start);
+			if(match==tiny_string::npos)
 				match= len;
-			ASObject* s=abstract_s(wrk,data.substr(start,(match-start)));
+			ASObject* s=abstract_s(wrk,data.substr_bytes(start,(match-start)));
 			if (res->size() >= limit)
 				break;
 			res->push(asAtomHandler::fromObject(s));
-			start=match+del.numChars();
+			start=match+del.numBytes();
 			if (start == len)
 				res->push(asAtomHandler::fromStringID(BUILTIN_STRINGS::EMPTY));
 		}
@@ -784,7 +805,7 @@ ASFUNCTIONBODY_ATOM(ASString,charCodeAt)
 	// fast path if obj is ASString
 	if (asAtomHandler::isStringID(obj))
 	{
-		tiny_string s = wrk->getSystemState()->getStringFromUniqueId(asAtomHandler::getStringId(obj));
+		const tiny_string& s = wrk->getSystemState()->getStringFromUniqueId(asAtomHandler::getStringId(obj));
 		if(index<0 || index>=(int64_t)s.numChars())
 			asAtomHandler::setNumber(ret,wrk,Number::NaN);
 		else
@@ -821,14 +842,27 @@ ASFUNCTIONBODY_ATOM(ASString,indexOf)
 		asAtomHandler::setInt(ret,wrk,-1);
 		return;
 	}
-	tiny_string data = asAtomHandler::toString(obj,wrk);
 	tiny_string arg0=asAtomHandler::toString(args[0],wrk);
 	int startIndex=0;
 	if(argslen>1)
 		startIndex=asAtomHandler::toInt(args[1]);
+	// fast path if obj is ASString, the string isn't copied and the character positions are looked up
+	if (asAtomHandler::isString(obj) && asAtomHandler::getObject(obj))
+	{
+		ASString* th = asAtomHandler::as<ASString>(obj);
+		const tiny_string& data = th->getData();
+		startIndex = imin(imax(startIndex, 0), data.numChars());
+		uint32_t pos = data.find_bytes(arg0, th->getBytePosition(startIndex));
+		if(pos == tiny_string::npos)
+			asAtomHandler::setInt(ret,wrk,-1);
+		else
+			asAtomHandler::setInt(ret,wrk,(int32_t)th->getCharPosition(pos));
+		return;
+	}
+	tiny_string data = asAtomHandler::toString(obj,wrk);
 	startIndex = imin(imax(startIndex, 0), data.numChars());
 
-	size_t pos = data.find(arg0.raw_buf(), startIndex);
+	size_t pos = data.find(arg0, startIndex);
 	if(pos == data.npos)
 		asAtomHandler::setInt(ret,wrk,-1);
 	else
@@ -838,9 +872,8 @@ ASFUNCTIONBODY_ATOM(ASString,indexOf)
 ASFUNCTIONBODY_ATOM(ASString,lastIndexOf)
 {
 	assert_and_throw(argslen==1 || argslen==2);
-	tiny_string data = asAtomHandler::toString(obj,wrk);
 	tiny_string val=asAtomHandler::toString(args[0],wrk);
-	size_t startIndex=data.npos;
+	size_t startIndex=tiny_string::npos;
 	if(argslen > 1 && !asAtomHandler::isUndefined(args[1]) && !std::isnan(asAtomHandler::toNumber(args[1])) && !(asAtomHandler::toNumber(args[1]) > 0 && std::isinf(asAtomHandler::toNumber(args[1]))))
 	{
 		int32_t i = asAtomHandler::toInt(args[1]);
@@ -852,9 +885,23 @@ ASFUNCTIONBODY_ATOM(ASString,lastIndexOf)
 		startIndex = i;
 	}
 
+	// fast path if obj is ASString, the string isn't copied and the character positions are looked up
+	if (asAtomHandler::isString(obj) && asAtomHandler::getObject(obj))
+	{
+		ASString* th = asAtomHandler::as<ASString>(obj);
+		const tiny_string& data = th->getData();
+		startIndex = imin(startIndex, data.numChars());
+		uint32_t pos = data.rfind_bytes(val, th->getBytePosition(startIndex));
+		if(pos == tiny_string::npos)
+			asAtomHandler::setInt(ret,wrk,-1);
+		else
+			asAtomHandler::setInt(ret,wrk,(int32_t)th->getCharPosition(pos));
+		return;
+	}
+	tiny_string data = asAtomHandler::toString(obj,wrk);
 	startIndex = imin(startIndex, data.numChars());
 
-	size_t pos=data.rfind(val.raw_buf(), startIndex);
+	size_t pos=data.rfind(val, startIndex);
 	if(pos==data.npos)
 		asAtomHandler::setInt(ret,wrk,-1);
 	else
@@ -1077,14 +1124,15 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 	else
 	{
 		const tiny_string& s=asAtomHandler::toString(args[0],wrk);
-		int index=res->getData().find(s,0);
-		if(index==-1) //No result
+		uint32_t index=res->getData().find_bytes(s);
+		if(index==tiny_string::npos) //No result
 		{
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
 		res->hasId = false;
-		res->getData().replace(index,s.numChars(),replaceWith);
+		res->charpositions.clear();
+		res->getData().replace_bytes(index,s.numBytes(),replaceWith);
 	}
 
 	ret = asAtomHandler::fromObject(res);
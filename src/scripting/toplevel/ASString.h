@@ -29,7 +29,9 @@ namespace lightspark
 {
 /*
  * The AS String class.
- * The 'data' is immutable -> it cannot be changed after creation of the object
+ * The 'data' is immutable -> it cannot be changed after creation of the object.
+ * The only exception is append, which changes it in place while the string is referenced
+ * by nothing but the operand being concatenated (see asAtomHandler::add)
  */
 class ASString: public ASObject
 {
@@ -42,9 +44,10 @@ private:
 	number_t parseStringInfinite(const char *s, char **end) const;
 	tiny_string data;
 	
-	// stores the position of utf8-characters in the string
+	// stores the byte position of every utf8-character in the string, followed by the length in bytes
 	// speeds up direct access to characters by position
 	std::vector<uint32_t> charpositions;
+	void buildCharPositions();
 public:
 	ASString(ASWorker* wrk,Class_base* c);
 	ASString(ASWorker* wrk,Class_base* c, const std::string& s);
@@ -63,6 +66,16 @@ public:
 		}
 		return data;
 	}
+	/* appends s to this string, only allowed if nothing else references it
+	 * (see asAtomHandler::add). The buffer grows exponentially, so building a
+	 * string by repeated appends takes linear time */
+	FORCE_INLINE void append(const tiny_string& s)
+	{
+		getData() += s;
+		stringId = UINT32_MAX;
+		hasId = false;
+		charpositions.clear();
+	}
 	FORCE_INLINE bool isEmpty() const
 	{
 		if (hasId)
@@ -130,16 +143,11 @@ public:
 		if (data.isSinglebyte())
 			return charpos;
 		if (charpositions.empty())
-		{
-			charpositions.reserve(this->data.numChars());
-			for (auto it = data.begin(); it != data.end(); it++)
-			{
-				charpositions.push_back(it.ptr()-data.raw_buf());
-			}
-		}
+			buildCharPositions();
 		return charpositions[charpos];
-		
 	}
+	// converts a byte position in the string to the position of the character
+	uint32_t getCharPosition(uint32_t bytepos);
 };
 
 template<>
@@ -400,6 +400,36 @@ void Vector::append(asAtom &o)
 	vec.push_back(o);
 }
 
+void Vector::getNumbers(number_t* values, uint32_t start, uint32_t count) const
+{
+	assert(start+count <= vec.size());
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = asAtomHandler::toNumber(vec[start+i]);
+}
+
+void Vector::setNumbers(const number_t* values, uint32_t start, uint32_t count)
+{
+	if (start+count > vec.size())
+	{
+		if (fixed)
+			throwRangeError(start+count-1);
+		while (vec.size() < start)
+			vec.push_back(getDefaultValue());
+	}
+	ASWorker* wrk = getInstanceWorker();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (start+i < vec.size())
+		{
+			asAtom old = vec[start+i];
+			if (asAtomHandler::replaceNumber(vec[start+i],wrk,values[i]))
+				ASATOM_DECREF(old);
+		}
+		else
+			vec.push_back(asAtomHandler::fromNumber(wrk,values[i],false));
+	}
+}
+
 void Vector::remove(ASObject *o)
 {
 	for (auto it = vec.begin(); it != vec.end(); it++)
@@ -414,11 +444,17 @@ void Vector::remove(ASObject *o)
 
 ASObject *Vector::describeType(ASWorker* wrk) const
 {
-	pugi::xml_document p;
-	pugi::xml_node root = p.append_child("type");
+	Class_base* prot=getClass();
+	if (prot)
+	{
+		ASObject* res = prot->getCachedDescription(wrk,true);
+		if (res)
+			return res;
+	}
+	pugi::xml_document* p = new pugi::xml_document();
+	pugi::xml_node root = p->append_child("type");
 
 	// type attributes
-	Class_base* prot=getClass();
 	if(prot)
 	{
 		root.append_attribute("name").set_value(prot->getQualifiedClassName(true).raw_buf());
@@ -436,8 +472,12 @@ ASObject *Vector::describeType(ASWorker* wrk) const
 
 	//LOG(LOG_INFO,"describeType:"<< Class<XML>::getInstanceS(getInstanceWorker(),root)->toXMLString_internal());
 
-	return XML::createFromNode(wrk,root);
-	
+	ASObject* res = XML::createFromNode(wrk,root);
+	if (prot)
+		prot->setCachedDescription(p,true);
+	else
+		delete p;
+	return res;
 }
 
 ASFUNCTIONBODY_ATOM(Vector,push)
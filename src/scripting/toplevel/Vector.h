@@ -343,6 +343,11 @@ public:
 	//Takes ownership of o.
 	void append(asAtom& o);
 	void setFixed(bool v) { fixed = v; }
+	// converts count elements starting at start to numbers, for batch operations on Vector.<Number>
+	void getNumbers(number_t* values, uint32_t start, uint32_t count) const;
+	/* stores count numbers starting at start, the Vector is extended if needed.
+	 * Number objects only referenced by this Vector are reused */
+	void setNumbers(const number_t* values, uint32_t start, uint32_t count);
 	
 	void remove(ASObject* o);
 
@@ -396,6 +396,8 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 	}
 	assert(wrk == getWorker());
 	call_context* saved_cc = wrk->incStack(obj,this->functionname);
+	if(USUALLY_FALSE(SamplingProfiler::active.load(std::memory_order_relaxed)))
+		wrk->profilerEnterMethod(mi,obj,this->functionname);
 	if (codeStatus != method_body_info::PRELOADED && codeStatus != method_body_info::USED)
 	{
 		mi->body->codeStatus = method_body_info::PRELOADING;
@@ -1164,16 +1166,16 @@ const Type* Type::getTypeFromMultiname(multiname* mn, ABCContext* context, bool
 	return typeObject ? typeObject->as<Type>() : nullptr;
 }
 
-Class_base::Class_base(const QName& name, uint32_t _classID, MemoryAccount* m):ASObject(getSys()->worker,Class_object::getClass(getSys()),T_CLASS),protected_ns(getSys(),"",NAMESPACE),constructor(nullptr),
-	qualifiedClassnameID(UINT32_MAX),global(nullptr),borrowedVariables(m),
+Class_base::Class_base(const QName& name, uint32_t _classID, MemoryAccount* m):ASObject(getSys()->worker,Class_object::getClass(getSys()),T_CLASS),superDisplay(nullptr),interfaceID(UINT32_MAX),interfaceBitsValid(false),protected_ns(getSys(),"",NAMESPACE),constructor(nullptr),
+	qualifiedClassnameID(UINT32_MAX),instanceDescription(nullptr),classDescription(nullptr),global(nullptr),borrowedVariables(m),
 	context(nullptr),class_name(name),memoryAccount(m),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(_classID)
 {
 	setSystemState(getSys());
 	setRefConstant();
 }
 
-Class_base::Class_base(const Class_object* c):ASObject((MemoryAccount*)nullptr),protected_ns(getSys(),BUILTIN_STRINGS::EMPTY,NAMESPACE),constructor(nullptr),
-	qualifiedClassnameID(UINT32_MAX),global(nullptr),borrowedVariables(nullptr),
+Class_base::Class_base(const Class_object* c):ASObject((MemoryAccount*)nullptr),superDisplay(nullptr),interfaceID(UINT32_MAX),interfaceBitsValid(false),protected_ns(getSys(),BUILTIN_STRINGS::EMPTY,NAMESPACE),constructor(nullptr),
+	qualifiedClassnameID(UINT32_MAX),instanceDescription(nullptr),classDescription(nullptr),global(nullptr),borrowedVariables(nullptr),
 	context(nullptr),class_name(BUILTIN_STRINGS::STRING_CLASS,BUILTIN_STRINGS::EMPTY),memoryAccount(nullptr),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(UINT32_MAX)
 {
 	type=T_CLASS;
@@ -1304,6 +1306,7 @@ void Class_base::setSuper(Ref<Class_base> super_)
 	assert(!super);
 	super = super_;
 	copyBorrowedTraitsFromSuper();
+	getSuperDisplay();
 }
 
 ASFUNCTIONBODY_ATOM(Class_base,_toString)
@@ -1333,6 +1336,8 @@ void Class_base::addLengthGetter()
 
 Class_base::~Class_base()
 {
+	clearDescriptions();
+	clearSuperDisplay();
 }
 
 void Class_base::_getter_constructorprop(asAtom& ret, ASWorker* wrk, asAtom& obj, asAtom* args, const unsigned int argslen)
@@ -1381,11 +1386,13 @@ void Class_base::generator(ASWorker* wrk, asAtom& ret, asAtom* args, const unsig
 void Class_base::addImplementedInterface(const multiname& i)
 {
 	interfaces.push_back(i);
+	interfaceBitsValid.store(false);
 }
 
 void Class_base::addImplementedInterface(Class_base* i)
 {
 	interfaces_added.push_back(i);
+	interfaceBitsValid.store(false);
 }
 
 tiny_string Class_base::toString()
@@ -1442,6 +1449,10 @@ void Class_base::finalize()
 {
 	borrowedVariables.destroyContents();
 	super.reset();
+	clearSuperDisplay();
+	interfaceBitsValid.store(false);
+	interfaceBits.clear();
+	clearDescriptions();
 	prototype.reset();
 	protected_ns = nsNameAndKind(getSystemState(),"",NAMESPACE);
 	ASObject* p =constructorprop.getPtr();
@@ -1586,6 +1597,106 @@ void Class_base::linkInterface(Class_base* c) const
 	}
 }
 
+namespace
+{
+// protects building the caches used by Class_base::isSubClass
+Mutex classCacheMutex;
+}
+
+const std::vector<const Class_base*>& Class_base::getSuperDisplay() const
+{
+	// super can only be set once, so the display is outdated only if the topmost ancestor got a super after the display was built
+	const std::vector<const Class_base*>* display = superDisplay.load(std::memory_order_acquire);
+	if (display && !display->front()->super)
+		return *display;
+	Locker l(classCacheMutex);
+	display = superDisplay.load(std::memory_order_relaxed);
+	if (display && !display->front()->super)
+		return *display;
+	uint32_t depth=0;
+	for (const Class_base* c=super.getPtr(); c; c=c->super.getPtr())
+		depth++;
+	std::vector<const Class_base*>* newdisplay = new std::vector<const Class_base*>(depth+1);
+	const Class_base* c=this;
+	for (uint32_t i=depth+1; i>0; i--)
+	{
+		(*newdisplay)[i-1]=c;
+		c=c->super.getPtr();
+	}
+	if (display)
+		oldSuperDisplays.push_back(display);
+	superDisplay.store(newdisplay,std::memory_order_release);
+	return *newdisplay;
+}
+
+void Class_base::clearSuperDisplay()
+{
+	Locker l(classCacheMutex);
+	delete superDisplay.exchange(nullptr);
+	for (auto it = oldSuperDisplays.begin(); it != oldSuperDisplays.end(); it++)
+		delete *it;
+	oldSuperDisplays.clear();
+}
+
+uint32_t Class_base::getInterfaceID() const
+{
+	static std::atomic<uint32_t> nextInterfaceID(0);
+	uint32_t id = interfaceID.load();
+	if (id==UINT32_MAX)
+	{
+		// if another thread was faster its id is used, the one taken here is wasted
+		uint32_t newid = nextInterfaceID.fetch_add(1);
+		if (interfaceID.compare_exchange_strong(id,newid))
+			id = newid;
+	}
+	return id;
+}
+
+bool Class_base::buildInterfaceBits() const
+{
+	if (interfaceBitsValid.load(std::memory_order_acquire))
+		return true;
+	Locker l(classCacheMutex);
+	return buildInterfaceBitsLocked();
+}
+
+bool Class_base::buildInterfaceBitsLocked() const
+{
+	if (interfaceBitsValid.load(std::memory_order_relaxed))
+		return true;
+	std::vector<uint64_t> bits;
+	if (super)
+	{
+		if (!super->buildInterfaceBitsLocked())
+			return false;
+		bits = super->interfaceBits;
+	}
+	bool alldefined;
+	const std::vector<Class_base*>& interfacelist = getInterfaces(&alldefined);
+	if (!alldefined)
+		return false;
+	for (auto it = interfacelist.begin(); it != interfacelist.end(); it++)
+	{
+		if (!(*it)->buildInterfaceBitsLocked())
+			return false;
+		const std::vector<uint64_t>& b = (*it)->interfaceBits;
+		if (bits.size() < b.size())
+			bits.resize(b.size(),0);
+		for (uint32_t i=0; i < b.size(); i++)
+			bits[i] |= b[i];
+	}
+	if (isInterface)
+	{
+		uint32_t id = getInterfaceID();
+		if (bits.size() <= id/64)
+			bits.resize(id/64+1,0);
+		bits[id/64] |= UINT64_C(1)<<(id%64);
+	}
+	interfaceBits.swap(bits);
+	interfaceBitsValid.store(true,std::memory_order_release);
+	return true;
+}
+
 bool Class_base::isSubClass(const Class_base* cls, bool considerInterfaces) const
 {
 //	check();
@@ -1596,16 +1707,37 @@ bool Class_base::isSubClass(const Class_base* cls, bool considerInterfaces) cons
 	//an interface can't be subclass of a normal class, we only check the interfaces if cls is an interface itself
 	if (considerInterfaces && cls->isInterface)
 	{
-		const std::vector<Class_base*> interfaces = getInterfaces();
-		for(unsigned int i=0;i<interfaces.size();i++)
+		if (!buildInterfaceBits())
+			return isSubClassSlow(cls, considerInterfaces);
+		uint32_t id = cls->getInterfaceID();
+		if (id/64 < interfaceBits.size() && (interfaceBits[id/64] & (UINT64_C(1)<<(id%64))))
+			return true;
+	}
+
+	//cls is a super of this if it is found at its own depth in our display
+	const std::vector<const Class_base*>& display = getSuperDisplay();
+	size_t depth = cls->getSuperDisplay().size()-1;
+	return depth < display.size() && display[depth]==cls;
+}
+
+bool Class_base::isSubClassSlow(const Class_base* cls, bool considerInterfaces) const
+{
+	if(cls==this || cls==cls->getSystemState()->getObjectClassRef())
+		return true;
+
+	//Now check the interfaces
+	if (considerInterfaces && cls->isInterface)
+	{
+		const std::vector<Class_base*>& interfacelist = getInterfaces();
+		for(unsigned int i=0;i<interfacelist.size();i++)
 		{
-			if(interfaces[i]->isSubClass(cls, considerInterfaces))
+			if(interfacelist[i]->isSubClassSlow(cls, considerInterfaces))
 				return true;
 		}
 	}
 
 	//Now ask the super
-	if(super && super->isSubClass(cls, considerInterfaces))
+	if(super && super->isSubClassSlow(cls, considerInterfaces))
 		return true;
 	return false;
 }
@@ -1654,8 +1786,11 @@ tiny_string Class_base::getName() const
 
 ASObject *Class_base::describeType(ASWorker* wrk) const
 {
-	pugi::xml_document p;
-	pugi::xml_node root = p.append_child("type");
+	ASObject* res = getCachedDescription(wrk,false);
+	if (res)
+		return res;
+	pugi::xml_document* p = new pugi::xml_document();
+	pugi::xml_node root = p->append_child("type");
 
 	root.append_attribute("name").set_value(getQualifiedClassName(true).raw_buf());
 	root.append_attribute("base").set_value("Class");
@@ -1685,7 +1820,95 @@ ASObject *Class_base::describeType(ASWorker* wrk) const
 	node=root.append_child("factory");
 	node.append_attribute("type").set_value(getQualifiedClassName().raw_buf());
 	describeInstance(node,false,false);
-	return XML::createFromNode(wrk,root);
+	res = XML::createFromNode(wrk,root);
+	setCachedDescription(p,false);
+	return res;
+}
+
+ASObject* Class_base::getCachedDescription(ASWorker* wrk, bool forinstance) const
+{
+	Locker l(descriptionMutex);
+	pugi::xml_document* doc = forinstance ? instanceDescription : classDescription;
+	if (!doc)
+		return nullptr;
+	return XML::createFromNode(wrk,doc->first_child());
+}
+
+void Class_base::setCachedDescription(pugi::xml_document* doc, bool forinstance) const
+{
+	// the description may still change if not all interfaces are defined
+	bool alldefined = true;
+	getInterfaces(&alldefined);
+	Locker l(descriptionMutex);
+	pugi::xml_document*& cached = forinstance ? instanceDescription : classDescription;
+	if (!alldefined || cached)
+	{
+		delete doc;
+		return;
+	}
+	cached = doc;
+	if (forinstance)
+		buildReflection();
+}
+
+const std::vector<ClassReflectionMember>* Class_base::getReflection() const
+{
+	Locker l(descriptionMutex);
+	return instanceDescription ? &reflection : nullptr;
+}
+
+void Class_base::buildReflection() const
+{
+	SystemState* sys = getSystemState();
+	auto getId = [sys](const pugi::xml_node& n, const char* attr)
+	{
+		const char* v = n.attribute(attr).value();
+		// the value is copied, the interned string has to outlive the document
+		return *v ? sys->getUniqueStringId(tiny_string(v,true)) : (uint32_t)BUILTIN_STRINGS::EMPTY;
+	};
+	for (pugi::xml_node n = instanceDescription->first_child().first_child(); n; n = n.next_sibling())
+	{
+		ClassReflectionMember m;
+		if (strcmp(n.name(),"variable") == 0)
+			m.kind = ClassReflectionMember::VARIABLE;
+		else if (strcmp(n.name(),"constant") == 0)
+			m.kind = ClassReflectionMember::CONSTANT;
+		else if (strcmp(n.name(),"accessor") == 0)
+			m.kind = ClassReflectionMember::ACCESSOR;
+		else if (strcmp(n.name(),"method") == 0)
+			m.kind = ClassReflectionMember::METHOD;
+		else
+			continue;
+		m.name = getId(n,"name");
+		m.type = getId(n,m.kind == ClassReflectionMember::METHOD ? "returnType" : "type");
+		m.access = getId(n,"access");
+		m.declaredBy = getId(n,"declaredBy");
+		m.uri = getId(n,"uri");
+		for (pugi::xml_node c = n.first_child(); c; c = c.next_sibling())
+		{
+			if (strcmp(c.name(),"parameter") == 0)
+				m.parameters.push_back(make_pair(getId(c,"type"),strcmp(c.attribute("optional").value(),"true") == 0));
+			else if (strcmp(c.name(),"metadata") == 0)
+			{
+				ClassReflectionMetadata md;
+				md.name = getId(c,"name");
+				for (pugi::xml_node arg = c.first_child(); arg; arg = arg.next_sibling())
+					md.args.push_back(make_pair(getId(arg,"key"),getId(arg,"value")));
+				m.metadata.push_back(md);
+			}
+		}
+		reflection.push_back(m);
+	}
+}
+
+void Class_base::clearDescriptions()
+{
+	Locker l(descriptionMutex);
+	delete instanceDescription;
+	instanceDescription = nullptr;
+	delete classDescription;
+	classDescription = nullptr;
+	reflection.clear();
 }
 
 void Class_base::describeInstance(pugi::xml_node& root, bool istemplate,bool forinstance) const
@@ -24,6 +24,7 @@
 #include <vector>
 #include <set>
 #include <unordered_set>
+#include <atomic>
 #include "asobject.h"
 #include "exceptions.h"
 #include "threading.h"
@@ -35,6 +36,7 @@
 namespace pugi
 {
 	class xml_node;
+	class xml_document;
 }
 namespace lightspark
 {
@@ -156,6 +158,31 @@ public:
 class Prototype;
 class ObjectConstructor;
 
+// a metadata tag in the description of a class
+struct ClassReflectionMetadata
+{
+	uint32_t name;
+	// ids of the keys and values of the arguments
+	std::vector<std::pair<uint32_t,uint32_t>> args;
+};
+
+// a variable, constant, accessor or method in the description of the instances of a class
+struct ClassReflectionMember
+{
+	enum KIND { VARIABLE, CONSTANT, ACCESSOR, METHOD };
+	KIND kind;
+	// ids of the attribute values, BUILTIN_STRINGS::EMPTY if the attribute is missing
+	uint32_t name;
+	// the return type for methods
+	uint32_t type;
+	uint32_t access;
+	uint32_t declaredBy;
+	uint32_t uri;
+	// ids of the types of the parameters of methods and if they are optional
+	std::vector<std::pair<uint32_t,bool>> parameters;
+	std::vector<ClassReflectionMetadata> metadata;
+};
+
 class Class_base: public ASObject, public Type
 {
 friend class ABCVm;
@@ -164,6 +191,21 @@ template<class T> friend class Template;
 private:
 	mutable std::vector<multiname> interfaces;
 	mutable std::vector<Class_base*> interfaces_added;
+	/* The caches used by isSubClass are filled on first use, builtin classes are shared by all workers.
+	 * They are built while holding a mutex and published with atomics */
+	// all ancestors of this class indexed by inheritance depth, the last entry is the class itself
+	mutable std::atomic<const std::vector<const Class_base*>*> superDisplay;
+	// replaced displays, they are kept until finalize because other threads may still use them
+	mutable std::vector<const std::vector<const Class_base*>*> oldSuperDisplays;
+	// bitset of the interned ids of all interfaces implemented by this class or its ancestors
+	mutable std::vector<uint64_t> interfaceBits;
+	mutable std::atomic<uint32_t> interfaceID;
+	mutable std::atomic<bool> interfaceBitsValid;
+	const std::vector<const Class_base*>& getSuperDisplay() const;
+	void clearSuperDisplay();
+	uint32_t getInterfaceID() const;
+	bool buildInterfaceBitsLocked() const;
+	bool isSubClassSlow(const Class_base* cls, bool considerInterfaces) const;
 	std::unordered_set<uint32_t> overriddenmethods;
 	nsNameAndKind protected_ns;
 	void initializeProtectedNamespace(uint32_t nameId, const namespace_info& ns,RootMovieClip* root);
@@ -173,6 +215,15 @@ private:
 	void describeConstructor(pugi::xml_node &root) const;
 	virtual void describeClassMetadata(pugi::xml_node &root) const {}
 	uint32_t qualifiedClassnameID;
+	/* the xml generated by describeType for instances of this class and for the class itself,
+	 * they are only generated once as the traits don't change after the class is defined */
+	mutable pugi::xml_document* instanceDescription;
+	mutable pugi::xml_document* classDescription;
+	// the members of instanceDescription, for describeTypeJSON
+	mutable std::vector<ClassReflectionMember> reflection;
+	mutable Mutex descriptionMutex;
+	void buildReflection() const;
+	void clearDescriptions();
 protected:
 	Global* global;
 	void describeMetadata(pugi::xml_node &node, const traits_info& trait) const;
@@ -234,6 +285,11 @@ public:
 	 * If considerInterfaces is true, check interfaces, too.
 	 */
 	bool isSubClass(const Class_base* cls, bool considerInterfaces=true) const;
+	/*
+	 * Precomputes the interface bitset used by isSubClass.
+	 * Returns false if not all implemented interfaces are defined yet.
+	 */
+	bool buildInterfaceBits() const;
 	const tiny_string getQualifiedClassName(bool forDescribeType = false) const;
 	uint32_t getQualifiedClassNameID();
 	tiny_string getName() const override;
@@ -241,6 +297,12 @@ public:
 	virtual void generator(ASWorker* wrk,asAtom &ret, asAtom* args, const unsigned int argslen);
 	ASObject *describeType(ASWorker* wrk) const override;
 	void describeInstance(pugi::xml_node &root, bool istemplate, bool forinstance) const;
+	// returns a new XML object with the cached result of describeType, or nullptr if it wasn't generated yet
+	ASObject* getCachedDescription(ASWorker* wrk, bool forinstance) const;
+	// caches the result of describeType for instances of this class or for the class itself, takes ownership of doc
+	void setCachedDescription(pugi::xml_document* doc, bool forinstance) const;
+	// the members of the description of the instances, nullptr if it wasn't generated yet
+	const std::vector<ClassReflectionMember>* getReflection() const;
 	virtual const Template_base* getTemplate() const { return nullptr; }
 	/*
 	 * Converts the given object to an object of this Class_base's type.
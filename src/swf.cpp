@@ -43,6 +43,11 @@
 #include "backends/input.h"
 #include "backends/locale.h"
 #include "backends/currency.h"
+#include "backends/profiler.h"
+#include "backends/tracing.h"
+#include "backends/benchmark.h"
+#include "scripting/flash/display/CachedSurfaceManager.h"
+#include "scripting/flash/filters/FilterChain.h"
 #include "memory_support.h"
 #include "parsing/tags.h"
 
@@ -159,16 +164,54 @@ const URLInfo& RootMovieClip::getBaseURL()
 		return origin;
 }
 
+static const char* broadcastEventNames[BROADCAST_EVENT_COUNT] = { "enterFrame", "frameConstructed", "exitFrame", "render" };
+
 void SystemState::registerFrameListener(DisplayObject* obj)
 {
 	Locker l(mutexFrameListeners);
 	frameListeners.insert(obj);
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+		broadcastListeners[i].insert(obj);
 }
 
 void SystemState::unregisterFrameListener(DisplayObject* obj)
 {
 	Locker l(mutexFrameListeners);
 	frameListeners.erase(obj);
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+		broadcastListeners[i].erase(obj);
+}
+
+void SystemState::registerBroadcastListener(DisplayObject* obj, BROADCAST_EVENT_TYPE type)
+{
+	Locker l(mutexFrameListeners);
+	frameListeners.insert(obj);
+	broadcastListeners[type].insert(obj);
+}
+
+void SystemState::unregisterBroadcastListener(DisplayObject* obj, BROADCAST_EVENT_TYPE type)
+{
+	Locker l(mutexFrameListeners);
+	broadcastListeners[type].erase(obj);
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+	{
+		if (broadcastListeners[i].count(obj))
+			return;
+	}
+	frameListeners.erase(obj);
+}
+
+bool SystemState::getBroadcastEventType(const tiny_string& event, BROADCAST_EVENT_TYPE& type)
+{
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+	{
+		if (event == broadcastEventNames[i])
+		{
+			type = (BROADCAST_EVENT_TYPE)i;
+			return true;
+		}
+	}
+	return false;
 }
 
 void SystemState::addBroadcastEvent(const tiny_string& event)
@@ -186,6 +229,33 @@ void SystemState::addBroadcastEvent(const tiny_string& event)
 	}
 }
 
+// an event sent in the last frame can be reused if it was handled and is not referenced anywhere else
+template<class T>
+static bool isFrameEventReusable(const NullableRef<T>& ev)
+{
+	return !ev.isNull() && ev->getRefCount()==1 && !ACQUIRE_READ(ev->queued);
+}
+
+void SystemState::addBroadcastEvent(BROADCAST_EVENT_TYPE type)
+{
+	Locker l(mutexFrameListeners);
+	std::set<DisplayObject*>& listeners = broadcastListeners[type];
+	if(!listeners.empty())
+	{
+		_NR<Event>& e = broadcastEvents[type];
+		if (isFrameEventReusable(e))
+			e->resetDispatchState();
+		else
+			e = _MR(Class<Event>::getInstanceS(this->worker,broadcastEventNames[type]));
+		auto it=listeners.begin();
+		for(;it!=listeners.end();it++)
+		{
+			(*it)->incRef();
+			getVm(this)->addEvent(_MR(*it),e);
+		}
+	}
+}
+
 void SystemState::registerListenerFunction(IFunction* f)
 {
 	Locker l(mutexFrameListeners);
@@ -259,7 +329,7 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),
 	showProfilingData(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),avm1global(nullptr),
 	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),
-	systemDomain(nullptr),worker(nullptr),workerDomain(nullptr),singleworker(true),
+	samplingProfiler(nullptr),benchmarkRunner(nullptr),cachedSurfaceManager(nullptr),filterChain(nullptr),systemDomain(nullptr),worker(nullptr),workerDomain(nullptr),singleworker(true),
 	downloadManager(nullptr),extScriptObject(nullptr),scaleMode(SHOW_ALL),unaccountedMemory(nullptr),tagsMemory(nullptr),stringMemory(nullptr),textTokenMemory(nullptr),shapeTokenMemory(nullptr),morphShapeTokenMemory(nullptr),bitmapTokenMemory(nullptr),spriteTokenMemory(nullptr),
 	static_SoundMixer_bufferTime(0),static_Multitouch_inputMode("gesture"),isinitialized(false)
 {
@@ -310,6 +380,10 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	bitmapTokenMemory = allocateMemoryAccount("Tokens.Bitmap");
 	spriteTokenMemory = allocateMemoryAccount("Tokens.Sprite");
 
+	cachedSurfaceManager = new CachedSurfaceManager(Config::getConfig()->getCacheAsBitmapBudget(),
+							Config::getConfig()->getCacheAsBitmapIntegerScale());
+	filterChain = new FilterChain(this);
+
 	null=new (unaccountedMemory) Null;
 	null->setSystemState(this);
 	null->setWorker(this->worker);
@@ -569,6 +643,13 @@ void SystemState::stopEngines()
 	/* first shutdown the vm, because it can use all the others */
 	if(currentVm)
 		currentVm->shutdown();
+	delete samplingProfiler;
+	samplingProfiler=nullptr;
+	if(!traceOutput.empty())
+	{
+		Tracer::stop();
+		Tracer::save(traceOutput);
+	}
 	delete downloadManager;
 	downloadManager=nullptr;
 	delete securityManager;
@@ -581,6 +662,8 @@ void SystemState::stopEngines()
 	threadPool=nullptr;
 	delete downloadThreadPool;
 	downloadThreadPool=nullptr;
+	delete benchmarkRunner;
+	benchmarkRunner=nullptr;
 	//Now stop the managers
 	delete audioManager;
 	audioManager=nullptr;
@@ -646,6 +729,13 @@ void SystemState::systemFinalize()
 	parameters.reset();
 	static_SoundMixer_soundTransform.reset();
 	frameListeners.clear();
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+		broadcastListeners[i].clear();
+	advanceFrameEvent.reset();
+	initFrameEvent.reset();
+	executeFrameScriptEvent.reset();
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+		broadcastEvents[i].reset();
 	auto it = sharedobjectmap.begin();
 	while (it != sharedobjectmap.end())
 	{
@@ -684,6 +774,8 @@ SystemState::~SystemState()
 	{
 		delete (*it);
 	}
+	delete cachedSurfaceManager;
+	delete filterChain;
 #ifndef NDEBUG
 	for (auto it = memcheckset.begin(); it != memcheckset.end(); it++)
 	{
@@ -1225,10 +1317,46 @@ void SystemState::setRenderRate(float rate)
 	if (this->mainClip && this->mainClip->isConstructed())
 	{
 		removeJob(this);
-		addTick(1000/renderRate,this);
+		startFrameTicks(1000/renderRate);
 	}
 }
 
+void SystemState::startFrameTicks(uint32_t interval)
+{
+	// in benchmark mode the frames are not driven by the timer
+	if(benchmarkRunner)
+		benchmarkRunner->startFrames(interval);
+	else
+		addTick(interval,this);
+}
+
+uint64_t SystemState::getElapsedTime() const
+{
+	if(benchmarkRunner)
+		return benchmarkRunner->getVirtualTime();
+	return compat_msectiming() - startTime;
+}
+
+void SystemState::enableBenchmark(uint32_t frames, const tiny_string& inputScript)
+{
+	if(!benchmarkRunner)
+		benchmarkRunner=new BenchmarkRunner(this,frames,inputScript);
+}
+
+void SystemState::enableSamplingProfiler(int port, const tiny_string& outputFile, bool startRecording)
+{
+	if(!samplingProfiler)
+		samplingProfiler=new SamplingProfiler(this,port,outputFile);
+	if(startRecording)
+		samplingProfiler->start();
+}
+
+void SystemState::enableTracing(const tiny_string& outputFile)
+{
+	traceOutput=outputFile;
+	Tracer::start(this);
+}
+
 void SystemState::addJob(IThreadJob* j)
 {
 	threadPool->addJob(j);
@@ -2172,7 +2300,7 @@ void RootMovieClip::constructionComplete()
 	}
 	if (!loaderInfo.isNull())
 		loaderInfo->setComplete();
-	getSystemState()->addTick(1000/frameRate,getSystemState());
+	getSystemState()->startFrameTicks(1000/frameRate);
 }
 void RootMovieClip::afterConstruction()
 {
@@ -2320,6 +2448,7 @@ void SystemState::tick()
 	}
 	if(currentVm==nullptr)
 		return;
+	TraceSpan span("vm","tick");
 	/* See http://www.senocular.com/flash/tutorials/orderofoperations/
 	 * for the description of steps.
 	 */
@@ -2335,32 +2464,41 @@ void SystemState::tick()
 	{
 		/* Step 0: Set current frame number to the next frame 
 		 * Step 1: declare new objects */
-		_R<AdvanceFrameEvent> advFrame = _MR(new (unaccountedMemory) AdvanceFrameEvent());
-		currentVm->addEvent(NullRef, advFrame);
+		if (!isFrameEventReusable(advanceFrameEvent))
+			advanceFrameEvent = _MR(new (unaccountedMemory) AdvanceFrameEvent());
+		currentVm->addEvent(NullRef, advanceFrameEvent);
 	}
 
 	/* Step 2: Send enterFrame events, if needed */
-	addBroadcastEvent("enterFrame");
+	addBroadcastEvent(BROADCAST_ENTERFRAME);
 
 	/* Step 3: create legacy objects, which are new in this frame (top-down),
 	 * run their constructors (bottom-up) */
-	stage->incRef();
-	currentVm->addEvent(NullRef, _MR(new (unaccountedMemory) InitFrameEvent(_MR(stage))));
+	if (!isFrameEventReusable(initFrameEvent))
+	{
+		stage->incRef();
+		initFrameEvent = _MR(new (unaccountedMemory) InitFrameEvent(_MR(stage)));
+	}
+	currentVm->addEvent(NullRef, initFrameEvent);
 
 	/* Step 4: dispatch frameConstructed events */
-	addBroadcastEvent("frameConstructed");
+	addBroadcastEvent(BROADCAST_FRAMECONSTRUCTED);
 
 	/* Step 5: run all frameScripts (bottom-up) */
-	stage->incRef();
-	currentVm->addEvent(NullRef, _MR(new (unaccountedMemory) ExecuteFrameScriptEvent(_MR(stage))));
+	if (!isFrameEventReusable(executeFrameScriptEvent))
+	{
+		stage->incRef();
+		executeFrameScriptEvent = _MR(new (unaccountedMemory) ExecuteFrameScriptEvent(_MR(stage)));
+	}
+	currentVm->addEvent(NullRef, executeFrameScriptEvent);
 
 	/* Step 6: dispatch exitFrame event */
-	addBroadcastEvent("exitFrame");
+	addBroadcastEvent(BROADCAST_EXITFRAME);
 	/* Step 7: dispatch render event (Assuming stage.invalidate() has been called) */
 	if (stage->invalidated)
 	{
 		RELEASE_WRITE(stage->invalidated,false);
-		addBroadcastEvent("render");
+		addBroadcastEvent(BROADCAST_RENDER);
 	}
 
 	/* Step 9: we are idle now, so we can handle all input events */
@@ -50,6 +50,10 @@ class IntervalManager;
 class ParseThread;
 class PluginManager;
 class RenderThread;
+class SamplingProfiler;
+class BenchmarkRunner;
+class CachedSurfaceManager;
+class FilterChain;
 class SecurityManager;
 class LocaleManager;
 class CurrencyManager;
@@ -196,6 +200,9 @@ public:
 	void plot(uint32_t max, cairo_t *cr);
 };
 
+// broadcast events that are dispatched every frame
+enum BROADCAST_EVENT_TYPE { BROADCAST_ENTERFRAME=0, BROADCAST_FRAMECONSTRUCTED, BROADCAST_EXITFRAME, BROADCAST_RENDER, BROADCAST_EVENT_COUNT };
+
 class SystemState: public ITickJob, public InvalidateQueue
 {
 private:
@@ -274,7 +281,16 @@ private:
 	Mutex profileDataSpinlock;
 
 	Mutex mutexFrameListeners;
+	// all DisplayObjects that get broadcast events
 	std::set<DisplayObject*> frameListeners;
+	// DisplayObjects registered for every kind of per-frame broadcast event
+	std::set<DisplayObject*> broadcastListeners[BROADCAST_EVENT_COUNT];
+	// internal frame events are reused every frame, if they are not referenced by the event queue anymore
+	_NR<AdvanceFrameEvent> advanceFrameEvent;
+	_NR<InitFrameEvent> initFrameEvent;
+	_NR<ExecuteFrameScriptEvent> executeFrameScriptEvent;
+	// broadcast events are reused every frame, if they are not referenced by the event queue or actionscript anymore
+	_NR<Event> broadcastEvents[BROADCAST_EVENT_COUNT];
 	std::set<IFunction*> listenerfunctionlist;
 	/*
 	   The head of the invalidate queue
@@ -450,6 +466,30 @@ public:
 	void addWait(uint32_t waitTime, ITickJob* job);
 	void removeJob(ITickJob* job);
 
+	/*
+	 * The profiler for ActionScript code, nullptr if not enabled.
+	 * Recording can be toggled by SIGUSR1 or through the control socket on the given port.
+	 * The signal handlers are only installed once it is enabled
+	 */
+	SamplingProfiler* samplingProfiler;
+	void enableSamplingProfiler(int port, const tiny_string& outputFile, bool startRecording) DLL_PUBLIC;
+	// starts recording trace spans, they are written to outputFile on shutdown
+	void enableTracing(const tiny_string& outputFile) DLL_PUBLIC;
+	tiny_string traceOutput;
+	/*
+	 * Runs the given number of frames as fast as possible with a virtual clock, see BenchmarkRunner
+	 */
+	BenchmarkRunner* benchmarkRunner;
+	void enableBenchmark(uint32_t frames, const tiny_string& inputScript) DLL_PUBLIC;
+	// decides when the bitmaps of objects cached as bitmap are redrawn and limits their memory usage
+	CachedSurfaceManager* cachedSurfaceManager;
+	// applies the filters of objects cached as bitmap, keeps the scratch buffers between frames
+	FilterChain* filterChain;
+	// schedules the frame ticks of the main clip
+	void startFrameTicks(uint32_t interval);
+	// milliseconds since the start of the player, as returned by getTimer()
+	uint64_t getElapsedTime() const;
+
 	void setRenderRate(float rate);
 	float getRenderRate();
 
@@ -490,9 +530,14 @@ public:
 	bool staticSharedObjectPreventBackup;
 	
 	//broadcast event management
+	// registers clip for all per-frame broadcast events (used for AVM1)
 	void registerFrameListener(DisplayObject* clip);
 	void unregisterFrameListener(DisplayObject* clip);
+	void registerBroadcastListener(DisplayObject* clip, BROADCAST_EVENT_TYPE type);
+	void unregisterBroadcastListener(DisplayObject* clip, BROADCAST_EVENT_TYPE type);
+	static bool getBroadcastEventType(const tiny_string& event, BROADCAST_EVENT_TYPE& type);
 	void addBroadcastEvent(const tiny_string& event);
+	void addBroadcastEvent(BROADCAST_EVENT_TYPE type);
 
 	// keep track of event listener functions
 	void registerListenerFunction(IFunction* f);
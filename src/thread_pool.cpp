@@ -24,6 +24,7 @@
 #include "logger.h"
 #include "swf.h"
 #include "scripting/flash/system/flashsystem.h"
+#include "backends/tracing.h"
 
 using namespace lightspark;
 
@@ -82,6 +83,7 @@ int ThreadPool::job_worker(void *d)
 {
 	ThreadPoolData* data = (ThreadPoolData*)d;
 	setTLSSys(data->pool->m_sys);
+	Tracer::setThreadName("ThreadPool");
 
 	ThreadProfile* profile=data->pool->m_sys->allocateProfiler(RGB(200,200,0));
 	char buf[16];
@@ -107,7 +109,11 @@ int ThreadPool::job_worker(void *d)
 		{
 			// it's possible that a job was added and will be executed while forcestop() has been called
 			if(data->pool->stopFlag)
+			{
+				// still fence the job, someone may be waiting for it
+				myJob->jobFence();
 				return 0;
+			}
 			myJob->execute();
 		}
 		catch(JobTerminationException& ex)
@@ -23,6 +23,7 @@
 
 #include "timer.h"
 #include "compat.h"
+#include "backends/tracing.h"
 
 using namespace lightspark;
 using namespace std;
@@ -111,6 +112,7 @@ int TimerThread::worker(void *d)
 {
 	TimerThread* th = (TimerThread*)d;
 	setTLSSys(th->m_sys);
+	Tracer::setThreadName("TimerThread");
 
 	Locker l(th->mutex);
 	while(1)
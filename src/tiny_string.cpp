@@ -20,9 +20,93 @@
 #include "tiny_string.h"
 #include "exceptions.h"
 #include "swf.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace lightspark;
 
+namespace
+{
+
+// returns the first occurence of needle in the haystack, or nullptr
+const char* findBytes(const char* haystack, uint32_t len, const char* needle, uint32_t needlelen)
+{
+	if (needlelen == 0)
+		return haystack;
+	if (needlelen > len)
+		return nullptr;
+	if (needlelen == 1)
+		return (const char*)memchr(haystack,needle[0],len);
+	// number of positions the needle may start at
+	uint32_t count = len-needlelen+1;
+	uint32_t i = 0;
+#ifdef __SSE2__
+	// only the positions where the first and the last byte of the needle match are compared
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[needlelen-1]);
+	for (; i+16 <= count; i+=16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(haystack+i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(haystack+i+needlelen-1));
+		uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a,first),_mm_cmpeq_epi8(b,last)));
+		while (mask)
+		{
+			uint32_t j = i+__builtin_ctz(mask);
+			if (memcmp(haystack+j+1,needle+1,needlelen-2) == 0)
+				return haystack+j;
+			mask &= mask-1;
+		}
+	}
+#endif
+	while (i < count)
+	{
+		const char* p = (const char*)memchr(haystack+i,needle[0],count-i);
+		if (!p)
+			return nullptr;
+		if (memcmp(p+1,needle+1,needlelen-1) == 0)
+			return p;
+		i = p-haystack+1;
+	}
+	return nullptr;
+}
+
+// sets count to the number of ascii characters at the start of the next 16 bytes
+inline bool countASCII(const char* p, const char* end, uint32_t& count)
+{
+#ifdef __SSE2__
+	if (end-p >= 16)
+	{
+		uint32_t mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p));
+		count = mask ? __builtin_ctz(mask) : 16;
+		return count != 0;
+	}
+#endif
+	return false;
+}
+
+// copies len ascii bytes from src to dst, flipping the case of all characters in range first-last
+void mapASCIICase(char* dst, const char* src, uint32_t len, char first, char last)
+{
+	uint32_t i = 0;
+#ifdef __SSE2__
+	// the bytes are compared as signed values, this is fine as all of them are ascii
+	const __m128i lower = _mm_set1_epi8(first-1);
+	const __m128i upper = _mm_set1_epi8(last+1);
+	const __m128i casebit = _mm_set1_epi8(0x20);
+	for (; i+16 <= len; i+=16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i inrange = _mm_and_si128(_mm_cmpgt_epi8(v,lower),_mm_cmplt_epi8(v,upper));
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_xor_si128(v,_mm_and_si128(inrange,casebit)));
+	}
+#endif
+	for (; i < len; i++)
+		dst[i] = src[i] >= first && src[i] <= last ? src[i]^0x20 : src[i];
+}
+
+}
+
 tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(len+1),type(STATIC)
 {
 	if(stringSize > STATIC_SIZE)
@@ -127,8 +211,8 @@ tiny_string& tiny_string::operator+=(const char* s)
 		//don't copy trailing \0
 		memcpy(buf,_buf_static,stringSize-1);
 	}
-	else if(type==DYNAMIC && addedLen!=0)
-		resizeBuffer(newStringSize);
+	else if(type==DYNAMIC)
+		reserveBuffer(newStringSize);
 	//also copy \0 at the end
 	memcpy(buf+stringSize-1,s,addedLen+1);
 	stringSize=newStringSize;
@@ -150,8 +234,8 @@ tiny_string& tiny_string::operator+=(const tiny_string& r)
 		//don't copy trailing \0
 		memcpy(buf,_buf_static,stringSize-1);
 	}
-	else if(type==DYNAMIC && r.stringSize>1)
-		resizeBuffer(newStringSize);
+	else if(type==DYNAMIC)
+		reserveBuffer(newStringSize);
 	//start position is where the \0 was
 	memcpy(buf+stringSize-1,r.buf,r.stringSize);
 	stringSize=newStringSize;
@@ -290,35 +374,50 @@ bool tiny_string::endsWith(const char* o) const
  * returns index of character */
 uint32_t tiny_string::find(const tiny_string& needle, uint32_t start) const
 {
-	if (isASCII && !hasNull)
-	{
-		// fast path for ascii strings
-		const char* p = strstr(buf+start,needle.raw_buf());
-		return (p ? p-buf : npos);
-	}
-	//TODO: omit copy into std::string
-	size_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	size_t bytepos = std::string(*this).find(needle.raw_buf(),bytestart,needle.numBytes());
-	if(bytepos == std::string::npos)
+	if (start > numChars())
 		return npos;
-	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+	if (isASCII)
+		return find_bytes(needle,start);
+	uint32_t bytestart = indexToBytePos(start);
+	uint32_t bytepos = find_bytes(needle,bytestart);
+	if(bytepos == npos)
+		return npos;
+	return start+utf8Count(buf+bytestart,bytepos-bytestart);
 }
 
 uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
 {
-	//TODO: omit copy into std::string
-	size_t bytestart;
-	if(start == npos)
-		bytestart = std::string::npos;
-	else
-		bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	uint32_t bytepos = rfind_bytes(needle,start >= numChars() ? npos : indexToBytePos(start));
+	if(bytepos == npos)
+		return npos;
+	return bytePosToIndex(bytepos);
+}
 
-	size_t bytepos = std::string(*this).rfind(needle.raw_buf(),bytestart,needle.numBytes());
-	if(bytepos == std::string::npos)
+uint32_t tiny_string::find_bytes(const tiny_string& needle, uint32_t bytestart) const
+{
+	if (bytestart > numBytes())
 		return npos;
-	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+	const char* p = findBytes(buf+bytestart,numBytes()-bytestart,needle.raw_buf(),needle.numBytes());
+	return p ? p-buf : npos;
+}
+
+uint32_t tiny_string::rfind_bytes(const tiny_string& needle, uint32_t bytestart) const
+{
+	uint32_t needlelen = needle.numBytes();
+	if (needlelen > numBytes())
+		return npos;
+	uint32_t i = std::min(bytestart,numBytes()-needlelen);
+	if (needlelen == 0)
+		return i;
+	const char* n = needle.raw_buf();
+	while (true)
+	{
+		if (buf[i] == n[0] && memcmp(buf+i+1,n+1,needlelen-1) == 0)
+			return i;
+		if (i == 0)
+			return npos;
+		i--;
+	}
 }
 
 void tiny_string::makePrivateCopy(const char* s)
@@ -335,24 +434,33 @@ void tiny_string::createBuffer(uint32_t s)
 	type=DYNAMIC;
 	reportMemoryChange(s);
 	buf=new char[s];
+	capacity=s;
 }
 
 void tiny_string::resizeBuffer(uint32_t s)
 {
 	assert(type==DYNAMIC);
 	char* oldBuf=buf;
-	reportMemoryChange(s-stringSize);
+	reportMemoryChange(s-capacity);
 	buf=new char[s];
 	assert(s >= stringSize);
 	memcpy(buf,oldBuf,stringSize);
 	delete[] oldBuf;
+	capacity=s;
+}
+
+void tiny_string::reserveBuffer(uint32_t s)
+{
+	if(s <= capacity)
+		return;
+	resizeBuffer(std::max(s,uint32_t(std::min(uint64_t(capacity)*2,uint64_t(UINT32_MAX)))));
 }
 
 void tiny_string::resetToStatic()
 {
 	if(type==DYNAMIC)
 	{
-		reportMemoryChange(-stringSize);
+		reportMemoryChange(-capacity);
 		delete[] buf;
 	}
 	stringSize=1;
@@ -418,9 +526,8 @@ tiny_string& tiny_string::replace(uint32_t pos1, uint32_t n1, const tiny_string&
 		n1 = numChars()-pos1;
 	if (isASCII)
 		return replace_bytes(pos1, n1, o);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,pos1)-buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,pos1+n1)-buf;
-	return replace_bytes(bytestart, byteend-bytestart, o);
+	uint32_t bytestart = indexToBytePos(pos1);
+	return replace_bytes(bytestart, utf8Skip(buf+bytestart,numBytes()-bytestart,n1), o);
 }
 
 tiny_string& tiny_string::replace_bytes(uint32_t bytestart, uint32_t bytenum, const tiny_string& o)
@@ -456,9 +563,8 @@ tiny_string tiny_string::substr(uint32_t start, uint32_t len) const
 		len = numChars()-start;
 	if (isASCII)
 		return substr_bytes(start, len);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,start+len) - buf;
-	return substr_bytes(bytestart, byteend-bytestart);
+	uint32_t bytestart = indexToBytePos(start);
+	return substr_bytes(bytestart, utf8Skip(buf+bytestart,numBytes()-bytestart,len));
 }
 
 tiny_string tiny_string::substr(uint32_t start, const CharIterator& end) const
@@ -466,7 +572,7 @@ tiny_string tiny_string::substr(uint32_t start, const CharIterator& end) const
 	if (isASCII)
 		return substr_bytes(start, (end.buf_ptr - buf)-start);
 	assert_and_throw(start < numChars());
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	uint32_t bytestart = indexToBytePos(start);
 	uint32_t byteend = end.buf_ptr - buf;
 	return substr_bytes(bytestart, byteend-bytestart);
 }
@@ -477,20 +583,21 @@ std::list<tiny_string> tiny_string::split(uint32_t delimiter) const
 	uint32_t pos, end;
 	tiny_string delimiterstring = tiny_string::fromChar(delimiter);
 
+	// search on bytes, so every match doesn't have to be converted to a character index
 	pos = 0;
-	unsigned int len = numChars();
+	unsigned int len = numBytes();
 	while (pos < len)
 	{
-		end = find(delimiterstring, pos);
+		end = find_bytes(delimiterstring, pos);
 		if (end == tiny_string::npos)
 		{
-			res.push_back(substr(pos, len-pos));
+			res.push_back(substr_bytes(pos, len-pos));
 			break;
 		}
 		else
 		{
-			res.push_back(substr(pos, end-pos));
-			pos = end+1;
+			res.push_back(substr_bytes(pos, end-pos));
+			pos = end+delimiterstring.numBytes();
 		}
 	}
 	
@@ -1084,6 +1191,17 @@ tiny_string tiny_string::lowercase() const
 	// have to loop manually, because g_utf8_strdown doesn't
 	// handle nul-chars
 	tiny_string ret;
+	if (isASCII)
+	{
+		// the case maps only flip the case bit of ascii letters
+		if(stringSize > STATIC_SIZE)
+			ret.createBuffer(stringSize);
+		mapASCIICase(ret.buf,buf,stringSize,'A','Z');
+		ret.stringSize = stringSize;
+		ret.numchars = numchars;
+		ret.hasNull = hasNull;
+		return ret;
+	}
 	uint32_t allocated = 2*numBytes()+7;
 	ret.createBuffer(allocated);
 	char *p = ret.buf;
@@ -1106,6 +1224,17 @@ tiny_string tiny_string::uppercase() const
 	// have to loop manually, because g_utf8_strup doesn't
 	// handle nul-chars
 	tiny_string ret;
+	if (isASCII)
+	{
+		// the case maps only flip the case bit of ascii letters
+		if(stringSize > STATIC_SIZE)
+			ret.createBuffer(stringSize);
+		mapASCIICase(ret.buf,buf,stringSize,'a','z');
+		ret.stringSize = stringSize;
+		ret.numchars = numchars;
+		ret.hasNull = hasNull;
+		return ret;
+	}
 	uint32_t allocated = 2*numBytes()+7;
 	ret.createBuffer(allocated);
 	char *p = ret.buf;
@@ -1142,7 +1271,54 @@ uint32_t tiny_string::bytePosToIndex(uint32_t bytepos) const
 	if (isASCII)
 		return bytepos;
 
-	return g_utf8_pointer_to_offset(raw_buf(), raw_buf() + bytepos);
+	return utf8Count(buf,bytepos);
+}
+
+uint32_t tiny_string::indexToBytePos(uint32_t index) const
+{
+	if (isASCII)
+		return std::min(index,numBytes());
+	return utf8Skip(buf,numBytes(),index);
+}
+
+uint32_t tiny_string::utf8Skip(const char* s, uint32_t len, uint32_t count)
+{
+	const char* p = s;
+	const char* end = s+len;
+	while (count && p < end)
+	{
+		uint32_t n;
+		if (countASCII(p,end,n))
+		{
+			n = std::min(n,count);
+			p += n;
+			count -= n;
+			continue;
+		}
+		p = g_utf8_next_char(p);
+		count--;
+	}
+	return std::min(p,end)-s;
+}
+
+uint32_t tiny_string::utf8Count(const char* s, uint32_t len)
+{
+	const char* p = s;
+	const char* end = s+len;
+	uint32_t count = 0;
+	while (p < end)
+	{
+		uint32_t n;
+		if (countASCII(p,end,n))
+		{
+			p += n;
+			count += n;
+			continue;
+		}
+		p = g_utf8_next_char(p);
+		count++;
+	}
+	return count;
 }
 
 CharIterator tiny_string::begin()
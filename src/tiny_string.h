@@ -98,6 +98,8 @@ private:
 	   stringSize includes the trailing \0
 	*/
 	uint32_t stringSize;
+	// size of buf if type is DYNAMIC, may be larger than stringSize
+	uint32_t capacity;
 	uint32_t numchars;
 	TYPE type;
 #ifdef MEMORY_USAGE_PROFILING
@@ -111,6 +113,8 @@ private:
 	void makePrivateCopy(const char* s);
 	void createBuffer(uint32_t s);
 	void resizeBuffer(uint32_t s);
+	// makes room for s bytes when appending, the buffer grows exponentially so that repeated appends take linear time
+	void reserveBuffer(uint32_t s);
 	void resetToStatic();
 	void init();
 	bool isASCII:1;
@@ -202,12 +206,16 @@ public:
 	{
 		if (isASCII)
 			return buf[idx];
-		return g_utf8_get_char(g_utf8_offset_to_pointer(buf,idx));
+		return g_utf8_get_char(buf+indexToBytePos(idx));
 	}
 	/* start is an index of characters.
 	 * returns index of character */
 	uint32_t find(const tiny_string& needle, uint32_t start = 0) const;
 	uint32_t rfind(const tiny_string& needle, uint32_t start = npos) const;
+	/* bytestart is an index of bytes.
+	 * returns index of byte */
+	uint32_t find_bytes(const tiny_string& needle, uint32_t bytestart = 0) const;
+	uint32_t rfind_bytes(const tiny_string& needle, uint32_t bytestart = npos) const;
 	tiny_string& replace(uint32_t pos1, uint32_t n1, const tiny_string& o);
 	tiny_string& replace_bytes(uint32_t bytestart, uint32_t bytenum, const tiny_string& o);
 	tiny_string lowercase() const;
@@ -218,6 +226,12 @@ public:
 	std::list<tiny_string> split(uint32_t delimiter) const;
 	/* Convert from byte offset to UTF-8 character index */
 	uint32_t bytePosToIndex(uint32_t bytepos) const;
+	/* Convert from UTF-8 character index to byte offset */
+	uint32_t indexToBytePos(uint32_t index) const;
+	/* number of bytes taken by the first count UTF-8 characters of s, at most len */
+	static uint32_t utf8Skip(const char* s, uint32_t len, uint32_t count);
+	/* number of UTF-8 characters starting in the first len bytes of s */
+	static uint32_t utf8Count(const char* s, uint32_t len);
 	/* iterate over utf8 characters */
 	CharIterator begin();
 	CharIterator begin() const;